@@ -0,0 +1,165 @@
+// bench_http_parser.c
+// HTTP请求解析吞吐量：增量解析器（0_http_parser.h） vs 每次从头重新查找空行的朴素做法
+// 编译: gcc -std=gnu11 -O2 -I../serverModel bench_http_parser.c -o bench_http_parser
+// 运行: ./bench_http_parser [每项MB数]
+// 说明:
+//  - small-get   : 单个短GET（约80字节，压测工具的典型请求）
+//  - browser-get : 单个浏览器风格的GET（十几个头部，约700字节）
+//  - pipelined   : 64个请求（GET与带256字节主体的POST交替）放在一个缓冲区中，逐个解析
+//  - 分批喂入（feed）：整块 / 每次64字节 / 每次1字节，模拟请求被拆成多次读入；
+//    每批到达后调用一次解析，增量解析器从上次扫描到的位置继续，朴素做法每次从请求开头重新memmem
+//  - 朴素做法只找头部结束位置，不解析头部，所以整块喂入时它的开销偏低；分批喂入时它是O(n^2)
+//  - MB/s 按请求字节数计算，req/s 为每秒解析完成的请求数
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "0_http_parser.h"
+
+#define DEFAULT_MB 256
+#define PIPELINE_DEPTH 64
+#define POST_BODY_SIZE 256
+
+static const char SMALL_GET[] =
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: 127.0.0.1:8080\r\n"
+    "User-Agent: wrk\r\n"
+    "Accept: */*\r\n"
+    "\r\n";
+
+static const char BROWSER_GET[] =
+    "GET /api/v1/items?page=3&sort=desc HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "Connection: keep-alive\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "sec-ch-ua: \"Chromium\";v=\"118\", \"Not=A?Brand\";v=\"99\"\r\n"
+    "sec-ch-ua-mobile: ?0\r\n"
+    "sec-ch-ua-platform: \"Linux\"\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) "
+    "Chrome/118.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "Sec-Fetch-Mode: navigate\r\n"
+    "Sec-Fetch-Dest: document\r\n"
+    "Referer: https://www.example.com/items\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: en-US,en;q=0.9,zh-CN;q=0.8\r\n"
+    "Cookie: session=8f2c1e9a7b6d4c3e; theme=dark; _ga=GA1.2.1234567890.1697000000\r\n"
+    "\r\n";
+
+static volatile size_t g_sink;  // 防止解析结果被优化掉
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// ====================== 对照：每次从头查找空行 ======================
+typedef struct naive_parser {
+    size_t content_length;
+    size_t header_len;          // 0表示头部还没到齐
+} naive_parser_t;
+
+static ssize_t naive_execute(naive_parser_t* p, const char* data, size_t len) {
+    if (p->header_len == 0) {
+        const char* end = (const char*)memmem(data, len, "\r\n\r\n", 4);
+        if (!end) return 0;
+        p->header_len = (size_t)(end - data) + 4;
+        const char* cl = (const char*)memmem(data, p->header_len, "Content-Length:", 15);
+        p->content_length = cl ? strtoul(cl + 15, NULL, 10) : 0;
+    }
+    size_t total = p->header_len + p->content_length;
+    return len >= total ? (ssize_t)total : 0;
+}
+
+// ====================== 测试 ======================
+/**
+ * @brief 解析 buf 中的全部请求，数据每次到达 feed 字节（0表示一次全部到达）
+ * @return 解析出的请求数
+ */
+static size_t parse_all(int incremental, const char* buf, size_t len, size_t feed) {
+    http_parser_t parser;
+    naive_parser_t naive = {0, 0};
+    size_t start = 0, avail = 0, count = 0;
+    http_parser_init(&parser, 0);
+    while (start < len) {
+        if (avail < len) avail = feed == 0 || avail + feed > len ? len : avail + feed;
+        ssize_t n;
+        while ((n = incremental ? http_parser_execute(&parser, buf + start, avail - start) :
+                                  naive_execute(&naive, buf + start, avail - start)) > 0) {
+            g_sink += incremental ? (size_t)parser.req.num_headers : naive.header_len;
+            start += (size_t)n;
+            count++;
+            http_parser_reset(&parser);
+            naive.header_len = 0;
+            if (start == avail) break;
+        }
+        if (n < 0) {
+            fprintf(stderr, "parse error %d\n", parser.error);
+            exit(EXIT_FAILURE);
+        }
+    }
+    return count;
+}
+
+static void run_case(const char* name, const char* buf, size_t len, size_t feed, size_t total) {
+    size_t rounds = total / len ? total / len : 1;
+    if (feed == 1) rounds = rounds / 16 ? rounds / 16 : 1; // 逐字节喂入很慢，缩小数据量
+    double mbps[2], rps[2];
+    for (int inc = 0; inc < 2; inc++) {
+        size_t reqs = 0;
+        uint64_t start = now_ns();
+        for (size_t r = 0; r < rounds; r++) reqs += parse_all(inc, buf, len, feed);
+        double sec = (double)(now_ns() - start) / 1e9;
+        mbps[inc] = (double)len * rounds / sec / (1024.0 * 1024.0);
+        rps[inc] = reqs / sec;
+    }
+    char feed_name[32];
+    if (feed == 0) snprintf(feed_name, sizeof(feed_name), "whole");
+    else snprintf(feed_name, sizeof(feed_name), "%zu B", feed);
+    printf("%-12s %-6s %11.1f %11.0f %11.1f %11.0f %8.1fx\n",
+           name, feed_name, mbps[1], rps[1], mbps[0], rps[0], mbps[1] / mbps[0]);
+    fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+    size_t mb = argc >= 2 ? strtoul(argv[1], NULL, 10) : DEFAULT_MB;
+    if (mb == 0) mb = DEFAULT_MB;
+    size_t total = mb << 20;
+
+    // 流水线：GET 与 POST 交替
+    char post[512];
+    int post_head = snprintf(post, sizeof(post),
+                             "POST /submit HTTP/1.1\r\nHost: 127.0.0.1:8080\r\n"
+                             "Content-Type: application/octet-stream\r\nContent-Length: %d\r\n\r\n",
+                             POST_BODY_SIZE);
+    memset(post + post_head, 'x', POST_BODY_SIZE);
+    size_t post_len = (size_t)post_head + POST_BODY_SIZE;
+    size_t get_len = sizeof(SMALL_GET) - 1;
+    char* pipeline = (char*)malloc(PIPELINE_DEPTH * (get_len + post_len));
+    size_t pipeline_len = 0;
+    for (int i = 0; i < PIPELINE_DEPTH; i++) {
+        const char* src = i % 2 ? post : SMALL_GET;
+        size_t n = i % 2 ? post_len : get_len;
+        memcpy(pipeline + pipeline_len, src, n);
+        pipeline_len += n;
+    }
+
+    printf("%zu MB per case (1 B feed: %zu MB)\n", mb, mb / 16);
+    printf("\n%-12s %-6s %11s %11s %11s %11s %9s\n",
+           "case", "feed", "inc MB/s", "inc req/s", "naive MB/s", "naive req/s", "inc/naive");
+
+    static const size_t feeds[] = {0, 64, 1};
+    for (size_t f = 0; f < sizeof(feeds) / sizeof(feeds[0]); f++) {
+        run_case("small-get", SMALL_GET, get_len, feeds[f], total);
+        run_case("browser-get", BROWSER_GET, sizeof(BROWSER_GET) - 1, feeds[f], total);
+        run_case("pipelined", pipeline, pipeline_len, feeds[f], total);
+    }
+    free(pipeline);
+    return 0;
+}
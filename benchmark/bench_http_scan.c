@@ -0,0 +1,200 @@
+// bench_http_scan.c
+// HTTP请求扫描内核对比：标量 / SSE4.2 / AVX2（0_http_scan.h），以及整个请求头的解析（0_http_parser.h）
+// 编译: gcc -std=gnu11 -O2 -I../serverModel bench_http_scan.c -o bench_http_scan
+// 运行: ./bench_http_scan [每项迭代次数]
+// 说明:
+//  - 请求头样本：
+//      short-get    : 压测工具的短GET（4个头部，约80字节）
+//      browser-get  : 浏览器导航请求（16个头部，约900字节）
+//      large-cookie : 浏览器请求 + 约4KB的Cookie（长头部值，边界扫描占主导）
+//      api-post     : 网关转发的API请求（24个短头部，头部名扫描和比较占比高）
+//  - boundary: 只找头部结束的空行（请求边界），GB/s 按请求头字节数计算
+//  - token   : 逐行扫描方法名和所有头部名（停在':'），ns 为每个请求的耗时
+//  - parse   : 完整解析（边界 + 请求行 + 头部 + 三个特殊头部的匹配），ns/req 与 MB/s
+//  - 开始前检查每一档的解析结果与标量实现一致；CPU不支持的档位跳过
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "0_http_parser.h"
+
+#define DEFAULT_ITERATIONS 200000
+#define COOKIE_SIZE 4000
+
+static const char SHORT_GET[] =
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: 127.0.0.1:8080\r\n"
+    "User-Agent: wrk\r\n"
+    "Accept: */*\r\n"
+    "\r\n";
+
+#define BROWSER_HEADERS \
+    "Host: www.example.com\r\n" \
+    "Connection: keep-alive\r\n" \
+    "Cache-Control: max-age=0\r\n" \
+    "sec-ch-ua: \"Chromium\";v=\"118\", \"Not=A?Brand\";v=\"99\"\r\n" \
+    "sec-ch-ua-mobile: ?0\r\n" \
+    "sec-ch-ua-platform: \"Linux\"\r\n" \
+    "Upgrade-Insecure-Requests: 1\r\n" \
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) " \
+    "Chrome/118.0.0.0 Safari/537.36\r\n" \
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n" \
+    "Sec-Fetch-Site: same-origin\r\n" \
+    "Sec-Fetch-Mode: navigate\r\n" \
+    "Sec-Fetch-User: ?1\r\n" \
+    "Sec-Fetch-Dest: document\r\n" \
+    "Referer: https://www.example.com/items\r\n" \
+    "Accept-Encoding: gzip, deflate, br\r\n" \
+    "Accept-Language: en-US,en;q=0.9,zh-CN;q=0.8\r\n"
+
+static const char BROWSER_GET[] =
+    "GET /api/v1/items?page=3&sort=desc HTTP/1.1\r\n"
+    BROWSER_HEADERS
+    "\r\n";
+
+static const char API_POST[] =
+    "POST /v2/orders HTTP/1.1\r\n"
+    "Host: api.internal\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: 0\r\n"
+    "Accept: application/json\r\n"
+    "Authorization: Bearer abcdef0123456789\r\n"
+    "X-Request-Id: 4bf92f3577b34da6\r\n"
+    "X-Forwarded-For: 10.0.0.1, 10.0.0.2\r\n"
+    "X-Forwarded-Proto: https\r\n"
+    "X-Forwarded-Port: 443\r\n"
+    "X-Real-IP: 10.0.0.1\r\n"
+    "Via: 1.1 gateway\r\n"
+    "Traceparent: 00-4bf92f3577b34da6-00f067aa0ba902b7-01\r\n"
+    "Tracestate: rojo=00f067aa0ba902b7\r\n"
+    "X-B3-TraceId: 4bf92f3577b34da6\r\n"
+    "X-B3-SpanId: 00f067aa0ba902b7\r\n"
+    "X-B3-Sampled: 1\r\n"
+    "X-Tenant: acme\r\n"
+    "X-Client-Version: 5.2.1\r\n"
+    "X-Device: ios\r\n"
+    "Accept-Encoding: gzip\r\n"
+    "Accept-Language: en\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Pragma: no-cache\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+
+static volatile size_t g_sink;  // 防止结果被优化掉
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// ====================== 测试 ======================
+typedef struct sample {
+    const char* name;
+    char* data;
+    size_t len;
+    int num_headers;            // 标量实现的解析结果（用于校验）
+} sample_t;
+
+static ssize_t parse_once(const sample_t* s, http_parser_t* parser) {
+    http_parser_reset(parser);
+    return http_parser_execute(parser, s->data, s->len);
+}
+
+/**
+ * @brief 逐行扫描方法名和头部名（与解析器中的用法相同：从行首扫描到第一个非token字节）
+ */
+static size_t scan_names(const char* data, size_t len) {
+    size_t sum = 0;
+    for (size_t pos = 0; pos < len;) {
+        const char* nl = (const char*)memchr(data + pos, '\n', len - pos);
+        size_t end = nl ? (size_t)(nl - data) : len;
+        sum += http_scan_token(data, pos, end) - pos;
+        pos = end + 1;
+    }
+    return sum;
+}
+
+static void run_sample(const sample_t* s, int level, size_t iterations, double* scalar_parse_ns) {
+    http_parser_t parser;
+    http_parser_init(&parser, 0);
+    size_t resume;
+
+    uint64_t t0 = now_ns();
+    for (size_t i = 0; i < iterations; i++) g_sink += http_scan_header_end(s->data, 0, s->len, &resume);
+    double boundary_ns = (double)(now_ns() - t0) / iterations;
+
+    t0 = now_ns();
+    for (size_t i = 0; i < iterations; i++) g_sink += scan_names(s->data, s->len);
+    double token_ns = (double)(now_ns() - t0) / iterations;
+
+    t0 = now_ns();
+    for (size_t i = 0; i < iterations; i++) g_sink += (size_t)parse_once(s, &parser);
+    double parse_ns = (double)(now_ns() - t0) / iterations;
+
+    if (level == HTTP_SCAN_SCALAR) *scalar_parse_ns = parse_ns;
+    printf("%-13s %-7s %12.2f %10.1f %10.1f %10.1f %8.2fx\n",
+           s->name, http_scan_level_name(level), s->len / boundary_ns, token_ns, parse_ns,
+           s->len / parse_ns * 1e9 / (1024.0 * 1024.0), *scalar_parse_ns / parse_ns);
+    fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+    size_t iterations = argc >= 2 ? strtoul(argv[1], NULL, 10) : DEFAULT_ITERATIONS;
+    if (iterations == 0) iterations = DEFAULT_ITERATIONS;
+
+    // 大Cookie：浏览器请求加上多个 name=value 组成的长Cookie
+    char* cookie_get = (char*)malloc(sizeof(BROWSER_GET) + COOKIE_SIZE + 64);
+    size_t n = (size_t)sprintf(cookie_get, "GET /account HTTP/1.1\r\n" BROWSER_HEADERS "Cookie: ");
+    for (int k = 0; n < sizeof(BROWSER_GET) + COOKIE_SIZE; k++) {
+        n += (size_t)sprintf(cookie_get + n, "%sc%d=%016llx", k ? "; " : "", k,
+                             (unsigned long long)k * 0x9e3779b97f4a7c15ull);
+    }
+    n += (size_t)sprintf(cookie_get + n, "\r\n\r\n");
+
+    sample_t samples[] = {
+        {"short-get", (char*)SHORT_GET, sizeof(SHORT_GET) - 1, 0},
+        {"browser-get", (char*)BROWSER_GET, sizeof(BROWSER_GET) - 1, 0},
+        {"large-cookie", cookie_get, n, 0},
+        {"api-post", (char*)API_POST, sizeof(API_POST) - 1, 0},
+    };
+    size_t num_samples = sizeof(samples) / sizeof(samples[0]);
+    int best = http_scan_best_level();
+
+    // 校验：每一档的解析结果与标量实现一致
+    http_parser_t parser;
+    http_parser_init(&parser, 0);
+    for (int level = HTTP_SCAN_SCALAR; level <= best; level++) {
+        http_scan_select(level);
+        for (size_t i = 0; i < num_samples; i++) {
+            ssize_t total = parse_once(&samples[i], &parser);
+            if (total != (ssize_t)samples[i].len) {
+                fprintf(stderr, "%s: parse failed at level %s (%zd, error %d)\n", samples[i].name,
+                        http_scan_level_name(level), total, parser.error);
+                return 1;
+            }
+            if (level == HTTP_SCAN_SCALAR) samples[i].num_headers = parser.req.num_headers;
+            if (parser.req.num_headers != samples[i].num_headers) {
+                fprintf(stderr, "%s: level %s found %d headers, scalar %d\n", samples[i].name,
+                        http_scan_level_name(level), parser.req.num_headers, samples[i].num_headers);
+                return 1;
+            }
+        }
+    }
+
+    printf("iterations: %zu, best level: %s\n", iterations, http_scan_level_name(best));
+    printf("\n%-13s %-7s %12s %10s %10s %10s %9s\n",
+           "sample", "level", "bound GB/s", "token ns", "parse ns", "parse MB/s", "vs scalar");
+    for (size_t i = 0; i < num_samples; i++) {
+        double scalar_parse_ns = 0;
+        for (int level = HTTP_SCAN_SCALAR; level <= best; level++) {
+            http_scan_select(level);
+            run_sample(&samples[i], level, iterations, &scalar_parse_ns);
+        }
+    }
+    free(cookie_get);
+    return 0;
+}
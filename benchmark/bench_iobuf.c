@@ -0,0 +1,183 @@
+// bench_iobuf.c
+// 连接写缓冲区对比：线性缓冲区 + 部分写后memmove（原实现，改为可增长） vs 环形缓冲区 + writev（0_iobuf.h）
+// 编译: gcc -std=gnu11 -O2 -I../serverModel bench_iobuf.c -o bench_iobuf -pthread
+// 运行: ./bench_iobuf [每项MB数] [积压上限KB]
+// 说明:
+//  - socketpair 一端由写线程以非阻塞方式写（发送缓冲区调小，制造大量部分写），另一端由读线程阻塞读
+//  - 写线程模拟事件循环：待发送数据少于积压上限时继续追加响应（流水线），然后发起一次写，EAGAIN时poll等待可写
+//  - pipelined-*: 读端每次读64KB（快速读者），响应大小 16KB / 256KB
+//  - slow-reader: 读端每次只读1KB，每次部分写都只写出很少的数据，而积压很大
+//  - memmove: 线性缓冲区在部分写之后搬移的字节数（环形缓冲区为0）
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "0_iobuf.h"
+
+#define DEFAULT_MB 128
+#define DEFAULT_BACKLOG_KB 4096
+#define SOCKET_BUFFER 65536
+
+// ====================== 基准实现：线性缓冲区 + memmove ======================
+typedef struct linear_buf {
+    char* data;
+    size_t size;
+    size_t cap;
+    uint64_t moved;             // memmove搬移的字节数
+} linear_buf_t;
+
+static int linear_append(linear_buf_t* b, const char* src, size_t len) {
+    if (b->size + len > b->cap) {
+        size_t cap = b->cap ? b->cap : 4096;
+        while (cap < b->size + len) cap <<= 1;
+        char* data = (char*)realloc(b->data, cap);
+        if (!data) return -1;
+        b->data = data;
+        b->cap = cap;
+    }
+    memcpy(b->data + b->size, src, len);
+    b->size += len;
+    return 0;
+}
+
+static ssize_t linear_write(linear_buf_t* b, int fd) {
+    ssize_t n = write(fd, b->data, b->size);
+    if (n > 0) {
+        b->size -= (size_t)n;
+        if (b->size > 0) {
+            memmove(b->data, b->data + n, b->size); // 原 write_handler 的做法
+            b->moved += b->size;
+        }
+    }
+    return n;
+}
+
+// ====================== 测试 ======================
+typedef struct reader_ctx {
+    int fd;
+    size_t chunk;
+    size_t expect;
+    size_t received;
+} reader_ctx_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void* reader_main(void* arg) {
+    reader_ctx_t* r = (reader_ctx_t*)arg;
+    char* buf = (char*)malloc(r->chunk);
+    while (buf && r->received < r->expect) {
+        ssize_t n = read(r->fd, buf, r->chunk);
+        if (n <= 0) break;
+        r->received += (size_t)n;
+    }
+    free(buf);
+    return NULL;
+}
+
+static void run_case(const char* name, int use_ring, size_t msg_size, size_t read_chunk,
+                     size_t total, size_t backlog) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+        perror("socketpair");
+        exit(EXIT_FAILURE);
+    }
+    int sz = SOCKET_BUFFER;
+    setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &sz, sizeof(sz));
+    setsockopt(sv[1], SOL_SOCKET, SO_RCVBUF, &sz, sizeof(sz));
+    fcntl(sv[0], F_SETFL, fcntl(sv[0], F_GETFL, 0) | O_NONBLOCK);
+
+    char* msg = (char*)malloc(msg_size);
+    memset(msg, 'x', msg_size);
+    total = total / msg_size * msg_size;
+    reader_ctx_t reader = {sv[1], read_chunk, total, 0};
+    pthread_t tid;
+    pthread_create(&tid, NULL, reader_main, &reader);
+
+    linear_buf_t lin = {NULL, 0, 0, 0};
+    iobuf_t ring;
+    iobuf_init(&ring, 4096, backlog + msg_size);
+    uint64_t writes = 0, waits = 0;
+    size_t produced = 0;
+
+    uint64_t start = now_ns();
+    for (;;) {
+        size_t pending = use_ring ? iobuf_size(&ring) : lin.size;
+        while (produced < total && pending < backlog) {
+            if (use_ring) iobuf_append(&ring, msg, msg_size);
+            else linear_append(&lin, msg, msg_size);
+            produced += msg_size;
+            pending += msg_size;
+        }
+        if (pending == 0) break;
+        ssize_t n = use_ring ? iobuf_write_fd(&ring, sv[0]) : linear_write(&lin, sv[0]);
+        writes++;
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("write");
+                break;
+            }
+            struct pollfd pfd = {sv[0], POLLOUT, 0};
+            poll(&pfd, 1, -1);
+            waits++;
+        }
+    }
+    pthread_join(tid, NULL);
+    double sec = (double)(now_ns() - start) / 1e9;
+
+    printf("%-16s %-7s %10.1f %10llu %12.0f %12.1f%s\n",
+           name, use_ring ? "ring" : "linear",
+           reader.received / sec / (1024.0 * 1024.0),
+           (unsigned long long)writes,
+           writes ? (double)reader.received / (writes - waits) : 0.0,
+           lin.moved / (1024.0 * 1024.0),
+           reader.received == total ? "" : "  (short read)");
+    fflush(stdout);
+
+    free(lin.data);
+    iobuf_free(&ring);
+    free(msg);
+    close(sv[0]);
+    close(sv[1]);
+}
+
+int main(int argc, char* argv[]) {
+    size_t mb = argc >= 2 ? strtoul(argv[1], NULL, 10) : DEFAULT_MB;
+    size_t backlog_kb = argc >= 3 ? strtoul(argv[2], NULL, 10) : DEFAULT_BACKLOG_KB;
+    if (mb == 0) mb = DEFAULT_MB;
+    if (backlog_kb == 0) backlog_kb = DEFAULT_BACKLOG_KB;
+    size_t total = mb << 20;
+    size_t backlog = backlog_kb << 10;
+
+    printf("%zu MB per case, backlog limit %zu KB, socket buffer %d B\n", mb, backlog_kb, SOCKET_BUFFER);
+    printf("\n%-16s %-7s %10s %10s %12s %12s\n", "case", "buffer", "MB/s", "writes", "bytes/write", "memmove MB");
+
+    static const struct {
+        const char* name;
+        size_t msg_size;
+        size_t read_chunk;
+        size_t divisor;         // 慢速读者的数据量缩小，避免线性缓冲区耗时过长
+    } cases[] = {
+        {"pipelined-16K", 16 << 10, 64 << 10, 1},
+        {"pipelined-256K", 256 << 10, 64 << 10, 1},
+        {"slow-reader", 64 << 10, 1 << 10, 8},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        size_t bytes = total / cases[i].divisor;
+        run_case(cases[i].name, 0, cases[i].msg_size, cases[i].read_chunk, bytes, backlog);
+        run_case(cases[i].name, 1, cases[i].msg_size, cases[i].read_chunk, bytes, backlog);
+    }
+    return 0;
+}
@@ -0,0 +1,223 @@
+// bench_numa.c
+// NUMA放置对比：连接缓冲区由Reactor线程分配（可能在远端节点） vs 由处理它的worker首次写入（本节点）
+// 编译: gcc -std=gnu11 -O2 -I../serverModel bench_numa.c -o bench_numa -pthread
+// 运行: ./bench_numa [缓冲区数] [每个缓冲区KB] [每个缓冲区处理轮数]
+// 说明:
+//  - remote : 主线程绑定在第一个节点上分配并写入缓冲区，交给最后一个节点上的线程池处理（跨节点访问）
+//  - local  : 同一个线程池，缓冲区由worker自己分配并首次写入（本节点访问）
+//  - unbound: 不绑核的线程池，缓冲区由主线程分配（原实现）
+//  - 每种场景统计处理阶段的吞吐（MB/s），并查询缓冲区物理页实际所在的节点
+//  - 机器只有一个NUMA节点时三种场景没有差别
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include "0_threadpool.h"
+
+#define DEFAULT_BUFFERS 256
+#define DEFAULT_BUFFER_KB 256
+#define DEFAULT_ROUNDS 20
+#define MPOL_F_NODE_FLAG (1 << 0)   // 与 <linux/mempolicy.h> 的 MPOL_F_NODE 一致
+#define MPOL_F_ADDR_FLAG (1 << 1)   // 与 <linux/mempolicy.h> 的 MPOL_F_ADDR 一致
+
+typedef struct bench_ctx {
+    char** buffers;
+    size_t buffer_size;
+    int rounds;
+    int alloc_phase;            // 1：本轮任务只分配缓冲区（不计时）
+    int done;                   // 已完成任务数（原子访问）
+    uint64_t checksum;          // 防止编译器优化掉访问（原子访问）
+} bench_ctx_t;
+
+typedef struct bench_job {
+    bench_ctx_t* ctx;
+    int index;
+} bench_job_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief 查询地址所在的NUMA节点
+ * @return 节点编号，失败返回-1
+ */
+static int page_node(void* addr) {
+    int node = -1;
+    if (syscall(SYS_get_mempolicy, &node, NULL, 0UL, addr, (unsigned long)(MPOL_F_NODE_FLAG | MPOL_F_ADDR_FLAG)) != 0) {
+        return -1;
+    }
+    return node;
+}
+
+/**
+ * @brief 分配缓冲区并写满（首次触碰决定物理页所在节点）
+ */
+static char* buffer_alloc_touch(size_t size) {
+    char* buf = (char*)malloc(size);
+    if (buf) memset(buf, 1, size);
+    return buf;
+}
+
+/**
+ * @brief worker任务：分配阶段只分配并写入缓冲区，处理阶段多轮读改写
+ */
+static void process_job(void* arg) {
+    bench_job_t* job = (bench_job_t*)arg;
+    bench_ctx_t* ctx = job->ctx;
+    if (ctx->alloc_phase) {
+        ctx->buffers[job->index] = buffer_alloc_touch(ctx->buffer_size);
+        __atomic_add_fetch(&ctx->done, 1, __ATOMIC_RELEASE);
+        return;
+    }
+    uint64_t* words = (uint64_t*)ctx->buffers[job->index];
+    size_t n = ctx->buffer_size / sizeof(uint64_t);
+    uint64_t sum = 0;
+    for (int r = 0; r < ctx->rounds; r++) {
+        for (size_t i = 0; i < n; i++) {
+            sum += words[i];
+            words[i] = sum;
+        }
+    }
+    __atomic_add_fetch(&ctx->checksum, sum, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ctx->done, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief 提交一轮任务并等待全部完成
+ */
+static void run_jobs(thread_pool_t* pool, bench_ctx_t* ctx, bench_job_t* jobs, int n) {
+    __atomic_store_n(&ctx->done, 0, __ATOMIC_RELAXED);
+    for (int i = 0; i < n; i++) {
+        while (thread_pool_add_task(pool, process_job, &jobs[i]) != 0) {
+            usleep(100);
+        }
+    }
+    while (__atomic_load_n(&ctx->done, __ATOMIC_ACQUIRE) < n) {
+        usleep(100);
+    }
+}
+
+/**
+ * @brief 运行一个场景
+ * @param name 场景名
+ * @param pool 处理任务的线程池
+ * @param worker_node 线程池所在节点（-1表示不绑定）
+ * @param alloc_in_worker 是否由worker分配缓冲区
+ */
+static void run_case(const char* name, thread_pool_t* pool, int worker_node, int alloc_in_worker,
+                     int num_buffers, size_t buffer_size, int rounds) {
+    bench_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.buffers = (char**)calloc(num_buffers, sizeof(char*));
+    ctx.buffer_size = buffer_size;
+    ctx.rounds = rounds;
+    bench_job_t* jobs = (bench_job_t*)calloc(num_buffers, sizeof(bench_job_t));
+    if (!ctx.buffers || !jobs) {
+        fprintf(stderr, "malloc failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < num_buffers; i++) {
+        jobs[i].ctx = &ctx;
+        jobs[i].index = i;
+        if (!alloc_in_worker) {
+            ctx.buffers[i] = buffer_alloc_touch(buffer_size);
+        }
+    }
+    if (alloc_in_worker) {
+        ctx.alloc_phase = 1;
+        run_jobs(pool, &ctx, jobs, num_buffers);
+        ctx.alloc_phase = 0;
+    }
+
+    uint64_t start = now_ns();
+    run_jobs(pool, &ctx, jobs, num_buffers);
+    double sec = (double)(now_ns() - start) / 1e9;
+
+    // 统计缓冲区首页所在节点与worker节点一致的比例
+    int local = 0, known = 0;
+    for (int i = 0; i < num_buffers; i++) {
+        int node = page_node(ctx.buffers[i]);
+        if (node < 0) continue;
+        known++;
+        if (worker_node < 0 || node == worker_node) local++;
+    }
+    double mb = (double)num_buffers * buffer_size * rounds * 2 / (1024.0 * 1024.0); // 读+写
+    printf("%-10s %12.1f %10.3f ", name, mb / sec, sec);
+    if (known > 0 && worker_node >= 0) {
+        printf("%9.1f%%", 100.0 * local / known);
+    } else {
+        printf("%10s", "-");
+    }
+    printf("   (checksum %llu)\n", (unsigned long long)ctx.checksum);
+
+    for (int i = 0; i < num_buffers; i++) free(ctx.buffers[i]);
+    free(ctx.buffers);
+    free(jobs);
+}
+
+int main(int argc, char* argv[]) {
+    int num_buffers = argc >= 2 ? atoi(argv[1]) : DEFAULT_BUFFERS;
+    int buffer_kb = argc >= 3 ? atoi(argv[2]) : DEFAULT_BUFFER_KB;
+    int rounds = argc >= 4 ? atoi(argv[3]) : DEFAULT_ROUNDS;
+    if (num_buffers <= 0) num_buffers = DEFAULT_BUFFERS;
+    if (buffer_kb <= 0) buffer_kb = DEFAULT_BUFFER_KB;
+    if (rounds <= 0) rounds = DEFAULT_ROUNDS;
+    size_t buffer_size = (size_t)buffer_kb * 1024;
+
+    cpu_topology_t topo;
+    if (cpu_topology_load(&topo) != 0) {
+        perror("cpu_topology_load");
+        return 1;
+    }
+    int first_node = topo.nodes[0];
+    int last_node = topo.nodes[topo.num_nodes - 1];
+    cpu_set_t first_cpus;
+    int first_count = cpu_topology_node_cpus(&topo, first_node, &first_cpus);
+    cpu_set_t last_cpus;
+    int last_count = cpu_topology_node_cpus(&topo, last_node, &last_cpus);
+    printf("cpus: %d, numa nodes: %d, buffers: %d x %d KB, rounds: %d\n",
+           topo.num_cpus, topo.num_nodes, num_buffers, buffer_kb, rounds);
+    if (topo.num_nodes < 2) {
+        printf("note: single numa node, remote/local cases access the same memory\n");
+    }
+    cpu_topology_free(&topo);
+
+    // 主线程（模拟Reactor）绑定在第一个节点
+    pthread_setaffinity_np(pthread_self(), sizeof(first_cpus), &first_cpus);
+
+    thread_pool_config_t cfg;
+    thread_pool_config_init(&cfg);
+    cfg.min_threads = cfg.max_threads = last_count;
+    cfg.max_task = 0;
+    cfg.affinity = AFFINITY_NUMA_NODE;
+    cfg.numa_node = last_node;
+    thread_pool_t* bound_pool = thread_pool_create_ex(&cfg);
+
+    cfg.min_threads = cfg.max_threads = first_count;
+    cfg.affinity = AFFINITY_NONE;
+    cfg.numa_node = -1;
+    thread_pool_t* free_pool = thread_pool_create_ex(&cfg);
+    if (!bound_pool || !free_pool) {
+        fprintf(stderr, "create thread pool failed\n");
+        return 1;
+    }
+
+    printf("\n%-10s %12s %10s %10s\n", "case", "MB/s", "seconds", "local");
+    run_case("remote", bound_pool, last_node, 0, num_buffers, buffer_size, rounds);
+    run_case("local", bound_pool, last_node, 1, num_buffers, buffer_size, rounds);
+    run_case("unbound", free_pool, -1, 0, num_buffers, buffer_size, rounds);
+
+    thread_pool_destroy(bound_pool, 0);
+    thread_pool_destroy(free_pool, 0);
+    return 0;
+}
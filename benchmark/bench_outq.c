@@ -0,0 +1,178 @@
+// bench_outq.c
+// 响应写出对比：响应头 + 主体拷贝进连接的写缓冲区再writev（原实现） vs 待发送队列（0_outq.h，主体只登记共享引用，一次writev）
+// 编译: gcc -std=gnu11 -O2 -I../serverModel bench_outq.c -o bench_outq -pthread
+// 运行: ./bench_outq [每项MB数] [积压上限KB]
+// 说明:
+//  - socketpair 一端由写线程以非阻塞方式写，另一端由读线程阻塞读（每次64KB）
+//  - 写线程模拟事件循环：待发送数据少于积压上限时继续生成响应（约100字节的响应头 + 缓存的主体），
+//    然后发起一次写，EAGAIN时poll等待可写
+//  - 主体大小 1KB / 16KB / 256KB / 1MB；所有响应共用同一个主体（缓存的内容）
+//  - copied: 拷贝进写缓冲区的字节数（待发送队列只拷贝响应头）；iov/write: 每次writev平均的段数
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "0_iobuf.h"
+#include "0_outq.h"
+
+#define DEFAULT_MB 1024
+#define DEFAULT_BACKLOG_KB 4096
+#define SOCKET_BUFFER 262144
+#define READ_CHUNK 65536
+
+// ====================== 测试 ======================
+typedef struct reader_ctx {
+    int fd;
+    size_t expect;
+    size_t received;
+} reader_ctx_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void* reader_main(void* arg) {
+    reader_ctx_t* r = (reader_ctx_t*)arg;
+    char* buf = (char*)malloc(READ_CHUNK);
+    while (buf && r->received < r->expect) {
+        ssize_t n = read(r->fd, buf, READ_CHUNK);
+        if (n <= 0) break;
+        r->received += (size_t)n;
+    }
+    free(buf);
+    return NULL;
+}
+
+/**
+ * @brief 待发送数据组装成的iovec段数（与 outq_write_fd 相同的规则，只用于统计）
+ */
+static size_t outq_iov_count(const outq_t* q) {
+    size_t cnt = 0, pos = 0, i = 0;
+    struct iovec iov[2];
+    for (; i < q->seg_count && cnt + 3 <= OUTQ_MAX_IOV; i++) {
+        const outq_seg_t* s = &q->segs[(q->seg_head + i) & (q->seg_cap - 1)];
+        cnt += (size_t)outq_inline_iov(q, pos, s->inline_len, iov) + 1;
+        pos += s->inline_len;
+    }
+    if (i == q->seg_count && cnt + 2 <= OUTQ_MAX_IOV) cnt += (size_t)outq_inline_iov(q, pos, iobuf_size(&q->bytes) - pos, iov);
+    return cnt;
+}
+
+static void run_case(int use_outq, shared_body_t* body, size_t total, size_t backlog) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+        perror("socketpair");
+        exit(EXIT_FAILURE);
+    }
+    int sz = SOCKET_BUFFER;
+    setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &sz, sizeof(sz));
+    setsockopt(sv[1], SOL_SOCKET, SO_RCVBUF, &sz, sizeof(sz));
+    fcntl(sv[0], F_SETFL, fcntl(sv[0], F_GETFL, 0) | O_NONBLOCK);
+
+    char header[128];
+    size_t header_len = (size_t)snprintf(header, sizeof(header),
+                                         "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n"
+                                         "Content-Length: %zu\r\nConnection: keep-alive\r\n\r\n", body->len);
+    size_t response_len = header_len + body->len;
+    size_t responses = total / response_len ? total / response_len : 1;
+    reader_ctx_t reader = {sv[1], responses * response_len, 0};
+    pthread_t tid;
+    pthread_create(&tid, NULL, reader_main, &reader);
+
+    iobuf_t buf;
+    outq_t q;
+    iobuf_init(&buf, 4096, backlog + response_len);
+    outq_init(&q, 4096, backlog + response_len);
+    uint64_t writes = 0, waits = 0, iovs = 0, copied = 0;
+    size_t produced = 0;
+
+    uint64_t start = now_ns();
+    for (;;) {
+        size_t pending = use_outq ? outq_size(&q) : iobuf_size(&buf);
+        while (produced < responses && pending < backlog) {
+            if (use_outq) {
+                outq_append(&q, header, header_len);
+                outq_append_body(&q, body, 0, body->len);
+                copied += header_len + (body->len < OUTQ_INLINE_MAX ? body->len : 0);
+            } else {
+                iobuf_append(&buf, header, header_len); // 原 build_http_response 的做法
+                iobuf_append(&buf, body->data, body->len);
+                copied += response_len;
+            }
+            produced++;
+            pending += response_len;
+        }
+        if (pending == 0) break;
+        ssize_t n;
+        if (use_outq) {
+            iovs += outq_iov_count(&q);
+            n = outq_write_fd(&q, sv[0]);
+        } else {
+            struct iovec iov[2];
+            iovs += (uint64_t)iobuf_readable_iov(&buf, iov);
+            n = iobuf_write_fd(&buf, sv[0]);
+        }
+        writes++;
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("writev");
+                break;
+            }
+            struct pollfd pfd = {sv[0], POLLOUT, 0};
+            poll(&pfd, 1, -1);
+            waits++;
+        }
+    }
+    pthread_join(tid, NULL);
+    double sec = (double)(now_ns() - start) / 1e9;
+
+    printf("%-9zu %-6s %10.1f %12.0f %10llu %9.1f %12.1f%s\n",
+           body->len, use_outq ? "outq" : "copy",
+           reader.received / sec / (1024.0 * 1024.0),
+           responses / sec,
+           (unsigned long long)writes,
+           writes ? (double)iovs / writes : 0.0,
+           copied / (1024.0 * 1024.0),
+           reader.received == reader.expect ? "" : "  (short read)");
+    fflush(stdout);
+
+    iobuf_free(&buf);
+    outq_free(&q);
+    close(sv[0]);
+    close(sv[1]);
+}
+
+int main(int argc, char* argv[]) {
+    size_t mb = argc >= 2 ? strtoul(argv[1], NULL, 10) : DEFAULT_MB;
+    size_t backlog_kb = argc >= 3 ? strtoul(argv[2], NULL, 10) : DEFAULT_BACKLOG_KB;
+    if (mb == 0) mb = DEFAULT_MB;
+    if (backlog_kb == 0) backlog_kb = DEFAULT_BACKLOG_KB;
+    size_t total = mb << 20;
+    size_t backlog = backlog_kb << 10;
+
+    printf("%zu MB per case, backlog limit %zu KB, socket buffer %d B\n", mb, backlog_kb, SOCKET_BUFFER);
+    printf("\n%-9s %-6s %10s %12s %10s %9s %12s\n", "body", "write", "MB/s", "resp/s", "writes", "iov/write", "copied MB");
+
+    static const size_t body_sizes[] = {1 << 10, 16 << 10, 256 << 10, 1 << 20};
+    for (size_t i = 0; i < sizeof(body_sizes) / sizeof(body_sizes[0]); i++) {
+        char* data = (char*)malloc(body_sizes[i]);
+        for (size_t k = 0; k < body_sizes[i]; k++) data[k] = (char)('a' + k % 26);
+        shared_body_t* body = shared_body_create(data, body_sizes[i]);
+        free(data);
+        run_case(0, body, total, backlog);
+        run_case(1, body, total, backlog);
+        shared_body_unref(body);
+    }
+    return 0;
+}
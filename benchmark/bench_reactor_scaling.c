@@ -0,0 +1,405 @@
+// bench_reactor_scaling.c
+// Reactor扩展性对比：单Reactor / Reactor+线程池 / 每线程一个Reactor（SO_REUSEPORT，1..N个）/ 主从Reactor
+// 编译: gcc -std=gnu11 -O2 bench_reactor_scaling.c -o bench_reactor_scaling -pthread
+// 运行: ./bench_reactor_scaling [最大Reactor数] [每项秒数] [连接数] [客户端线程数]
+// 说明:
+//  - 服务器程序从本程序所在目录启动（构建后都在 bin/ 下）：
+//      reactor      : 3_reactor_epoll_server port 1 0   （原单Reactor，关闭逐请求打印）
+//      reactor+pool : 4_reactor_threadpool_epoll port   （stdout重定向到/dev/null）
+//      multi        : 3_reactor_epoll_server port N 0   （N = 1, 2, 4, ... , 最大Reactor数）
+//      main/sub-rr  : 3_reactor_epoll_server port N 0 1 （主Reactor accept，轮询移交给N个子Reactor）
+//      main/sub-ll  : 3_reactor_epoll_server port N 0 2 （同上，移交给连接数最少的子Reactor）
+//  - 客户端：若干线程各自用epoll驱动一部分keep-alive连接，每个连接同一时刻只有一个在途请求，
+//    收到完整响应（按Content-Length）后立即发下一个；预热后统计 requests/s 与请求往返延迟分位数
+//  - 客户端与服务器在同一台机器上竞争CPU，扩展性结论应在 CPU数 > 最大Reactor数 + 客户端线程数 时解读
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#define DEFAULT_SECONDS 3
+#define DEFAULT_CONNECTIONS 64
+#define BASE_PORT 23145
+#define WARMUP_MS 300
+#define STARTUP_TIMEOUT_MS 3000
+#define SHUTDOWN_TIMEOUT_MS 3000
+#define CONN_BUFFER_SIZE 8192
+#define MAX_SAMPLES_PER_THREAD 200000
+#define MAX_EVENTS 256
+
+static const char k_request[] = "GET /bench HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+typedef struct client_conn {
+    int fd;
+    size_t sent;                // 当前请求已发送字节数
+    size_t len;                 // 已收到的响应字节数
+    uint64_t start_ns;          // 当前请求的发送时间
+    char buf[CONN_BUFFER_SIZE];
+} client_conn_t;
+
+typedef struct client_thread {
+    pthread_t thread;
+    int port;
+    int num_conns;
+    client_conn_t* conns;
+    uint64_t completed;         // 统计窗口内完成的请求数
+    uint64_t* samples;          // 统计窗口内的往返延迟（前 MAX_SAMPLES_PER_THREAD 个）
+    size_t num_samples;
+    int failed;                 // 连接失败 / 服务端断开
+} client_thread_t;
+
+static int g_measuring;         // 原子访问：预热结束后置1
+static int g_stop;              // 原子访问：统计窗口结束后置1
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ms(int ms) {
+    struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+static int cmp_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * @brief 阻塞连接到本机端口
+ * @return fd，失败返回-1
+ */
+static int connect_local(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+/**
+ * @brief 判断缓冲区中是否已有一个完整的HTTP响应
+ * @return 完整响应的长度，不完整返回0，格式错误返回-1
+ */
+static ssize_t response_complete(const char* buf, size_t len) {
+    const char* end = memmem(buf, len, "\r\n\r\n", 4);
+    if (!end) return len >= CONN_BUFFER_SIZE ? -1 : 0;
+    size_t header_len = (size_t)(end - buf) + 4;
+    const char* cl = memmem(buf, header_len, "Content-Length:", 15);
+    if (!cl) return -1;
+    size_t body_len = strtoul(cl + 15, NULL, 10);
+    if (header_len + body_len > CONN_BUFFER_SIZE) return -1;
+    return len >= header_len + body_len ? (ssize_t)(header_len + body_len) : 0;
+}
+
+/**
+ * @brief 发送（或继续发送）当前请求
+ * @return 0 成功或需等待可写，-1 出错
+ */
+static int send_request(client_conn_t* c) {
+    while (c->sent < sizeof(k_request) - 1) {
+        ssize_t n = send(c->fd, k_request + c->sent, sizeof(k_request) - 1 - c->sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            c->sent += (size_t)n;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return 0; // 请求很短，实际上不会发生；等下一次可读时再补发
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 客户端线程：epoll驱动自己的连接，闭环发送请求
+ */
+static void* client_thread_main(void* arg) {
+    client_thread_t* t = (client_thread_t*)arg;
+    int epoll_fd = epoll_create1(0);
+    if (epoll_fd < 0) {
+        t->failed = 1;
+        return NULL;
+    }
+    for (int i = 0; i < t->num_conns; i++) {
+        client_conn_t* c = &t->conns[i];
+        c->fd = connect_local(t->port);
+        if (c->fd < 0) {
+            t->failed = 1;
+            continue;
+        }
+        fcntl(c->fd, F_SETFL, fcntl(c->fd, F_GETFL, 0) | O_NONBLOCK);
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, c->fd, &ev);
+        c->start_ns = now_ns();
+        if (send_request(c) < 0) t->failed = 1;
+    }
+
+    struct epoll_event events[MAX_EVENTS];
+    while (!__atomic_load_n(&g_stop, __ATOMIC_ACQUIRE)) {
+        int n = epoll_wait(epoll_fd, events, MAX_EVENTS, 100);
+        for (int i = 0; i < n; i++) {
+            client_conn_t* c = (client_conn_t*)events[i].data.ptr;
+            ssize_t r = recv(c->fd, c->buf + c->len, CONN_BUFFER_SIZE - c->len, 0);
+            if (r <= 0) {
+                if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) continue;
+                // 服务端关闭连接：从epoll中摘除，不再使用
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+                t->failed = 1;
+                continue;
+            }
+            c->len += (size_t)r;
+            ssize_t done = response_complete(c->buf, c->len);
+            if (done < 0) {
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+                t->failed = 1;
+                continue;
+            }
+            if (done == 0) {
+                send_request(c);
+                continue;
+            }
+            uint64_t now = now_ns();
+            if (__atomic_load_n(&g_measuring, __ATOMIC_ACQUIRE)) {
+                t->completed++;
+                if (t->num_samples < MAX_SAMPLES_PER_THREAD) {
+                    t->samples[t->num_samples++] = now - c->start_ns;
+                }
+            }
+            // 每个连接同一时刻只有一个在途请求，响应之后不会再有多余数据
+            c->len = 0;
+            c->sent = 0;
+            c->start_ns = now;
+            if (send_request(c) < 0) {
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+                t->failed = 1;
+            }
+        }
+    }
+
+    for (int i = 0; i < t->num_conns; i++) {
+        if (t->conns[i].fd >= 0) close(t->conns[i].fd);
+    }
+    close(epoll_fd);
+    return NULL;
+}
+
+/**
+ * @brief 启动服务器子进程（stdout/stderr重定向到/dev/null），等到端口可连接
+ * @return 子进程pid，失败返回-1
+ */
+static pid_t start_server(char* const argv[], int port) {
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return -1;
+    }
+    if (pid == 0) {
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull >= 0) {
+            dup2(devnull, STDOUT_FILENO);
+            dup2(devnull, STDERR_FILENO);
+            close(devnull);
+        }
+        execv(argv[0], argv);
+        _exit(127);
+    }
+    for (int waited = 0; waited < STARTUP_TIMEOUT_MS; waited += 10) {
+        int fd = connect_local(port);
+        if (fd >= 0) {
+            close(fd);
+            return pid;
+        }
+        int status;
+        if (waitpid(pid, &status, WNOHANG) == pid) {
+            fprintf(stderr, "%s exited during startup (status %d)\n", argv[0], status);
+            return -1;
+        }
+        sleep_ms(10);
+    }
+    fprintf(stderr, "%s did not start listening on port %d\n", argv[0], port);
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+    return -1;
+}
+
+/**
+ * @brief SIGINT让服务器优雅退出，超时则SIGKILL
+ */
+static void stop_server(pid_t pid) {
+    kill(pid, SIGINT);
+    for (int waited = 0; waited < SHUTDOWN_TIMEOUT_MS; waited += 10) {
+        if (waitpid(pid, NULL, WNOHANG) == pid) return;
+        sleep_ms(10);
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+}
+
+/**
+ * @brief 对一个服务器配置压测一轮并输出一行结果
+ * @return requests/s，失败返回-1
+ */
+static double run_case(const char* name, int reactors, char* const argv[], int port,
+                       int seconds, int connections, int client_threads, double baseline) {
+    pid_t pid = start_server(argv, port);
+    if (pid < 0) return -1;
+
+    client_thread_t* threads = (client_thread_t*)calloc(client_threads, sizeof(client_thread_t));
+    if (!threads) {
+        stop_server(pid);
+        return -1;
+    }
+    __atomic_store_n(&g_measuring, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&g_stop, 0, __ATOMIC_RELEASE);
+    int started = 0;
+    for (int i = 0; i < client_threads; i++) {
+        client_thread_t* t = &threads[i];
+        t->port = port;
+        t->num_conns = connections / client_threads + (i < connections % client_threads);
+        t->conns = (client_conn_t*)calloc(t->num_conns > 0 ? t->num_conns : 1, sizeof(client_conn_t));
+        t->samples = (uint64_t*)malloc(sizeof(uint64_t) * MAX_SAMPLES_PER_THREAD);
+        if (!t->conns || !t->samples) break;
+        for (int j = 0; j < t->num_conns; j++) t->conns[j].fd = -1;
+        if (pthread_create(&t->thread, NULL, client_thread_main, t) != 0) break;
+        started++;
+    }
+
+    sleep_ms(WARMUP_MS);
+    uint64_t start = now_ns();
+    __atomic_store_n(&g_measuring, 1, __ATOMIC_RELEASE);
+    sleep_ms(seconds * 1000);
+    __atomic_store_n(&g_measuring, 0, __ATOMIC_RELEASE);
+    double elapsed = (double)(now_ns() - start) / 1e9;
+    __atomic_store_n(&g_stop, 1, __ATOMIC_RELEASE);
+
+    uint64_t completed = 0;
+    size_t total_samples = 0;
+    int failed = started < client_threads;
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i].thread, NULL);
+        completed += threads[i].completed;
+        total_samples += threads[i].num_samples;
+        failed |= threads[i].failed;
+    }
+    stop_server(pid);
+
+    uint64_t* all = (uint64_t*)malloc(sizeof(uint64_t) * (total_samples > 0 ? total_samples : 1));
+    size_t k = 0;
+    for (int i = 0; all && i < started; i++) {
+        memcpy(all + k, threads[i].samples, sizeof(uint64_t) * threads[i].num_samples);
+        k += threads[i].num_samples;
+    }
+    double p50 = 0, p99 = 0;
+    if (all && total_samples > 0) {
+        qsort(all, total_samples, sizeof(uint64_t), cmp_u64);
+        p50 = all[total_samples / 2] / 1000.0;
+        p99 = all[total_samples * 99 / 100] / 1000.0;
+    }
+    free(all);
+    for (int i = 0; i < client_threads; i++) {
+        free(threads[i].conns);
+        free(threads[i].samples);
+    }
+    free(threads);
+
+    double rps = completed / elapsed;
+    printf("%-13s %8d %12.0f %10.1f %10.1f", name, reactors, rps, p50, p99);
+    if (baseline > 0) printf(" %8.2fx", rps / baseline);
+    else printf(" %9s", "-");
+    printf("%s\n", failed ? "  (connection errors)" : "");
+    fflush(stdout);
+    return rps;
+}
+
+int main(int argc, char* argv[]) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_reactors = argc >= 2 ? atoi(argv[1]) : (int)cpus;
+    int seconds = argc >= 3 ? atoi(argv[2]) : DEFAULT_SECONDS;
+    int connections = argc >= 4 ? atoi(argv[3]) : DEFAULT_CONNECTIONS;
+    int client_threads = argc >= 5 ? atoi(argv[4]) : (cpus > 1 ? (int)(cpus / 2) : 1);
+    if (max_reactors <= 0) max_reactors = cpus > 0 ? (int)cpus : 1;
+    if (seconds <= 0) seconds = DEFAULT_SECONDS;
+    if (connections <= 0) connections = DEFAULT_CONNECTIONS;
+    if (client_threads <= 0) client_threads = 1;
+    if (client_threads > connections) client_threads = connections;
+
+    // 服务器程序与本程序在同一目录
+    char self[PATH_MAX];
+    ssize_t len = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (len < 0) {
+        perror("readlink");
+        return 1;
+    }
+    self[len] = '\0';
+    const char* dir = dirname(self);
+    char reactor_path[PATH_MAX + 64], pool_path[PATH_MAX + 64];
+    snprintf(reactor_path, sizeof(reactor_path), "%s/3_reactor_epoll_server", dir);
+    snprintf(pool_path, sizeof(pool_path), "%s/4_reactor_threadpool_epoll", dir);
+    if (access(reactor_path, X_OK) != 0 || access(pool_path, X_OK) != 0) {
+        fprintf(stderr, "server binaries not found next to this program (%s)\n", dir);
+        return 1;
+    }
+
+    printf("cpus: %ld, max reactors: %d, connections: %d, client threads: %d, %d s per case\n",
+           cpus, max_reactors, connections, client_threads, seconds);
+    if (cpus < max_reactors + client_threads) {
+        printf("note: fewer cpus than reactors + client threads, scaling is bounded by the cpu count\n");
+    }
+    printf("\n%-13s %8s %12s %10s %10s %9s\n", "server", "reactors", "req/s", "p50(us)", "p99(us)", "speedup");
+
+    int port = BASE_PORT;
+    char port_str[16], reactors_str[16];
+
+    snprintf(port_str, sizeof(port_str), "%d", port);
+    char* single_argv[] = {reactor_path, port_str, "1", "0", NULL};
+    double baseline = run_case("reactor", 1, single_argv, port++, seconds, connections, client_threads, 0);
+
+    snprintf(port_str, sizeof(port_str), "%d", port);
+    char* pool_argv[] = {pool_path, port_str, NULL};
+    run_case("reactor+pool", 1, pool_argv, port++, seconds, connections, client_threads, baseline);
+
+    for (int n = 1; n <= max_reactors; n = (n * 2 > max_reactors && n < max_reactors) ? max_reactors : n * 2) {
+        snprintf(port_str, sizeof(port_str), "%d", port);
+        snprintf(reactors_str, sizeof(reactors_str), "%d", n);
+        char* multi_argv[] = {reactor_path, port_str, reactors_str, "0", NULL};
+        run_case("multi", n, multi_argv, port++, seconds, connections, client_threads, baseline);
+
+        snprintf(port_str, sizeof(port_str), "%d", port);
+        char* rr_argv[] = {reactor_path, port_str, reactors_str, "0", "1", NULL};
+        run_case("main/sub-rr", n, rr_argv, port++, seconds, connections, client_threads, baseline);
+
+        snprintf(port_str, sizeof(port_str), "%d", port);
+        char* ll_argv[] = {reactor_path, port_str, reactors_str, "0", "2", NULL};
+        run_case("main/sub-ll", n, ll_argv, port++, seconds, connections, client_threads, baseline);
+    }
+    return 0;
+}
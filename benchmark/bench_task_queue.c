@@ -0,0 +1,204 @@
+// bench_task_queue.c
+// 任务队列吞吐量对比：互斥锁+链表（原 thread_pool 实现） vs 无锁MPMC环形队列
+// 编译: gcc -std=gnu11 -O2 -I../serverModel bench_task_queue.c -o bench_task_queue -pthread
+// 运行: ./bench_task_queue [每轮总任务数] [消费者线程数]
+// 说明: 生产者线程数依次取 1/2/4/8/16/32/64，统计 入队+出队 的整体吞吐（ops/s）
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "0_threadpool.h"
+
+#define DEFAULT_TOTAL_OPS 2000000
+#define DEFAULT_CONSUMERS 4
+#define QUEUE_CAPACITY MAX_TASK_QUEUE
+
+// ====================== 基准实现：互斥锁 + 链表（与原 thread_pool_add_task 相同） ======================
+typedef struct list_node {
+    task_t* task;
+    struct list_node* next;
+} list_node_t;
+
+typedef struct mutex_list_queue {
+    list_node_t* head;
+    int count;
+    int max;
+    pthread_mutex_t mutex;
+} mutex_list_queue_t;
+
+static int mutex_list_push(mutex_list_queue_t* q, list_node_t* node) {
+    pthread_mutex_lock(&q->mutex);
+    if (q->count >= q->max) {
+        pthread_mutex_unlock(&q->mutex);
+        return -1;
+    }
+    node->next = NULL;
+    // 原实现：遍历链表找到尾节点
+    if (!q->head) {
+        q->head = node;
+    } else {
+        list_node_t* tmp = q->head;
+        while (tmp->next) {
+            tmp = tmp->next;
+        }
+        tmp->next = node;
+    }
+    q->count++;
+    pthread_mutex_unlock(&q->mutex);
+    return 0;
+}
+
+static list_node_t* mutex_list_pop(mutex_list_queue_t* q) {
+    pthread_mutex_lock(&q->mutex);
+    list_node_t* node = q->head;
+    if (node) {
+        q->head = node->next;
+        q->count--;
+    }
+    pthread_mutex_unlock(&q->mutex);
+    return node;
+}
+
+// ====================== 测试框架 ======================
+typedef enum {
+    QUEUE_MUTEX_LIST,
+    QUEUE_LOCKFREE_RING,
+} queue_kind_t;
+
+typedef struct bench_ctx {
+    queue_kind_t kind;
+    mutex_list_queue_t list;
+    task_ring_t ring;
+    long ops_per_producer;
+    long total_ops;
+    long consumed;              // 已出队数量（原子访问）
+    pthread_barrier_t start;
+} bench_ctx_t;
+
+static task_t g_dummy_task;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void* producer_main(void* arg) {
+    bench_ctx_t* ctx = (bench_ctx_t*)arg;
+    list_node_t* nodes = NULL;
+    if (ctx->kind == QUEUE_MUTEX_LIST) {
+        // 预先分配链表节点，只比较队列本身的开销
+        nodes = (list_node_t*)malloc(sizeof(list_node_t) * ctx->ops_per_producer);
+    }
+    pthread_barrier_wait(&ctx->start);
+
+    for (long i = 0; i < ctx->ops_per_producer; i++) {
+        if (ctx->kind == QUEUE_MUTEX_LIST) {
+            nodes[i].task = &g_dummy_task;
+            while (mutex_list_push(&ctx->list, &nodes[i]) != 0) {
+                sched_yield(); // 队列满，让出CPU给消费者
+            }
+        } else {
+            while (task_ring_push(&ctx->ring, &g_dummy_task) != 0) {
+                sched_yield();
+            }
+        }
+    }
+
+    // 等待所有数据被消费后再释放节点
+    while (__atomic_load_n(&ctx->consumed, __ATOMIC_ACQUIRE) < ctx->total_ops) {
+        sched_yield();
+    }
+    free(nodes);
+    return NULL;
+}
+
+static void* consumer_main(void* arg) {
+    bench_ctx_t* ctx = (bench_ctx_t*)arg;
+    pthread_barrier_wait(&ctx->start);
+
+    while (__atomic_load_n(&ctx->consumed, __ATOMIC_RELAXED) < ctx->total_ops) {
+        int got;
+        if (ctx->kind == QUEUE_MUTEX_LIST) {
+            got = mutex_list_pop(&ctx->list) != NULL;
+        } else {
+            got = task_ring_pop(&ctx->ring) != NULL;
+        }
+        if (got) {
+            __atomic_add_fetch(&ctx->consumed, 1, __ATOMIC_RELEASE);
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 运行一轮测试
+ * @return 吞吐量（ops/s）
+ */
+static double run_round(queue_kind_t kind, int producers, int consumers, long total_ops) {
+    bench_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.kind = kind;
+    ctx.ops_per_producer = total_ops / producers;
+    ctx.total_ops = ctx.ops_per_producer * producers;
+    ctx.list.max = QUEUE_CAPACITY;
+    pthread_mutex_init(&ctx.list.mutex, NULL);
+    if (task_ring_init(&ctx.ring, QUEUE_CAPACITY) != 0) {
+        exit(EXIT_FAILURE);
+    }
+    pthread_barrier_init(&ctx.start, NULL, producers + consumers + 1);
+
+    pthread_t* threads = (pthread_t*)malloc(sizeof(pthread_t) * (producers + consumers));
+    for (int i = 0; i < producers; i++) {
+        pthread_create(&threads[i], NULL, producer_main, &ctx);
+    }
+    for (int i = 0; i < consumers; i++) {
+        pthread_create(&threads[producers + i], NULL, consumer_main, &ctx);
+    }
+
+    pthread_barrier_wait(&ctx.start);
+    double begin = now_sec();
+    while (__atomic_load_n(&ctx.consumed, __ATOMIC_ACQUIRE) < ctx.total_ops) {
+        usleep(100);
+    }
+    double elapsed = now_sec() - begin;
+
+    for (int i = 0; i < producers + consumers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    pthread_barrier_destroy(&ctx.start);
+    pthread_mutex_destroy(&ctx.list.mutex);
+    task_ring_destroy(&ctx.ring);
+    return ctx.total_ops / elapsed;
+}
+
+int main(int argc, char* argv[]) {
+    long total_ops = DEFAULT_TOTAL_OPS;
+    int consumers = DEFAULT_CONSUMERS;
+    if (argc >= 2) total_ops = atol(argv[1]);
+    if (argc >= 3) consumers = atoi(argv[2]);
+    if (total_ops <= 0 || consumers <= 0) {
+        fprintf(stderr, "usage: %s [total_ops] [consumers]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    printf("task queue benchmark: total_ops=%ld, consumers=%d, capacity=%d, cpus=%ld\n",
+           total_ops, consumers, QUEUE_CAPACITY, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%-10s %18s %18s %10s\n", "producers", "mutex_list(ops/s)", "mpmc_ring(ops/s)", "speedup");
+
+    static const int producer_counts[] = {1, 2, 4, 8, 16, 32, 64};
+    for (size_t i = 0; i < sizeof(producer_counts) / sizeof(producer_counts[0]); i++) {
+        int producers = producer_counts[i];
+        double list_ops = run_round(QUEUE_MUTEX_LIST, producers, consumers, total_ops);
+        double ring_ops = run_round(QUEUE_LOCKFREE_RING, producers, consumers, total_ops);
+        printf("%-10d %18.0f %18.0f %9.2fx\n", producers, list_ops, ring_ops, ring_ops / list_ops);
+    }
+    return 0;
+}
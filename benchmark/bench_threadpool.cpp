@@ -0,0 +1,318 @@
+// bench_threadpool.cpp
+// 线程池微基准：C thread_pool_t、strand 与 C++ ThreadPool（共享队列 / 工作窃取）在同一组场景下对比
+// 编译: g++ -std=c++17 -O2 -I../serverModel bench_threadpool.cpp -o bench_threadpool -pthread
+// 运行: ./bench_threadpool [线程数] [每个场景的任务数] [标签] > result.json
+// 说明:
+//  - 场景:
+//    empty_task      单个提交线程提交空任务，统计 提交 + 执行 的整体吞吐（tasks/s）
+//    submit_latency  单个提交线程逐个计时提交调用本身的耗时（p50/p90/p99/p999，纳秒）
+//    fan_out_in      每轮提交 线程数*16 个小任务并等待全部完成，统计每轮耗时和轮次吞吐
+//    prod_cons       生产者:worker 为 1:4、1:1、4:1 时多个生产者并发提交的整体吞吐
+//  - 变体:
+//    c_pool          C thread_pool_t（OVERFLOW_BLOCK）
+//    c_strand        C thread_pool_t 上的单个strand（所有任务串行，衡量串行执行器的开销）
+//    cpp_shared      C++ ThreadPool，SchedulingMode::SharedQueue
+//    cpp_stealing    C++ ThreadPool，SchedulingMode::WorkStealing
+//  - 结果以JSON输出到标准输出，线程池自身的日志被重定向到标准错误；
+//    标签原样写入结果（例如 $(git rev-parse --short HEAD)），便于跨提交对比
+
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sched.h>
+#include <unistd.h>
+#include "0_threadpool.h"
+#include "0_threadPool.hpp"
+
+const int DefaultThreads = 4;
+const size_t DefaultTasks = 1000000;
+const size_t FanOutPerThread = 16;   // fan_out_in 每轮任务数 = 线程数 * FanOutPerThread
+const int FanOutWork = 256;          // fan_out_in 每个任务的计算量（LCG迭代次数）
+const size_t MaxQueue = 65536;
+
+static FILE* jsonOut = stdout;
+static bool firstResult = true;
+
+static uint64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// ====================== 任务 ======================
+struct Counter {
+    alignas(64) std::atomic<size_t> done{0};
+};
+
+static void emptyTask(void* arg) {
+    static_cast<Counter*>(arg)->done.fetch_add(1, std::memory_order_release);
+}
+
+static void workTask(void* arg) {
+    volatile uint32_t x = 1;
+    for (int i = 0; i < FanOutWork; ++i) x = x * 1664525u + 1013904223u;
+    static_cast<Counter*>(arg)->done.fetch_add(1, std::memory_order_release);
+}
+
+/**
+ * @brief 等待计数达到目标（让出CPU，单核时worker也能执行）
+ */
+static void waitDone(const Counter& c, size_t target) {
+    while (c.done.load(std::memory_order_acquire) < target) {
+        sched_yield();
+    }
+}
+
+// ====================== 执行器变体 ======================
+/**
+ * @brief 各线程池的统一提交接口（每个变体都多一次虚调用，开销相同）
+ */
+class Executor {
+public:
+    virtual ~Executor() = default;
+    virtual const char* name() const = 0;
+    virtual void post(void (*fn)(void*), void* arg) = 0;
+};
+
+class CPoolExecutor : public Executor {
+public:
+    explicit CPoolExecutor(int threads) : pool(createPool(threads)) {}
+    ~CPoolExecutor() override { thread_pool_destroy(pool, 0); }
+    const char* name() const override { return "c_pool"; }
+    void post(void (*fn)(void*), void* arg) override {
+        while (thread_pool_add_task(pool, fn, arg) < 0) {
+            sched_yield();
+        }
+    }
+
+    static thread_pool_t* createPool(int threads) {
+        thread_pool_config_t cfg;
+        thread_pool_config_init(&cfg);
+        cfg.min_threads = cfg.max_threads = threads;
+        cfg.max_task = static_cast<int>(MaxQueue);
+        cfg.overflow_policy = OVERFLOW_BLOCK;
+        thread_pool_t* pool = thread_pool_create_ex(&cfg);
+        if (!pool) {
+            fprintf(stderr, "create thread pool failed\n");
+            exit(EXIT_FAILURE);
+        }
+        return pool;
+    }
+
+protected:
+    thread_pool_t* pool;
+};
+
+class CStrandExecutor : public CPoolExecutor {
+public:
+    explicit CStrandExecutor(int threads) : CPoolExecutor(threads) {
+        thread_pool_strand_init(&strand, pool);
+    }
+    ~CStrandExecutor() override {
+        while (!thread_pool_strand_idle(&strand)) {
+            sched_yield();
+        }
+        thread_pool_strand_destroy(&strand);
+    }
+    const char* name() const override { return "c_strand"; }
+    void post(void (*fn)(void*), void* arg) override {
+        if (thread_pool_strand_post(&strand, fn, arg) == THREAD_POOL_REJECTED) {
+            // 任务已进入strand，但调度被拒绝：持有令牌，须重新提交strand
+            while (thread_pool_add_task(pool, thread_pool_strand_run, &strand) < 0) {
+                sched_yield();
+            }
+        }
+    }
+
+private:
+    thread_pool_strand_t strand;
+};
+
+class CppPoolExecutor : public Executor {
+public:
+    CppPoolExecutor(int threads, SchedulingMode mode)
+        : pool(static_cast<size_t>(threads), MaxQueue, mode), mode(mode) {}
+    const char* name() const override {
+        return mode == SchedulingMode::WorkStealing ? "cpp_stealing" : "cpp_shared";
+    }
+    void post(void (*fn)(void*), void* arg) override {
+        pool.submit([fn, arg] { fn(arg); });
+    }
+
+private:
+    ThreadPool pool;
+    SchedulingMode mode;
+};
+
+// ====================== 输出 ======================
+/**
+ * @brief 输出一条结果（JSON对象，fields 为已格式化的 "key": value 列表）
+ */
+static void emitResult(const Executor& ex, const char* scenario, const std::string& fields) {
+    fprintf(jsonOut, "%s\n    {\"variant\": \"%s\", \"scenario\": \"%s\", %s}",
+            firstResult ? "" : ",", ex.name(), scenario, fields.c_str());
+    firstResult = false;
+    fflush(jsonOut);
+    fprintf(stderr, "  %-13s %-15s %s\n", ex.name(), scenario, fields.c_str());
+}
+
+static std::string fmt(const char* format, ...) __attribute__((format(printf, 1, 2)));
+static std::string fmt(const char* format, ...) {
+    char buf[512];
+    va_list ap;
+    va_start(ap, format);
+    vsnprintf(buf, sizeof(buf), format, ap);
+    va_end(ap);
+    return buf;
+}
+
+static uint64_t percentile(std::vector<uint64_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t i = static_cast<size_t>(p * static_cast<double>(sorted.size()));
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+// ====================== 场景 ======================
+static void benchEmptyTask(Executor& ex, size_t tasks) {
+    Counter c;
+    uint64_t start = nowNs();
+    for (size_t i = 0; i < tasks; ++i) {
+        ex.post(emptyTask, &c);
+    }
+    waitDone(c, tasks);
+    double sec = static_cast<double>(nowNs() - start) / 1e9;
+    emitResult(ex, "empty_task", fmt("\"tasks\": %zu, \"seconds\": %.6f, \"tasks_per_sec\": %.0f",
+                                     tasks, sec, static_cast<double>(tasks) / sec));
+}
+
+static void benchSubmitLatency(Executor& ex, size_t tasks) {
+    Counter c;
+    std::vector<uint64_t> samples(tasks);
+    for (size_t i = 0; i < tasks; ++i) {
+        uint64_t t0 = nowNs();
+        ex.post(emptyTask, &c);
+        samples[i] = nowNs() - t0;
+    }
+    waitDone(c, tasks);
+    std::sort(samples.begin(), samples.end());
+    emitResult(ex, "submit_latency",
+               fmt("\"tasks\": %zu, \"p50_ns\": %llu, \"p90_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu",
+                   tasks,
+                   static_cast<unsigned long long>(percentile(samples, 0.50)),
+                   static_cast<unsigned long long>(percentile(samples, 0.90)),
+                   static_cast<unsigned long long>(percentile(samples, 0.99)),
+                   static_cast<unsigned long long>(percentile(samples, 0.999))));
+}
+
+static void benchFanOutIn(Executor& ex, size_t tasks, int threads) {
+    size_t width = static_cast<size_t>(threads) * FanOutPerThread;
+    size_t rounds = std::max<size_t>(1, tasks / width);
+    std::vector<uint64_t> samples(rounds);
+    Counter c;
+    uint64_t start = nowNs();
+    for (size_t r = 0; r < rounds; ++r) {
+        uint64_t t0 = nowNs();
+        for (size_t i = 0; i < width; ++i) {
+            ex.post(workTask, &c);
+        }
+        waitDone(c, (r + 1) * width);
+        samples[r] = nowNs() - t0;
+    }
+    double sec = static_cast<double>(nowNs() - start) / 1e9;
+    std::sort(samples.begin(), samples.end());
+    emitResult(ex, "fan_out_in",
+               fmt("\"width\": %zu, \"rounds\": %zu, \"rounds_per_sec\": %.0f, \"p50_ns\": %llu, \"p99_ns\": %llu",
+                   width, rounds, static_cast<double>(rounds) / sec,
+                   static_cast<unsigned long long>(percentile(samples, 0.50)),
+                   static_cast<unsigned long long>(percentile(samples, 0.99))));
+}
+
+static void benchProdCons(Executor& ex, size_t tasks, int threads, int producers) {
+    Counter c;
+    size_t perProducer = tasks / static_cast<size_t>(producers);
+    size_t total = perProducer * static_cast<size_t>(producers);
+    std::atomic<bool> go{false};
+    std::vector<std::thread> ps;
+    for (int p = 0; p < producers; ++p) {
+        ps.emplace_back([&] {
+            while (!go.load(std::memory_order_acquire)) {
+                sched_yield();
+            }
+            for (size_t i = 0; i < perProducer; ++i) {
+                ex.post(emptyTask, &c);
+            }
+        });
+    }
+    uint64_t start = nowNs();
+    go.store(true, std::memory_order_release);
+    for (auto& t : ps) {
+        t.join();
+    }
+    waitDone(c, total);
+    double sec = static_cast<double>(nowNs() - start) / 1e9;
+    emitResult(ex, "prod_cons",
+               fmt("\"producers\": %d, \"workers\": %d, \"tasks\": %zu, \"seconds\": %.6f, \"tasks_per_sec\": %.0f",
+                   producers, threads, total, sec, static_cast<double>(total) / sec));
+}
+
+static void runAll(Executor& ex, size_t tasks, int threads) {
+    benchEmptyTask(ex, tasks);
+    benchSubmitLatency(ex, tasks);
+    benchFanOutIn(ex, tasks, threads);
+    const int ratios[] = {std::max(1, threads / 4), threads, threads * 4};
+    for (int producers : ratios) {
+        benchProdCons(ex, tasks, threads, producers);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int threads = argc >= 2 ? atoi(argv[1]) : DefaultThreads;
+    size_t tasks = argc >= 3 ? strtoull(argv[2], nullptr, 10) : DefaultTasks;
+    const char* label = argc >= 4 ? argv[3] : "";
+    if (threads <= 0) threads = DefaultThreads;
+    if (tasks == 0) tasks = DefaultTasks;
+
+    // JSON写到原标准输出，线程池创建/销毁的日志改到标准错误
+    jsonOut = fdopen(dup(STDOUT_FILENO), "w");
+    if (!jsonOut || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+        perror("redirect stdout");
+        return 1;
+    }
+
+    fprintf(jsonOut, "{\n  \"benchmark\": \"bench_threadpool\",\n  \"label\": \"");
+    for (const char* p = label; *p; ++p) {
+        if (*p == '"' || *p == '\\') fputc('\\', jsonOut);
+        if (static_cast<unsigned char>(*p) >= 0x20) fputc(*p, jsonOut);
+    }
+    fprintf(jsonOut, "\",\n  \"timestamp\": %lld,\n  \"cpus\": %ld,\n  \"threads\": %d,\n  \"tasks\": %zu,\n"
+                     "  \"results\": [",
+            static_cast<long long>(time(nullptr)), sysconf(_SC_NPROCESSORS_ONLN), threads, tasks);
+
+    // 每个变体单独创建、测完即销毁，避免空闲线程池的worker干扰其他变体
+    {
+        CPoolExecutor ex(threads);
+        runAll(ex, tasks, threads);
+    }
+    {
+        CStrandExecutor ex(threads);
+        runAll(ex, tasks, threads);
+    }
+    {
+        CppPoolExecutor ex(threads, SchedulingMode::SharedQueue);
+        runAll(ex, tasks, threads);
+    }
+    {
+        CppPoolExecutor ex(threads, SchedulingMode::WorkStealing);
+        runAll(ex, tasks, threads);
+    }
+
+    fprintf(jsonOut, "\n  ]\n}\n");
+    fclose(jsonOut);
+    return 0;
+}
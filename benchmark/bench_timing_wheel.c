@@ -0,0 +1,238 @@
+// bench_timing_wheel.c
+// 连接超时的数据结构对比：哈希时间轮（0_timing_wheel.h） vs 带位置索引的二叉最小堆
+// 编译: gcc -std=gnu11 -O2 -I../serverModel bench_timing_wheel.c -o bench_timing_wheel
+// 运行: ./bench_timing_wheel [定时器数] [槽数] [tick毫秒]
+// 说明:
+//  - 定时器嵌入在模拟的连接结构体中，超时在 1 ~ 60 秒之间随机（空闲/读/写超时的典型范围）
+//  - add        : 全部设置一次
+//  - reset-later: 每个连接有活动，期限推后（最常见的路径；时间轮只改 expire，堆要下沉）
+//  - reset-earlier: 期限提前到早于最初的期限（如从空闲超时切到写超时；时间轮换槽，堆要上浮）
+//  - cancel     : 连接关闭，取消后再设置回去（保持规模不变）
+//  - expire     : 模拟时间逐tick前进直到全部到期，统计平均每个到期的开销和单个tick的最大耗时
+//                （单个tick耗时直接加在该轮事件循环上，决定了超时处理对请求延迟的影响）
+//  - 时钟由程序模拟推进，不真正休眠
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "0_timing_wheel.h"
+
+#define DEFAULT_TIMERS 1000000
+#define MIN_TIMEOUT_MS 1000
+#define MAX_TIMEOUT_MS 60000
+
+typedef struct bench_conn {
+    wheel_timer_t timer;        // 时间轮节点
+    uint64_t heap_deadline;     // 堆：到期时间（毫秒）
+    size_t heap_index;          // 堆：在数组中的位置（SIZE_MAX表示不在堆中）
+    uint32_t timeout_ms;
+} bench_conn_t;
+
+static uint64_t g_fired;
+static uint64_t g_rng = 88172645463325252ull;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t rand_timeout(void) {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return MIN_TIMEOUT_MS + (uint32_t)(g_rng % (MAX_TIMEOUT_MS - MIN_TIMEOUT_MS));
+}
+
+static void on_fire(void* arg) {
+    (void)arg;
+    g_fired++;
+}
+
+// ====================== 对照：带位置索引的二叉最小堆 ======================
+typedef struct timer_heap {
+    bench_conn_t** items;
+    size_t size;
+} timer_heap_t;
+
+static void heap_place(timer_heap_t* h, size_t i, bench_conn_t* c) {
+    h->items[i] = c;
+    c->heap_index = i;
+}
+
+static void heap_sift_up(timer_heap_t* h, size_t i) {
+    bench_conn_t* c = h->items[i];
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (h->items[parent]->heap_deadline <= c->heap_deadline) break;
+        heap_place(h, i, h->items[parent]);
+        i = parent;
+    }
+    heap_place(h, i, c);
+}
+
+static void heap_sift_down(timer_heap_t* h, size_t i) {
+    bench_conn_t* c = h->items[i];
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= h->size) break;
+        if (child + 1 < h->size && h->items[child + 1]->heap_deadline < h->items[child]->heap_deadline) child++;
+        if (c->heap_deadline <= h->items[child]->heap_deadline) break;
+        heap_place(h, i, h->items[child]);
+        i = child;
+    }
+    heap_place(h, i, c);
+}
+
+static void heap_set(timer_heap_t* h, bench_conn_t* c, uint64_t deadline) {
+    if (c->heap_index == SIZE_MAX) {
+        c->heap_deadline = deadline;
+        heap_place(h, h->size++, c);
+        heap_sift_up(h, c->heap_index);
+        return;
+    }
+    uint64_t old = c->heap_deadline;
+    c->heap_deadline = deadline;
+    if (deadline < old) heap_sift_up(h, c->heap_index);
+    else heap_sift_down(h, c->heap_index);
+}
+
+static void heap_cancel(timer_heap_t* h, bench_conn_t* c) {
+    size_t i = c->heap_index;
+    if (i == SIZE_MAX) return;
+    c->heap_index = SIZE_MAX;
+    bench_conn_t* last = h->items[--h->size];
+    if (i == h->size) return;
+    heap_place(h, i, last);
+    heap_sift_up(h, i);
+    heap_sift_down(h, last->heap_index);
+}
+
+static size_t heap_expire(timer_heap_t* h, uint64_t now) {
+    size_t fired = 0;
+    while (h->size > 0 && h->items[0]->heap_deadline <= now) {
+        bench_conn_t* c = h->items[0];
+        heap_cancel(h, c);
+        on_fire(c);
+        fired++;
+    }
+    return fired;
+}
+
+// ====================== 测试 ======================
+static void print_row(const char* op, double wheel_ns, double heap_ns) {
+    printf("%-14s %12.1f %12.1f %9.1fx\n", op, wheel_ns, heap_ns, heap_ns / wheel_ns);
+    fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = argc >= 2 ? strtoul(argv[1], NULL, 10) : DEFAULT_TIMERS;
+    size_t slots = argc >= 3 ? strtoul(argv[2], NULL, 10) : WHEEL_DEFAULT_SLOTS;
+    uint64_t tick_ms = argc >= 4 ? strtoull(argv[3], NULL, 10) : WHEEL_DEFAULT_TICK_MS;
+    if (n == 0) n = DEFAULT_TIMERS;
+    if (tick_ms == 0) tick_ms = WHEEL_DEFAULT_TICK_MS;
+
+    bench_conn_t* conns = (bench_conn_t*)calloc(n, sizeof(bench_conn_t));
+    timer_heap_t heap = {(bench_conn_t**)malloc(sizeof(bench_conn_t*) * n), 0};
+    timing_wheel_t wheel;
+    if (!conns || !heap.items || timing_wheel_init(&wheel, slots, tick_ms) < 0) {
+        fprintf(stderr, "malloc failed\n");
+        return 1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        wheel_timer_init(&conns[i].timer, on_fire, &conns[i]);
+        conns[i].heap_index = SIZE_MAX;
+        conns[i].timeout_ms = rand_timeout();
+    }
+    printf("timers: %zu, wheel: %zu slots x %llu ms, timeouts %d..%d ms\n",
+           n, wheel.mask + 1, (unsigned long long)wheel.tick_ms, MIN_TIMEOUT_MS, MAX_TIMEOUT_MS);
+    printf("memory per timer: wheel %zu B (+%zu B slots total), heap %zu B (+8 B array slot)\n",
+           sizeof(wheel_timer_t), sizeof(wheel_timer_t) * (wheel.mask + 1),
+           sizeof(uint64_t) + sizeof(size_t));
+    printf("\n%-14s %12s %12s %10s\n", "op", "wheel ns/op", "heap ns/op", "heap/wheel");
+
+    // 模拟时钟：两者以相同的"当前时间"为基准
+    uint64_t sim_ms = wheel.start_ms;
+    uint64_t t0, t1;
+
+    t0 = now_ns();
+    for (size_t i = 0; i < n; i++) timing_wheel_set(&wheel, &conns[i].timer, conns[i].timeout_ms);
+    t1 = now_ns();
+    double wheel_add = (double)(t1 - t0) / n;
+    t0 = now_ns();
+    for (size_t i = 0; i < n; i++) heap_set(&heap, &conns[i], sim_ms + conns[i].timeout_ms);
+    t1 = now_ns();
+    print_row("add", wheel_add, (double)(t1 - t0) / n);
+
+    // 期限推后：在原超时的基础上再加一段
+    t0 = now_ns();
+    for (size_t i = 0; i < n; i++) timing_wheel_set(&wheel, &conns[i].timer, conns[i].timeout_ms + MAX_TIMEOUT_MS);
+    t1 = now_ns();
+    double wheel_later = (double)(t1 - t0) / n;
+    t0 = now_ns();
+    for (size_t i = 0; i < n; i++) heap_set(&heap, &conns[i], sim_ms + conns[i].timeout_ms + MAX_TIMEOUT_MS);
+    t1 = now_ns();
+    print_row("reset-later", wheel_later, (double)(t1 - t0) / n);
+
+    // 期限提前：早于最初设置的期限（时间轮必须换槽）
+    t0 = now_ns();
+    for (size_t i = 0; i < n; i++) timing_wheel_set(&wheel, &conns[i].timer, conns[i].timeout_ms / 2);
+    t1 = now_ns();
+    double wheel_earlier = (double)(t1 - t0) / n;
+    t0 = now_ns();
+    for (size_t i = 0; i < n; i++) heap_set(&heap, &conns[i], sim_ms + conns[i].timeout_ms / 2);
+    t1 = now_ns();
+    print_row("reset-earlier", wheel_earlier, (double)(t1 - t0) / n);
+
+    // 取消再设置回去（每次取一个"随机"连接，模拟任意位置的删除）
+    t0 = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        bench_conn_t* c = &conns[(i * 2654435761u) % n];
+        timing_wheel_cancel(&wheel, &c->timer);
+        timing_wheel_set(&wheel, &c->timer, c->timeout_ms);
+    }
+    t1 = now_ns();
+    double wheel_cancel = (double)(t1 - t0) / n;
+    t0 = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        bench_conn_t* c = &conns[(i * 2654435761u) % n];
+        heap_cancel(&heap, c);
+        heap_set(&heap, c, sim_ms + c->timeout_ms);
+    }
+    t1 = now_ns();
+    print_row("cancel+add", wheel_cancel, (double)(t1 - t0) / n);
+
+    // 逐tick推进直到全部到期
+    uint64_t wheel_total = 0, wheel_max_tick = 0, heap_total = 0, heap_max_tick = 0;
+    size_t ticks = 0;
+    g_fired = 0;
+    for (uint64_t ms = sim_ms; wheel.count > 0; ms += wheel.tick_ms, ticks++) {
+        t0 = now_ns();
+        timing_wheel_advance(&wheel, ms);
+        t1 = now_ns();
+        wheel_total += t1 - t0;
+        if (t1 - t0 > wheel_max_tick) wheel_max_tick = t1 - t0;
+    }
+    uint64_t wheel_fired = g_fired;
+    g_fired = 0;
+    for (uint64_t ms = sim_ms; heap.size > 0; ms += wheel.tick_ms) {
+        t0 = now_ns();
+        heap_expire(&heap, ms);
+        t1 = now_ns();
+        heap_total += t1 - t0;
+        if (t1 - t0 > heap_max_tick) heap_max_tick = t1 - t0;
+    }
+    print_row("expire", (double)wheel_total / (wheel_fired ? wheel_fired : 1),
+              (double)heap_total / (g_fired ? g_fired : 1));
+    printf("\nexpire: %zu ticks, fired wheel %llu / heap %llu, max single tick: wheel %.1f us, heap %.1f us\n",
+           ticks, (unsigned long long)wheel_fired, (unsigned long long)g_fired,
+           wheel_max_tick / 1000.0, heap_max_tick / 1000.0);
+
+    timing_wheel_destroy(&wheel);
+    free(heap.items);
+    free(conns);
+    return 0;
+}
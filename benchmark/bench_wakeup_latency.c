@@ -0,0 +1,175 @@
+// bench_wakeup_latency.c
+// 空闲等待策略对比：队列变空后直接休眠（park） vs 先自旋/让出CPU再休眠（adaptive）
+// 编译: gcc -std=gnu11 -O2 -I../serverModel bench_wakeup_latency.c -o bench_wakeup_latency -pthread
+// 运行: ./bench_wakeup_latency [线程数] [每个速率的秒数] [自旋上限微秒]
+// 说明:
+//  - 单个提交线程按固定速率（10k ~ 500k 任务/秒）匀速提交空任务，任务记录"提交 -> 开始执行"的延迟
+//  - park    : idle_spin_us = 0，队列一空就在futex上休眠（原实现），每个任务都要付出一次唤醒和上下文切换
+//  - adaptive: 按最近的到达间隔自旋，间隔短于自旋预算时worker在自旋中接到任务
+//  - cpu% 为整个进程的CPU时间占墙钟时间的比例（自旋的代价）；spin/park 为遥测中的两种等待结局次数
+//  - 只有一个CPU时线程池不自旋，adaptive只剩让出CPU的那几次复查
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "0_threadpool.h"
+
+#define DEFAULT_THREADS 4
+#define DEFAULT_SECONDS 1
+#define DEFAULT_SPIN_US DEFAULT_IDLE_SPIN_US
+#define MAX_SAMPLES 500000
+#define SLEEP_THRESHOLD_NS 200000 // 距下次提交超过该时长时nanosleep，否则忙等（保证提交节奏）
+
+typedef struct bench_ctx {
+    uint64_t* submit_ns;        // 每个任务的提交时间
+    uint64_t* latency_ns;       // 每个任务的提交到执行延迟
+    int done;                   // 已执行任务数（原子访问）
+} bench_ctx_t;
+
+static bench_ctx_t g_ctx;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t cpu_ns(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (uint64_t)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000000ull +
+           (uint64_t)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000ull;
+}
+
+/**
+ * @brief 任务：记录提交到开始执行的延迟
+ */
+static void record_task(void* arg) {
+    size_t i = (size_t)arg;
+    g_ctx.latency_ns[i] = now_ns() - __atomic_load_n(&g_ctx.submit_ns[i], __ATOMIC_ACQUIRE);
+    __atomic_add_fetch(&g_ctx.done, 1, __ATOMIC_RELEASE);
+}
+
+static int cmp_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * @brief 等到指定时间（远时休眠，近时让出CPU忙等）
+ */
+static void wait_until(uint64_t t) {
+    uint64_t now;
+    while ((now = now_ns()) < t) {
+        if (t - now > SLEEP_THRESHOLD_NS) {
+            struct timespec ts = {0, (long)(t - now - SLEEP_THRESHOLD_NS / 2)};
+            nanosleep(&ts, NULL);
+        } else {
+            sched_yield(); // 多核时立即返回；单核时让worker有机会执行
+        }
+    }
+}
+
+/**
+ * @brief 以固定速率提交任务并统计延迟分位数
+ * @param rate 每秒任务数
+ */
+static void run_case(const char* name, thread_pool_t* pool, int rate, int seconds) {
+    thread_pool_telemetry_t before;
+    int have_tm = thread_pool_get_telemetry(pool, &before) == 0;
+    size_t n = (size_t)rate * seconds;
+    if (n > MAX_SAMPLES) n = MAX_SAMPLES;
+    uint64_t interval = 1000000000ull / (uint64_t)rate;
+    __atomic_store_n(&g_ctx.done, 0, __ATOMIC_RELAXED);
+    usleep(10000); // 让worker先进入空闲状态
+
+    uint64_t wall_start = now_ns();
+    uint64_t cpu_start = cpu_ns();
+    uint64_t next = wall_start;
+    for (size_t i = 0; i < n; i++) {
+        wait_until(next);
+        next += interval;
+        __atomic_store_n(&g_ctx.submit_ns[i], now_ns(), __ATOMIC_RELEASE);
+        while (thread_pool_add_task(pool, record_task, (void*)i) < 0) {
+            sched_yield();
+        }
+    }
+    while (__atomic_load_n(&g_ctx.done, __ATOMIC_ACQUIRE) < (int)n) {
+        sched_yield();
+    }
+    double wall = (double)(now_ns() - wall_start);
+    double cpu = (double)(cpu_ns() - cpu_start);
+
+    thread_pool_telemetry_t after;
+    thread_pool_get_telemetry(pool, &after);
+    qsort(g_ctx.latency_ns, n, sizeof(uint64_t), cmp_u64);
+    printf("%8d %-9s %9.1f %9.1f %9.1f %9.1f %7.0f%%",
+           rate, name,
+           g_ctx.latency_ns[n / 2] / 1000.0,
+           g_ctx.latency_ns[n * 90 / 100] / 1000.0,
+           g_ctx.latency_ns[n * 99 / 100] / 1000.0,
+           g_ctx.latency_ns[n * 999 / 1000] / 1000.0,
+           100.0 * cpu / wall);
+    if (have_tm) {
+        printf(" %9llu %9llu\n", (unsigned long long)(after.spin_hits - before.spin_hits),
+               (unsigned long long)(after.parks - before.parks));
+    } else {
+        printf(" %9s %9s\n", "-", "-");
+    }
+    fflush(stdout);
+}
+
+static thread_pool_t* create_pool(int threads, int spin_us) {
+    thread_pool_config_t cfg;
+    thread_pool_config_init(&cfg);
+    cfg.min_threads = cfg.max_threads = threads;
+    cfg.max_task = 0;
+    cfg.idle_spin_us = spin_us;
+    thread_pool_t* pool = thread_pool_create_ex(&cfg);
+    if (!pool) {
+        fprintf(stderr, "create thread pool failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return pool;
+}
+
+int main(int argc, char* argv[]) {
+    int threads = argc >= 2 ? atoi(argv[1]) : DEFAULT_THREADS;
+    int seconds = argc >= 3 ? atoi(argv[2]) : DEFAULT_SECONDS;
+    int spin_us = argc >= 4 ? atoi(argv[3]) : DEFAULT_SPIN_US;
+    if (threads <= 0) threads = DEFAULT_THREADS;
+    if (seconds <= 0) seconds = DEFAULT_SECONDS;
+    if (spin_us <= 0) spin_us = DEFAULT_SPIN_US;
+
+    g_ctx.submit_ns = (uint64_t*)calloc(MAX_SAMPLES, sizeof(uint64_t));
+    g_ctx.latency_ns = (uint64_t*)calloc(MAX_SAMPLES, sizeof(uint64_t));
+    if (!g_ctx.submit_ns || !g_ctx.latency_ns) {
+        fprintf(stderr, "malloc failed\n");
+        return 1;
+    }
+
+    static const int rates[] = {10000, 50000, 100000, 200000, 500000};
+    thread_pool_t* park_pool = create_pool(threads, 0);
+    thread_pool_t* adaptive_pool = create_pool(threads, spin_us);
+    printf("cpus: %ld, threads: %d, spin limit: %d us, %d s per rate\n",
+           sysconf(_SC_NPROCESSORS_ONLN), threads, spin_us, seconds);
+    printf("\n%8s %-9s %9s %9s %9s %9s %8s %9s %9s\n",
+           "rate/s", "mode", "p50(us)", "p90(us)", "p99(us)", "p999(us)", "cpu", "spin", "park");
+    for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        run_case("park", park_pool, rates[r], seconds);
+        run_case("adaptive", adaptive_pool, rates[r], seconds);
+    }
+
+    thread_pool_destroy(park_pool, 0);
+    thread_pool_destroy(adaptive_pool, 0);
+
+    free(g_ctx.submit_ns);
+    free(g_ctx.latency_ns);
+    return 0;
+}
@@ -0,0 +1,128 @@
+#ifndef _CONN_TABLE_H_
+#define _CONN_TABLE_H_
+
+// 按fd索引的连接表（slab）：启动时一次性分配 fd上限 个连接槽，建立/关闭连接只是取用/归还槽，不调用malloc/free
+// fd是内核分配的最小可用编号，天然是一个紧凑的索引；同一时刻一个fd只属于一个连接，所以一个fd一个槽
+// 每个槽有一个代数（generation）：取用和归还时各+1（奇数表示使用中）。epoll事件里登记的是 代数<<32 | fd，
+// 连接关闭、fd被新连接复用之后，旧连接残留的事件（同一轮epoll_wait中已经取到的）代数对不上，查找时返回NULL
+// 使用方的连接结构体必须以 conn_slot_t 开头；槽中其余字段在归还后保留（例如缓冲区），由使用方决定如何复用
+// 多个Reactor线程可以共享一张表：每个槽同一时刻只由持有该fd的线程访问，代数用原子操作读写；
+// 归还（release）与下一次取用（acquire）之间的内存顺序由代数的 release/acquire 保证
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/resource.h>
+
+// ====================== 配置参数 ======================
+#define CONN_TABLE_MAX_FDS (1u << 20)   // 槽数上限（RLIMIT_NOFILE 更大时按此截断）
+
+// ====================== 结构体 ======================
+/**
+ * @brief 连接槽头部（嵌入在使用方连接结构体的开头）
+ */
+typedef struct conn_slot_s {
+    uint32_t gen;               // 代数（奇数表示使用中，原子访问）
+    int fd;
+} conn_slot_t;
+
+/**
+ * @brief 连接表
+ * @note 槽数组用calloc一次分配：大块内存由mmap提供，没用到的页不占物理内存
+ */
+typedef struct conn_table_s {
+    char* slots;
+    size_t slot_size;           // 每个槽的字节数（使用方连接结构体的大小）
+    size_t capacity;            // 槽数（fd < capacity 才能放入）
+    int max_fd;                 // 用过的最大fd（-1表示没有，原子访问），遍历时只需扫到这里
+} conn_table_t;
+
+// ====================== 接口 ======================
+/**
+ * @brief 初始化连接表
+ * @param slot_size 使用方连接结构体的大小（必须以 conn_slot_t 开头）
+ * @param capacity 槽数（0表示取 RLIMIT_NOFILE 的软上限，不超过 CONN_TABLE_MAX_FDS）
+ * @return 成功返回0，失败返回-1
+ */
+static inline int conn_table_init(conn_table_t* table, size_t slot_size, size_t capacity) {
+    memset(table, 0, sizeof(*table));
+    if (capacity == 0) {
+        struct rlimit rl;
+        capacity = (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY) ?
+                   (size_t)rl.rlim_cur : CONN_TABLE_MAX_FDS;
+    }
+    if (capacity > CONN_TABLE_MAX_FDS) capacity = CONN_TABLE_MAX_FDS;
+    table->slot_size = (slot_size + 7) & ~(size_t)7;
+    table->slots = (char*)calloc(capacity, table->slot_size);
+    if (!table->slots) return -1;
+    table->capacity = capacity;
+    table->max_fd = -1;
+    return 0;
+}
+
+/**
+ * @brief 释放槽数组（槽中使用方自己管理的资源需先遍历释放）
+ */
+static inline void conn_table_destroy(conn_table_t* table) {
+    free(table->slots);
+    table->slots = NULL;
+    table->capacity = 0;
+}
+
+/**
+ * @brief fd对应的槽（不检查是否使用中）
+ * @return fd超出范围返回NULL
+ */
+static inline void* conn_table_slot(const conn_table_t* table, int fd) {
+    if (fd < 0 || (size_t)fd >= table->capacity) return NULL;
+    return table->slots + (size_t)fd * table->slot_size;
+}
+
+/**
+ * @brief 取用fd对应的槽（代数+1，进入使用中）
+ * @return 槽指针（槽中上一个连接留下的字段保持不变）；fd超出范围或槽正在使用返回NULL
+ */
+static inline void* conn_table_acquire(conn_table_t* table, int fd) {
+    conn_slot_t* slot = (conn_slot_t*)conn_table_slot(table, fd);
+    if (!slot) return NULL;
+    uint32_t gen = __atomic_load_n(&slot->gen, __ATOMIC_ACQUIRE);
+    if (gen & 1) return NULL;
+    slot->fd = fd;
+    __atomic_store_n(&slot->gen, gen + 1, __ATOMIC_RELAXED);
+    int max_fd = __atomic_load_n(&table->max_fd, __ATOMIC_RELAXED);
+    while (fd > max_fd &&
+           !__atomic_compare_exchange_n(&table->max_fd, &max_fd, fd, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    return slot;
+}
+
+/**
+ * @brief 归还槽（代数+1，之前登记的事件全部失效）
+ * @note 必须在 close(fd) 之前调用：fd关闭后可能立刻被其他线程的accept复用并取用同一个槽
+ */
+static inline void conn_table_release(conn_table_t* table, void* slot) {
+    (void)table;
+    conn_slot_t* s = (conn_slot_t*)slot;
+    __atomic_store_n(&s->gen, s->gen + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief 登记到epoll的事件数据：代数<<32 | fd
+ */
+static inline uint64_t conn_table_key(const void* slot) {
+    const conn_slot_t* s = (const conn_slot_t*)slot;
+    return ((uint64_t)__atomic_load_n(&s->gen, __ATOMIC_RELAXED) << 32) | (uint32_t)s->fd;
+}
+
+/**
+ * @brief 由事件数据找到连接
+ * @return 槽指针；连接已关闭或fd已被新连接复用（代数不同）返回NULL
+ */
+static inline void* conn_table_lookup(const conn_table_t* table, uint64_t key) {
+    conn_slot_t* slot = (conn_slot_t*)conn_table_slot(table, (int)(uint32_t)key);
+    if (!slot || __atomic_load_n(&slot->gen, __ATOMIC_ACQUIRE) != (uint32_t)(key >> 32)) return NULL;
+    return slot;
+}
+
+#endif // _CONN_TABLE_H_
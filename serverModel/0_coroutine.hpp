@@ -0,0 +1,640 @@
+#ifndef _COROUTINE_HPP_
+#define _COROUTINE_HPP_
+
+// C++20协程支持：CoTask<T> + 在ThreadPool上恢复的awaitable + 基于epoll就绪通知的异步socket
+// 需要以 -std=c++20 编译（线程池本身仍是C++17）
+
+#if __cplusplus < 202002L
+#error "0_coroutine.hpp requires C++20"
+#endif
+
+#include "0_threadPool.hpp"
+#include <coroutine>
+#include <system_error>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+// ====================== 协程帧内存池 ======================
+/**
+ * @brief 协程帧分配器：按大小分级的空闲链表，线程本地缓存 + 全局空闲链表
+ * @note 协程帧常在一个worker上创建、在另一个worker上结束，本地缓存超过上限时成批归还全局链表，
+ *       缓存为空时成批从全局链表取，与C线程池的任务节点缓存相同。超过最大分级的帧直接走 operator new
+ */
+class FramePool {
+public:
+    static constexpr size_t kMinShift = 6;      // 最小分级64字节
+    static constexpr size_t kClasses = 7;       // 64, 128, ..., 4096 字节
+    static constexpr size_t kCacheMax = 64;     // 每级线程本地缓存上限
+    static constexpr size_t kBatch = 32;        // 本地缓存与全局链表之间每次搬运的块数
+
+    static void* allocate(size_t n) {
+        size_t cls = classOf(n);
+        if (cls == kClasses) return ::operator new(n);
+        Cache& c = cache();
+        if (!c.lists[cls]) refill(c, cls);
+        Node* node = c.lists[cls];
+        if (!node) return ::operator new(classSize(cls));
+        c.lists[cls] = node->next;
+        --c.counts[cls];
+        return node;
+    }
+
+    static void deallocate(void* p, size_t n) {
+        size_t cls = classOf(n);
+        if (cls == kClasses) {
+            ::operator delete(p);
+            return;
+        }
+        Cache& c = cache();
+        Node* node = static_cast<Node*>(p);
+        node->next = c.lists[cls];
+        c.lists[cls] = node;
+        if (++c.counts[cls] > kCacheMax) flush(c, cls, kCacheMax - kBatch);
+    }
+
+private:
+    struct Node {
+        Node* next;
+    };
+
+    struct Global {
+        std::mutex mutex;
+        Node* lists[kClasses] = {};
+    };
+
+    struct Cache {
+        Node* lists[kClasses] = {};
+        size_t counts[kClasses] = {};
+
+        ~Cache() {
+            for (size_t cls = 0; cls < kClasses; ++cls) flush(*this, cls, 0); // 线程退出：全部归还
+        }
+    };
+
+    static size_t classSize(size_t cls) {
+        return size_t(1) << (cls + kMinShift);
+    }
+
+    static size_t classOf(size_t n) {
+        for (size_t cls = 0; cls < kClasses; ++cls) {
+            if (n <= classSize(cls)) return cls;
+        }
+        return kClasses;
+    }
+
+    static Global& global() {
+        static Global* g = new Global(); // 不析构：线程本地缓存析构时仍要归还
+        return *g;
+    }
+
+    static Cache& cache() {
+        static thread_local Cache c;
+        return c;
+    }
+
+    static void refill(Cache& c, size_t cls) {
+        Global& g = global();
+        std::lock_guard<std::mutex> lock(g.mutex);
+        for (size_t i = 0; i < kBatch && g.lists[cls]; ++i) {
+            Node* node = g.lists[cls];
+            g.lists[cls] = node->next;
+            node->next = c.lists[cls];
+            c.lists[cls] = node;
+            ++c.counts[cls];
+        }
+    }
+
+    /**
+     * @brief 把本地缓存归还到只剩keep块
+     */
+    static void flush(Cache& c, size_t cls, size_t keep) {
+        if (c.counts[cls] <= keep) return;
+        Node* first = c.lists[cls];
+        Node* last = first;
+        for (size_t i = c.counts[cls] - keep; i > 1; --i) last = last->next;
+        c.lists[cls] = last->next;
+        c.counts[cls] = keep;
+        Global& g = global();
+        std::lock_guard<std::mutex> lock(g.mutex);
+        last->next = g.lists[cls];
+        g.lists[cls] = first;
+    }
+};
+
+/**
+ * @brief 让promise_type的协程帧从FramePool分配
+ */
+struct PooledFrame {
+    static void* operator new(size_t n) {
+        return FramePool::allocate(n);
+    }
+    static void operator delete(void* p, size_t n) {
+        FramePool::deallocate(p, n);
+    }
+};
+
+// ====================== CoTask ======================
+template <typename T = void>
+class CoTask;
+
+namespace coro_detail {
+
+/**
+ * @brief CoTask的promise公共部分：结束时对称转移到等待者（没有等待者则挂起）
+ */
+struct PromiseBase : PooledFrame {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+            std::coroutine_handle<> next = h.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    CoTask<T> get_return_object() noexcept;
+    template <typename U>
+    void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+
+    T result() {
+        if (error) std::rethrow_exception(error);
+        return std::move(*value);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    CoTask<void> get_return_object() noexcept;
+    void return_void() noexcept {}
+
+    void result() {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+/**
+ * @brief co_spawn使用的分离协程：结束时自行释放帧
+ */
+struct Detached {
+    struct promise_type : PooledFrame {
+        Detached get_return_object() noexcept {
+            return Detached{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+    std::coroutine_handle<promise_type> handle;
+};
+
+} // namespace coro_detail
+
+/**
+ * @brief 惰性协程任务：创建时不执行，被 co_await 时才开始，结束后恢复等待它的协程
+ * @tparam T 结果类型
+ * @note 只能移动；被 co_await 一次。协程帧由FramePool分配，CoTask析构时释放
+ */
+template <typename T>
+class CoTask {
+public:
+    using promise_type = coro_detail::Promise<T>;
+
+    CoTask() noexcept = default;
+    explicit CoTask(std::coroutine_handle<promise_type> h) noexcept : handle(h) {}
+    CoTask(CoTask&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    CoTask& operator=(CoTask&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    CoTask(const CoTask&) = delete;
+    CoTask& operator=(const CoTask&) = delete;
+    ~CoTask() {
+        if (handle) handle.destroy();
+    }
+
+    /**
+     * @brief 等待任务完成：对称转移到任务协程，任务结束时直接转回（不经过线程池）
+     */
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+            bool await_ready() const noexcept { return !handle || handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+                handle.promise().continuation = caller;
+                return handle;
+            }
+            T await_resume() { return handle.promise().result(); }
+        };
+        return Awaiter{handle};
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+namespace coro_detail {
+
+template <typename T>
+CoTask<T> Promise<T>::get_return_object() noexcept {
+    return CoTask<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline CoTask<void> Promise<void>::get_return_object() noexcept {
+    return CoTask<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+/**
+ * @brief 在线程池上恢复协程；线程池拒绝（已停止或队列满且策略为Reject）时在当前线程恢复
+ */
+inline void resumeOn(ThreadPool& pool, std::coroutine_handle<> h) {
+    SubmitResult r = pool.submit([h]{ h.resume(); });
+    if (r != SubmitResult::Enqueued && r != SubmitResult::RanInline) h.resume();
+}
+
+template <typename T>
+Detached runDetached(CoTask<T> task) {
+    try {
+        co_await std::move(task);
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+    }
+}
+
+} // namespace coro_detail
+
+/**
+ * @brief 切换到线程池：co_await schedule(pool) 之后的代码在pool的worker上执行
+ * @note 线程池拒绝时继续在当前线程执行
+ */
+inline auto schedule(ThreadPool& pool) noexcept {
+    struct Awaiter {
+        ThreadPool& pool;
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> h) {
+            // 提交成功后协程可能已在其他worker上恢复，之后不能再访问this
+            SubmitResult r = pool.submit([h]{ h.resume(); });
+            return r == SubmitResult::Enqueued || r == SubmitResult::RanInline;
+        }
+        void await_resume() const noexcept {}
+    };
+    return Awaiter{pool};
+}
+
+/**
+ * @brief 在线程池上启动一个分离的协程任务（不等待结果，异常打印到stderr）
+ */
+template <typename T>
+void co_spawn(ThreadPool& pool, CoTask<T> task) {
+    coro_detail::Detached d = coro_detail::runDetached(std::move(task));
+    coro_detail::resumeOn(pool, d.handle);
+}
+
+// ====================== 基于epoll的I/O调度 ======================
+class AsyncSocket;
+
+/**
+ * @brief epoll就绪通知线程：socket就绪时把等待它的协程交给线程池恢复
+ * @note 每个fd以EPOLLONESHOT注册，只在有协程等待时才按等待方向布防；
+ *       等待方先尝试非阻塞调用，返回EAGAIN后才挂起，worker线程不会阻塞在I/O上
+ * @note 关闭顺序：stop() -> 线程池 shudown()（被取消的协程在此期间结束并注销socket） -> 析构IoContext
+ */
+class IoContext {
+public:
+    explicit IoContext(ThreadPool& pool) : pool_(pool) {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0) throw std::system_error(errno, std::generic_category(), "epoll_create1");
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeFd < 0) {
+            int err = errno;
+            ::close(epollFd);
+            throw std::system_error(err, std::generic_category(), "eventfd");
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr; // nullptr表示wakeFd
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+        loopThread = std::thread([this]{ loop(); });
+    }
+
+    ~IoContext() {
+        stop();
+        ::close(wakeFd);
+        ::close(epollFd);
+    }
+
+    IoContext(const IoContext&) = delete;
+    IoContext& operator=(const IoContext&) = delete;
+
+    ThreadPool& pool() { return pool_; }
+
+    /**
+     * @brief 停止就绪通知线程，并以ECANCELED恢复所有正在等待I/O的协程（在线程池上）
+     * @note 之后的I/O等待立即以ECANCELED返回；应在线程池关闭之前调用
+     */
+    void stop();
+
+private:
+    friend class AsyncSocket;
+
+    /**
+     * @brief 每个socket的等待状态（内嵌在AsyncSocket中，地址作为epoll的data.ptr）
+     */
+    struct IoState {
+        int fd = -1;
+        std::mutex mutex;
+        std::coroutine_handle<> reader;     // 等待可读的协程
+        std::coroutine_handle<> writer;     // 等待可写的协程
+        int readError = 0;                  // 交给恢复后的等待方的错误码
+        int writeError = 0;
+        IoState* prev = nullptr;            // 已注册socket的链表（受registryMutex保护）
+        IoState* next = nullptr;
+    };
+
+    static constexpr int kMaxEvents = 64;
+
+    ThreadPool& pool_;
+    int epollFd = -1;
+    int wakeFd = -1;
+    std::thread loopThread;
+    std::atomic<bool> stopping{false};
+    std::mutex registryMutex;
+    IoState* registry = nullptr;
+
+    void add(IoState* s) {
+        epoll_event ev{};
+        ev.events = EPOLLONESHOT; // 先不布防
+        ev.data.ptr = s;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, s->fd, &ev) != 0) {
+            throw std::system_error(errno, std::generic_category(), "epoll_ctl add");
+        }
+        std::lock_guard<std::mutex> lock(registryMutex);
+        s->next = registry;
+        if (registry) registry->prev = s;
+        registry = s;
+    }
+
+    void remove(IoState* s) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, s->fd, nullptr);
+        std::lock_guard<std::mutex> lock(registryMutex);
+        if (s->prev) s->prev->next = s->next;
+        else registry = s->next;
+        if (s->next) s->next->prev = s->prev;
+        s->prev = s->next = nullptr;
+    }
+
+    /**
+     * @brief 按当前等待者重新布防（需持有s->mutex）
+     * @return 成功返回0，失败返回errno
+     */
+    int armLocked(IoState* s) {
+        uint32_t events = 0;
+        if (s->reader) events |= EPOLLIN | EPOLLRDHUP;
+        if (s->writer) events |= EPOLLOUT;
+        if (events == 0) return 0; // ONESHOT触发后已自动撤防
+        epoll_event ev{};
+        ev.events = events | EPOLLONESHOT;
+        ev.data.ptr = s;
+        return epoll_ctl(epollFd, EPOLL_CTL_MOD, s->fd, &ev) == 0 ? 0 : errno;
+    }
+
+    /**
+     * @brief 登记等待方并布防
+     * @return 已挂起返回true；已停止或布防失败返回false（错误码写入error，调用方不挂起）
+     * @note 返回true之后协程可能已在其他worker上恢复，调用方不能再访问自己的帧
+     */
+    bool wait(IoState* s, bool forWrite, std::coroutine_handle<> h, int& error) {
+        std::lock_guard<std::mutex> lock(s->mutex);
+        if (stopping.load(std::memory_order_acquire)) {
+            error = ECANCELED;
+            return false;
+        }
+        std::coroutine_handle<>& slot = forWrite ? s->writer : s->reader;
+        int& slotError = forWrite ? s->writeError : s->readError;
+        slot = h;
+        slotError = 0;
+        int err = armLocked(s);
+        if (err != 0) {
+            slot = nullptr;
+            error = err;
+            return false;
+        }
+        return true;
+    }
+
+    void loop() {
+        epoll_event events[kMaxEvents];
+        while (!stopping.load(std::memory_order_acquire)) {
+            int n = epoll_wait(epollFd, events, kMaxEvents, -1);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                perror("epoll_wait");
+                break;
+            }
+            for (int i = 0; i < n; ++i) {
+                IoState* s = static_cast<IoState*>(events[i].data.ptr);
+                if (!s) {
+                    uint64_t value;
+                    while (read(wakeFd, &value, sizeof(value)) > 0) {}
+                    continue;
+                }
+                dispatch(s, events[i].events);
+            }
+        }
+    }
+
+    /**
+     * @brief 取出就绪方向的等待者并恢复；另一方向仍有等待者时重新布防
+     * @note 解锁后不再访问s：被恢复的协程可能随即销毁socket
+     */
+    void dispatch(IoState* s, uint32_t events) {
+        std::coroutine_handle<> reader, writer;
+        {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) reader = std::exchange(s->reader, nullptr);
+            if (events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) writer = std::exchange(s->writer, nullptr);
+            int err = armLocked(s);
+            if (err != 0) {
+                // 布防失败：剩下的等待者也带着错误恢复
+                if (s->reader) {
+                    s->readError = err;
+                    reader = std::exchange(s->reader, nullptr);
+                }
+                if (s->writer) {
+                    s->writeError = err;
+                    writer = std::exchange(s->writer, nullptr);
+                }
+            }
+        }
+        if (reader) coro_detail::resumeOn(pool_, reader);
+        if (writer) coro_detail::resumeOn(pool_, writer);
+    }
+};
+
+/**
+ * @brief 非阻塞socket的协程接口（构造时接管fd并注册到IoContext，析构时注销并关闭）
+ * @note 不可移动（地址注册在epoll中）。同一时刻每个方向最多一个协程在等待；
+ *       有协程在等待时不能析构（IoContext::stop 会先以ECANCELED恢复它们）
+ * @note 出错时返回负的errno（协程恢复后可能换了线程，errno不可靠）
+ */
+class AsyncSocket {
+public:
+    AsyncSocket(IoContext& io, int fd) : io(io) {
+        int flags = fcntl(fd, F_GETFL, 0);
+        if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+            throw std::system_error(errno, std::generic_category(), "fcntl");
+        }
+        state.fd = fd;
+        io.add(&state);
+    }
+
+    ~AsyncSocket() {
+        close();
+    }
+
+    AsyncSocket(const AsyncSocket&) = delete;
+    AsyncSocket& operator=(const AsyncSocket&) = delete;
+
+    int fd() const { return state.fd; }
+
+    /**
+     * @brief 注销并关闭socket（重复调用无效）
+     */
+    void close() {
+        if (state.fd < 0) return;
+        io.remove(&state);
+        ::close(state.fd);
+        state.fd = -1;
+    }
+
+    /**
+     * @brief 等待可读/可写（co_await 返回0或错误码）
+     */
+    auto readable() noexcept { return ReadyAwaiter{this, false, 0}; }
+    auto writable() noexcept { return ReadyAwaiter{this, true, 0}; }
+
+    /**
+     * @brief 读取数据（有数据即返回）
+     * @return 读到的字节数；0表示对端关闭；负值为 -errno
+     */
+    CoTask<ssize_t> async_read(void* buf, size_t len) {
+        while (true) {
+            ssize_t n = ::recv(state.fd, buf, len, 0);
+            if (n >= 0) co_return n;
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) co_return -errno;
+            int err = co_await readable();
+            if (err != 0) co_return -err;
+        }
+    }
+
+    /**
+     * @brief 写出全部数据（发送缓冲区满时挂起等待可写）
+     * @return 写出的字节数（等于len）；负值为 -errno
+     */
+    CoTask<ssize_t> async_write(const void* buf, size_t len) {
+        const char* p = static_cast<const char*>(buf);
+        size_t sent = 0;
+        while (sent < len) {
+            ssize_t n = ::send(state.fd, p + sent, len - sent, MSG_NOSIGNAL);
+            if (n >= 0) {
+                sent += static_cast<size_t>(n);
+                continue;
+            }
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) co_return -errno;
+            int err = co_await writable();
+            if (err != 0) co_return -err;
+        }
+        co_return static_cast<ssize_t>(sent);
+    }
+
+    /**
+     * @brief 接受新连接（监听socket）
+     * @param addr 输出对端地址（可为nullptr）
+     * @return 新连接的fd（已设为非阻塞）；负值为 -errno
+     */
+    CoTask<int> async_accept(sockaddr_in* addr = nullptr) {
+        while (true) {
+            socklen_t addrLen = sizeof(sockaddr_in);
+            int fd = ::accept4(state.fd, reinterpret_cast<sockaddr*>(addr), addr ? &addrLen : nullptr,
+                               SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd >= 0) co_return fd;
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) co_return -errno;
+            int err = co_await readable();
+            if (err != 0) co_return -err;
+        }
+    }
+
+private:
+    friend class IoContext;
+
+    struct ReadyAwaiter {
+        AsyncSocket* sock;
+        bool forWrite;
+        int error;
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> h) {
+            return sock->io.wait(&sock->state, forWrite, h, error);
+        }
+        int await_resume() const noexcept {
+            // 挂起期间的错误由IoContext写入IoState（恢复时已不再被其他线程访问）
+            if (error != 0) return error;
+            return forWrite ? sock->state.writeError : sock->state.readError;
+        }
+    };
+
+    IoContext& io;
+    IoContext::IoState state;
+};
+
+inline void IoContext::stop() {
+    if (stopping.exchange(true, std::memory_order_acq_rel)) return;
+    uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) < 0) perror("eventfd write");
+    if (loopThread.joinable()) loopThread.join();
+
+    // 取出所有等待者后再恢复：恢复的协程会析构socket并注销（需要registryMutex）
+    std::vector<std::coroutine_handle<>> waiters;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (IoState* s = registry; s; s = s->next) {
+            std::lock_guard<std::mutex> stateLock(s->mutex);
+            if (s->reader) {
+                s->readError = ECANCELED;
+                waiters.push_back(std::exchange(s->reader, nullptr));
+            }
+            if (s->writer) {
+                s->writeError = ECANCELED;
+                waiters.push_back(std::exchange(s->writer, nullptr));
+            }
+        }
+    }
+    for (std::coroutine_handle<> h : waiters) coro_detail::resumeOn(pool_, h);
+}
+
+#endif // _COROUTINE_HPP_
@@ -0,0 +1,341 @@
+#ifndef _CPU_TOPOLOGY_H_
+#define _CPU_TOPOLOGY_H_
+
+// CPU拓扑与NUMA辅助函数（线程池绑核 / 按节点分配内存）
+// 拓扑信息来自 /sys/devices/system，内存策略直接走系统调用，不依赖libnuma
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // CPU_SET / pthread_setaffinity_np 需要
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// ====================== 配置参数 ======================
+#define CPU_TOPOLOGY_MAX_NODES 64   // 支持的最大NUMA节点数
+
+// ====================== 绑核策略 ======================
+/**
+ * @brief 工作线程绑核策略
+ */
+typedef enum {
+    AFFINITY_NONE = 0,          // 不绑核，由内核调度
+    AFFINITY_COMPACT = 1,       // 紧凑：先占满一个节点（同一物理核的超线程相邻），适合共享缓存的任务
+    AFFINITY_SCATTER = 2,       // 分散：依次轮转各节点、各物理核，最后才用超线程，适合内存带宽密集的任务
+    AFFINITY_CPU_LIST = 3,      // 按用户给定的CPU列表依次绑定
+    AFFINITY_NUMA_NODE = 4,     // 绑定到某个NUMA节点的全部CPU（节点内由内核调度）
+} affinity_policy_t;
+
+// ====================== 拓扑结构体 ======================
+/**
+ * @brief 单个逻辑CPU的位置
+ */
+typedef struct cpu_info {
+    int cpu;                    // 逻辑CPU编号
+    int core;                   // 物理核编号（core_id，同一封装内唯一）
+    int package;                // 封装（socket）编号
+    int node;                   // NUMA节点编号
+} cpu_info_t;
+
+/**
+ * @brief 当前进程可用CPU的拓扑（只包含 sched_getaffinity 允许的CPU）
+ */
+typedef struct cpu_topology {
+    cpu_info_t* cpus;           // 按CPU编号升序
+    int num_cpus;               // 可用CPU数
+    int num_nodes;              // 包含可用CPU的NUMA节点数
+    int nodes[CPU_TOPOLOGY_MAX_NODES]; // 这些节点的编号（升序）
+} cpu_topology_t;
+
+// ====================== 内部函数 ======================
+/**
+ * @brief 读取sysfs中的整数
+ * @return 读取到的值，失败返回 def
+ */
+static inline int cpu_topology_read_int(const char* path, int def) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) return def;
+    int v = def;
+    if (fscanf(fp, "%d", &v) != 1) v = def;
+    fclose(fp);
+    return v;
+}
+
+/**
+ * @brief 解析CPU列表字符串（如 "0-3,8-11"），每个CPU调用一次回调
+ * @return 解析到的CPU数
+ */
+static inline int cpu_list_parse(const char* list, void (*fn)(int cpu, void* ctx), void* ctx) {
+    int count = 0;
+    const char* p = list;
+    while (*p) {
+        char* end;
+        long lo = strtol(p, &end, 10);
+        if (end == p) break;
+        long hi = lo;
+        p = end;
+        if (*p == '-') {
+            hi = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long c = lo; c <= hi; c++) {
+            fn((int)c, ctx);
+            count++;
+        }
+        while (*p == ',' || *p == ' ' || *p == '\n') p++;
+    }
+    return count;
+}
+
+struct cpu_node_ctx {
+    cpu_topology_t* topo;
+    int node;
+};
+
+static inline void cpu_topology_set_node(int cpu, void* arg) {
+    struct cpu_node_ctx* ctx = (struct cpu_node_ctx*)arg;
+    for (int i = 0; i < ctx->topo->num_cpus; i++) {
+        if (ctx->topo->cpus[i].cpu == cpu) {
+            ctx->topo->cpus[i].node = ctx->node;
+            return;
+        }
+    }
+}
+
+// ====================== 拓扑查询 ======================
+/**
+ * @brief 读取当前进程可用CPU的拓扑
+ * @param topo 输出拓扑（用完后调用 cpu_topology_free）
+ * @return 成功返回0，失败返回-1
+ * @note 无法读取sysfs时（容器等环境）退化为：每个CPU一个物理核、全部属于节点0
+ */
+static inline int cpu_topology_load(cpu_topology_t* topo) {
+    memset(topo, 0, sizeof(*topo));
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return -1;
+
+    int n = CPU_COUNT(&allowed);
+    topo->cpus = (cpu_info_t*)calloc(n > 0 ? n : 1, sizeof(cpu_info_t));
+    if (!topo->cpus) return -1;
+
+    char path[128];
+    for (int cpu = 0; cpu < CPU_SETSIZE && topo->num_cpus < n; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        cpu_info_t* info = &topo->cpus[topo->num_cpus++];
+        info->cpu = cpu;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+        info->core = cpu_topology_read_int(path, cpu);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+        info->package = cpu_topology_read_int(path, 0);
+        info->node = 0;
+    }
+
+    // 节点归属：遍历 /sys/devices/system/node/nodeN/cpulist
+    char buf[4096];
+    for (int node = 0; node < CPU_TOPOLOGY_MAX_NODES; node++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE* fp = fopen(path, "r");
+        if (!fp) continue;
+        if (fgets(buf, sizeof(buf), fp)) {
+            struct cpu_node_ctx ctx = {topo, node};
+            cpu_list_parse(buf, cpu_topology_set_node, &ctx);
+        }
+        fclose(fp);
+    }
+
+    for (int i = 0; i < topo->num_cpus; i++) {
+        int node = topo->cpus[i].node, seen = 0;
+        for (int j = 0; j < topo->num_nodes; j++) {
+            if (topo->nodes[j] == node) seen = 1;
+        }
+        if (!seen && topo->num_nodes < CPU_TOPOLOGY_MAX_NODES) {
+            int j = topo->num_nodes++;
+            while (j > 0 && topo->nodes[j - 1] > node) {
+                topo->nodes[j] = topo->nodes[j - 1];
+                j--;
+            }
+            topo->nodes[j] = node;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 释放拓扑
+ */
+static inline void cpu_topology_free(cpu_topology_t* topo) {
+    free(topo->cpus);
+    topo->cpus = NULL;
+    topo->num_cpus = 0;
+}
+
+static inline int cpu_info_compact_cmp(const void* a, const void* b) {
+    const cpu_info_t* x = (const cpu_info_t*)a;
+    const cpu_info_t* y = (const cpu_info_t*)b;
+    if (x->node != y->node) return x->node - y->node;
+    if (x->package != y->package) return x->package - y->package;
+    if (x->core != y->core) return x->core - y->core;
+    return x->cpu - y->cpu;
+}
+
+// 散列键：package字段存超线程序号，core字段存节点内物理核序号
+static inline int cpu_info_scatter_cmp(const void* a, const void* b) {
+    const cpu_info_t* x = (const cpu_info_t*)a;
+    const cpu_info_t* y = (const cpu_info_t*)b;
+    if (x->package != y->package) return x->package - y->package;
+    if (x->core != y->core) return x->core - y->core;
+    if (x->node != y->node) return x->node - y->node;
+    return x->cpu - y->cpu;
+}
+
+/**
+ * @brief 按绑核策略生成CPU顺序，第i个工作线程绑定到 out[i % 返回值]
+ * @param topo 拓扑
+ * @param policy AFFINITY_COMPACT 或 AFFINITY_SCATTER
+ * @param out 输出CPU编号，长度至少为 topo->num_cpus
+ * @return 输出的CPU数，失败返回-1
+ * @note SCATTER 的排序键为（超线程序号, 节点内物理核序号, 节点），
+ *       即先在各节点间轮转，再在节点内换物理核，最后才使用同核的超线程
+ */
+static inline int cpu_topology_order(const cpu_topology_t* topo, int policy, int* out) {
+    int n = topo->num_cpus;
+    cpu_info_t* sorted = (cpu_info_t*)malloc(sizeof(cpu_info_t) * (n > 0 ? n : 1));
+    if (!sorted) return -1;
+    memcpy(sorted, topo->cpus, sizeof(cpu_info_t) * n);
+    qsort(sorted, n, sizeof(cpu_info_t), cpu_info_compact_cmp);
+
+    if (policy != AFFINITY_SCATTER) {
+        for (int i = 0; i < n; i++) out[i] = sorted[i].cpu;
+        free(sorted);
+        return n;
+    }
+
+    // 紧凑顺序中同一物理核的超线程相邻、同一节点的物理核连续，
+    // 借用 core/package 字段存放（超线程序号, 节点内物理核序号）后按散列键重排
+    int prev_sibling = 0, prev_rank = 0;
+    cpu_info_t prev = {-1, -1, -1, -1};
+    for (int i = 0; i < n; i++) {
+        cpu_info_t cur = sorted[i];
+        int same_core = i > 0 && prev.node == cur.node && prev.package == cur.package && prev.core == cur.core;
+        int new_node = i == 0 || prev.node != cur.node;
+        int sibling = same_core ? prev_sibling + 1 : 0;
+        int rank = new_node ? 0 : (same_core ? prev_rank : prev_rank + 1);
+        sorted[i].package = sibling;
+        sorted[i].core = rank;
+        prev = cur;
+        prev_sibling = sibling;
+        prev_rank = rank;
+    }
+    qsort(sorted, n, sizeof(cpu_info_t), cpu_info_scatter_cmp);
+    for (int i = 0; i < n; i++) out[i] = sorted[i].cpu;
+    free(sorted);
+    return n;
+}
+
+/**
+ * @brief 获取某个NUMA节点在拓扑中的CPU集合
+ * @return 集合中的CPU数
+ */
+static inline int cpu_topology_node_cpus(const cpu_topology_t* topo, int node, cpu_set_t* set) {
+    CPU_ZERO(set);
+    int count = 0;
+    for (int i = 0; i < topo->num_cpus; i++) {
+        if (topo->cpus[i].node == node) {
+            CPU_SET(topo->cpus[i].cpu, set);
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief 查询CPU所在的NUMA节点
+ * @return 节点编号，找不到返回-1
+ */
+static inline int cpu_topology_node_of(const cpu_topology_t* topo, int cpu) {
+    for (int i = 0; i < topo->num_cpus; i++) {
+        if (topo->cpus[i].cpu == cpu) return topo->cpus[i].node;
+    }
+    return -1;
+}
+
+// ====================== 绑核 ======================
+/**
+ * @brief 将线程绑定到单个CPU
+ * @return 成功返回0，失败返回错误码
+ */
+static inline int cpu_bind_thread(pthread_t thread, int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(thread, sizeof(set), &set);
+}
+
+/**
+ * @brief 当前线程所在的NUMA节点
+ * @return 节点编号，失败返回-1
+ */
+static inline int cpu_current_node(void) {
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0) return -1;
+    return (int)node;
+}
+
+// ====================== NUMA内存策略 ======================
+#define NUMA_MPOL_DEFAULT 0     // 与 <linux/mempolicy.h> 的 MPOL_DEFAULT 一致
+#define NUMA_MPOL_PREFERRED 1   // 与 <linux/mempolicy.h> 的 MPOL_PREFERRED 一致
+
+/**
+ * @brief 保存的线程内存策略
+ */
+typedef struct numa_policy_save {
+    int mode;
+    unsigned long mask[CPU_TOPOLOGY_MAX_NODES / (8 * sizeof(unsigned long)) + 1];
+    int valid;
+} numa_policy_save_t;
+
+/**
+ * @brief 让调用线程此后首次触碰的页优先分配在指定节点上
+ * @param node NUMA节点编号
+ * @param save 保存原策略，供 numa_prefer_end 恢复
+ * @return 成功返回0，失败（内核不支持NUMA等）返回-1，此时不影响后续分配
+ * @note 策略只作用于调用线程；malloc返回的内存在首次写入时才真正分配物理页
+ */
+static inline int numa_prefer_begin(int node, numa_policy_save_t* save) {
+    memset(save, 0, sizeof(*save));
+    if (node < 0 || node >= CPU_TOPOLOGY_MAX_NODES) return -1;
+    if (syscall(SYS_get_mempolicy, &save->mode, save->mask,
+                (unsigned long)CPU_TOPOLOGY_MAX_NODES, NULL, 0UL) != 0) {
+        return -1;
+    }
+    unsigned long mask[CPU_TOPOLOGY_MAX_NODES / (8 * sizeof(unsigned long)) + 1];
+    memset(mask, 0, sizeof(mask));
+    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+    if (syscall(SYS_set_mempolicy, NUMA_MPOL_PREFERRED, mask,
+                (unsigned long)CPU_TOPOLOGY_MAX_NODES + 1) != 0) {
+        return -1;
+    }
+    save->valid = 1;
+    return 0;
+}
+
+/**
+ * @brief 恢复 numa_prefer_begin 之前的内存策略
+ */
+static inline void numa_prefer_end(numa_policy_save_t* save) {
+    if (!save->valid) return;
+    if (save->mode == NUMA_MPOL_DEFAULT) {
+        syscall(SYS_set_mempolicy, NUMA_MPOL_DEFAULT, NULL, 0UL);
+    } else {
+        syscall(SYS_set_mempolicy, save->mode, save->mask, (unsigned long)CPU_TOPOLOGY_MAX_NODES + 1);
+    }
+    save->valid = 0;
+}
+
+#endif // _CPU_TOPOLOGY_H_
@@ -0,0 +1,258 @@
+#ifndef _HTTP_PARSER_H_
+#define _HTTP_PARSER_H_
+
+// 增量式 HTTP/1.1 请求解析器（零拷贝）
+// 解析状态保存在连接中，数据每到一批就调用一次 http_parser_execute：
+//  - 头部阶段只从上次扫描到的位置继续找空行，请求被拆成很多次读入时总开销仍是O(n)；
+//  - 找到空行后一次解析请求行和所有头部，结果是相对请求起始位置的偏移（http_span_t），不拷贝字符串，
+//    读缓冲区扩容搬家之后仍然有效，用 HTTP_SPAN_PTR(base, span) 取得指向读缓冲区的视图；
+//  - 主体按 Content-Length 计算长度，数据到齐后返回整个请求的长度，调用方消费这么多字节后 http_parser_reset，
+//    缓冲区中剩余的字节就是下一个（流水线）请求的开头
+// 不支持 Transfer-Encoding（分块请求返回501），不支持头部折行（obs-fold，返回400）
+// 找空行和扫描方法名/头部名用 0_http_scan.h 的内核（启动时按CPU选择 AVX2 / SSE4.2 / 标量实现）
+
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/types.h>
+#include "0_http_scan.h"
+
+// ====================== 配置参数 ======================
+#define HTTP_MAX_HEADERS 64             // 单个请求最多的头部数（超过返回431）
+#define HTTP_MAX_HEADER_SIZE 16384      // 请求行 + 头部的最大字节数（超过返回431）
+
+// ====================== 结构体 ======================
+/**
+ * @brief 请求中的一段字符串：相对请求起始位置的偏移和长度
+ */
+typedef struct http_span_s {
+    uint32_t off;
+    uint32_t len;
+} http_span_t;
+
+#define HTTP_SPAN_PTR(base, span) ((const char*)(base) + (span).off)
+// 头部名是否为某个小写常量（见 http_name_equals）
+#define HTTP_NAME_IS(base, span, lower) http_name_equals(base, (span).off, (span).len, lower, sizeof(lower) - 1)
+
+typedef struct http_header_s {
+    http_span_t name;
+    http_span_t value;          // 已去掉首尾空白
+} http_header_t;
+
+/**
+ * @brief 解析结果（头部解析完成后有效）
+ */
+typedef struct http_request_s {
+    http_span_t method;
+    http_span_t target;         // 请求目标（路径 + 查询串）
+    int minor_version;          // HTTP/1.x 的 x
+    http_header_t headers[HTTP_MAX_HEADERS];
+    int num_headers;
+    size_t header_len;          // 请求行 + 头部 + 空行的字节数（主体从这里开始）
+    size_t content_length;
+    int keep_alive;             // 处理完是否保持连接（按版本默认值和 Connection 头部）
+} http_request_t;
+
+typedef enum {
+    HTTP_STATE_HEAD = 0,        // 等待头部结束的空行
+    HTTP_STATE_BODY,            // 头部已解析，等待主体到齐
+} http_state_t;
+
+/**
+ * @brief 解析器（嵌入在连接结构体中）
+ */
+typedef struct http_parser_s {
+    int state;                  // http_state_t
+    size_t scanned;             // 头部阶段已扫描过的字节数（下次从这里继续找空行）
+    size_t max_body;            // 主体上限（超过返回413，0表示不限）
+    int error;                  // 出错时建议的响应状态码（400/413/431/501）
+    http_request_t req;
+} http_parser_t;
+
+// ====================== 内部函数 ======================
+/**
+ * @brief 取一行（不含行尾的"\r\n"或"\n"）
+ * @return 下一行的起始位置
+ */
+static inline size_t http_next_line(const char* data, size_t pos, size_t end, size_t* line_end) {
+    const char* nl = (const char*)memchr(data + pos, '\n', end - pos);
+    size_t e = nl ? (size_t)(nl - data) : end;
+    *line_end = (e > pos && data[e - 1] == '\r') ? e - 1 : e;
+    return nl ? e + 1 : end;
+}
+
+static inline int http_span_equals(const char* base, http_span_t span, const char* str) {
+    size_t n = strlen(str);
+    return span.len == n && strncasecmp(base + span.off, str, n) == 0;
+}
+
+/**
+ * @brief 逗号分隔的值中是否有某个token（如 Connection: keep-alive, Upgrade）
+ */
+static inline int http_value_has_token(const char* base, http_span_t span, const char* token) {
+    size_t n = strlen(token);
+    const char* p = base + span.off;
+    const char* end = p + span.len;
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) p++;
+        const char* q = p;
+        while (q < end && *q != ',') q++;
+        const char* e = q;
+        while (e > p && (e[-1] == ' ' || e[-1] == '\t')) e--;
+        if ((size_t)(e - p) == n && strncasecmp(p, token, n) == 0) return 1;
+        p = q;
+    }
+    return 0;
+}
+
+/**
+ * @brief 解析请求行和头部（data[0, header_len) 连续且完整）
+ * @return 成功返回0，失败返回-1（p->error 为状态码）
+ */
+static inline int http_parse_head(http_parser_t* p, const char* data, size_t header_len) {
+    http_request_t* req = &p->req;
+    size_t line_end;
+    size_t pos = 0;
+    // 容忍请求之间多余的空行（RFC 9112 2.2）
+    while (pos < header_len && (data[pos] == '\r' || data[pos] == '\n')) pos++;
+
+    // 请求行：METHOD SP target SP HTTP/1.x
+    size_t next = http_next_line(data, pos, header_len, &line_end);
+    size_t i = http_scan_token(data, pos, line_end);
+    if (i == pos || i >= line_end || data[i] != ' ') goto bad;
+    req->method = (http_span_t){(uint32_t)pos, (uint32_t)(i - pos)};
+    size_t t = ++i;
+    while (i < line_end && data[i] != ' ') i++;
+    if (i == t || i >= line_end) goto bad;
+    req->target = (http_span_t){(uint32_t)t, (uint32_t)(i - t)};
+    i++;
+    if (line_end - i != 8 || memcmp(data + i, "HTTP/1.", 7) != 0 || data[i + 7] < '0' || data[i + 7] > '9') goto bad;
+    req->minor_version = data[i + 7] - '0';
+    req->keep_alive = req->minor_version >= 1;
+
+    // 头部：name ":" OWS value OWS
+    int has_length = 0;
+    req->num_headers = 0;
+    req->content_length = 0;
+    for (pos = next; pos < header_len; pos = next) {
+        next = http_next_line(data, pos, header_len, &line_end);
+        if (line_end == pos) break; // 空行
+        if (data[pos] == ' ' || data[pos] == '\t') goto bad; // obs-fold
+        if (req->num_headers == HTTP_MAX_HEADERS) {
+            p->error = 431;
+            return -1;
+        }
+        i = http_scan_token(data, pos, line_end);
+        if (i == pos || i >= line_end || data[i] != ':') goto bad;
+        http_header_t* h = &req->headers[req->num_headers++];
+        h->name = (http_span_t){(uint32_t)pos, (uint32_t)(i - pos)};
+        size_t v = i + 1;
+        size_t e = line_end;
+        while (v < e && (data[v] == ' ' || data[v] == '\t')) v++;
+        while (e > v && (data[e - 1] == ' ' || data[e - 1] == '\t')) e--;
+        h->value = (http_span_t){(uint32_t)v, (uint32_t)(e - v)};
+
+        // 先按长度区分，只有长度相同时才比较内容
+        if (HTTP_NAME_IS(data, h->name, "content-length")) {
+            size_t len = 0;
+            if (h->value.len == 0 || h->value.len > 18) goto bad;
+            for (size_t k = v; k < e; k++) {
+                if (data[k] < '0' || data[k] > '9') goto bad;
+                len = len * 10 + (size_t)(data[k] - '0');
+            }
+            if (has_length && len != req->content_length) goto bad; // 多个不一致的长度（请求走私）
+            has_length = 1;
+            req->content_length = len;
+        } else if (HTTP_NAME_IS(data, h->name, "transfer-encoding")) {
+            p->error = 501;
+            return -1;
+        } else if (HTTP_NAME_IS(data, h->name, "connection")) {
+            if (http_value_has_token(data, h->value, "close")) req->keep_alive = 0;
+            else if (http_value_has_token(data, h->value, "keep-alive")) req->keep_alive = 1;
+        }
+    }
+    if (p->max_body && req->content_length > p->max_body) {
+        p->error = 413;
+        return -1;
+    }
+    return 0;
+bad:
+    p->error = 400;
+    return -1;
+}
+
+// ====================== 接口 ======================
+/**
+ * @brief 初始化解析器
+ * @param max_body 主体上限（0表示不限）
+ */
+static inline void http_parser_init(http_parser_t* p, size_t max_body) {
+    memset(p, 0, sizeof(*p));
+    p->max_body = max_body;
+}
+
+/**
+ * @brief 准备解析下一个请求（上一个请求已从缓冲区消费）
+ */
+static inline void http_parser_reset(http_parser_t* p) {
+    p->state = HTTP_STATE_HEAD;
+    p->scanned = 0;
+    p->error = 0;
+}
+
+/**
+ * @brief 用当前缓冲区中的数据推进解析
+ * @param data 当前请求的起始位置（缓冲区中尚未消费的数据）
+ * @param len 可用的字节数
+ * @return 请求完整时返回请求的总字节数（头部 + 主体）；数据不够返回0；请求非法返回-1（p->error 为状态码）
+ * @note 头部阶段要求 data[0, len) 连续；进入主体阶段后只比较长度，不再读取数据。
+ *       同一个请求的多次调用之间 data 可以变（缓冲区扩容），但已有的数据必须还在相同的偏移上
+ */
+static inline ssize_t http_parser_execute(http_parser_t* p, const char* data, size_t len) {
+    if (p->state == HTTP_STATE_HEAD) {
+        size_t limit = len < HTTP_MAX_HEADER_SIZE ? len : HTTP_MAX_HEADER_SIZE;
+        size_t header_len = http_scan_header_end(data, p->scanned, limit, &p->scanned);
+        if (header_len == 0) {
+            if (len >= HTTP_MAX_HEADER_SIZE) {
+                p->error = 431;
+                return -1;
+            }
+            return 0;
+        }
+        if (http_parse_head(p, data, header_len) < 0) return -1;
+        p->req.header_len = header_len;
+        p->state = HTTP_STATE_BODY;
+    }
+    size_t total = p->req.header_len + p->req.content_length;
+    return len >= total ? (ssize_t)total : 0;
+}
+
+/**
+ * @brief 按名字查找头部（不区分大小写）
+ * @param base 请求起始位置
+ * @return 找到返回头部指针，否则返回NULL
+ */
+static inline const http_header_t* http_request_header(const http_request_t* req, const char* base,
+                                                       const char* name) {
+    for (int i = 0; i < req->num_headers; i++) {
+        if (http_span_equals(base, req->headers[i].name, name)) return &req->headers[i];
+    }
+    return NULL;
+}
+
+/**
+ * @brief 错误状态码对应的状态行
+ */
+static inline const char* http_status_text(int status) {
+    switch (status) {
+    case 200: return "200 OK";
+    case 400: return "400 Bad Request";
+    case 413: return "413 Content Too Large";
+    case 431: return "431 Request Header Fields Too Large";
+    case 501: return "501 Not Implemented";
+    case 503: return "503 Service Unavailable";
+    default: return "500 Internal Server Error";
+    }
+}
+
+#endif // _HTTP_PARSER_H_
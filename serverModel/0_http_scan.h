@@ -0,0 +1,276 @@
+#ifndef _HTTP_SCAN_H_
+#define _HTTP_SCAN_H_
+
+// HTTP 请求扫描内核（0_http_parser.h 的热点循环）：
+//  - header_end: 找头部结束的空行（"\r\n\r\n"，也接受"\n\n"），即请求边界；
+//  - token     : 从某个位置起跳过 token 字符（方法名、头部名），停在第一个非 token 字节（空格、':'、行尾）。
+// 每个内核有三档实现：标量（可移植C）、SSE4.2、AVX2，启动时按CPU特性选择最高的一档（运行时分发），
+// 也可以用 http_scan_select 指定（压测对比 / 排查问题）。
+// SIMD 实现一次比较16/32字节：
+//  - 空行：每32/64字节先只找'\n'（长头部值中大部分数据块没有换行符），有换行符时再把 data[i+1]、data[i+2]
+//    错位加载与'\n'/'\r'比较，按位组合出"此处是 \n\n 或 \n\r\n"的掩码，取最低位；
+//  - token：按高低半字节查表（pshufb）判断每个字节是否属于 RFC 9110 tchar，取第一个不属于的位置。
+// 向量加载不越过 len / end，尾部不足一个向量时由标量实现收尾，所以结果与标量实现完全一致。
+// SSE4.2 档实际只用到 SSE2/SSSE3 指令，按 SSE4.2（x86-64-v2 基线）检测；非x86平台只有标量实现。
+// 选择结果保存在本头文件的静态变量中：每个包含它的编译单元各有一份，由构造函数在 main 之前初始化，
+// 之后只读（多线程解析不需要同步）。
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HTTP_SCAN_X86 1
+#else
+#define HTTP_SCAN_X86 0
+#endif
+
+// ====================== 结构体 ======================
+typedef enum {
+    HTTP_SCAN_AUTO = 0,         // CPU支持的最高一档
+    HTTP_SCAN_SCALAR,
+    HTTP_SCAN_SSE42,
+    HTTP_SCAN_AVX2,
+} http_scan_level_t;
+
+/**
+ * @brief 一档扫描内核
+ */
+typedef struct http_scan_ops_s {
+    int level;                  // http_scan_level_t
+    // 从 from 开始找空行：返回头部长度（含空行）；没找到返回0，*resume 置为下次开始扫描的位置
+    size_t (*header_end)(const char* data, size_t from, size_t len, size_t* resume);
+    // 返回 [pos, end) 中第一个非 token 字节的位置，全部是 token 时返回 end
+    size_t (*token)(const char* data, size_t pos, size_t end);
+} http_scan_ops_t;
+
+// RFC 9110 tchar 位图：字节 c (< 0x80) 是 token 当且仅当 http_token_bits[c & 15] 的第 (c >> 4) 位为1
+// （SIMD 实现把它作为 pshufb 的查找表）
+static const uint8_t http_token_bits[16] = {
+    0xe8, 0xfc, 0xf8, 0xfc, 0xfc, 0xfc, 0xfc, 0xfc, 0xf8, 0xf8, 0xf4, 0x54, 0xd0, 0x54, 0xf4, 0x70,
+};
+
+static inline int http_is_token(unsigned char c) {
+    return c < 0x80 && ((http_token_bits[c & 15] >> (c >> 4)) & 1);
+}
+
+// ====================== 标量实现 ======================
+static inline size_t http_scan_header_end_scalar(const char* data, size_t from, size_t len, size_t* resume) {
+    size_t i = from;
+    while (i < len) {
+        const char* nl = (const char*)memchr(data + i, '\n', len - i);
+        if (!nl) break;
+        i = (size_t)(nl - data) + 1;
+        if (i < len && data[i] == '\n') return i + 1;
+        if (i + 1 < len && data[i] == '\r' && data[i + 1] == '\n') return i + 2;
+        if (i + 1 >= len) {
+            // 空行可能还没到齐：从这个换行符重新开始
+            *resume = i - 1;
+            return 0;
+        }
+    }
+    *resume = len;
+    return 0;
+}
+
+static inline size_t http_scan_token_scalar(const char* data, size_t pos, size_t end) {
+    while (pos < end && http_is_token((unsigned char)data[pos])) pos++;
+    return pos;
+}
+
+#if HTTP_SCAN_X86
+// ====================== SSE4.2 实现 ======================
+/**
+ * @brief p[0, 16) 中满足 p[k] == '\n' && (p[k+1] == '\n' || (p[k+1] == '\r' && p[k+2] == '\n')) 的位置掩码
+ * @param nl p[0, 16) 与'\n'比较的结果（调用方已算过），读取 p[0, 18)
+ */
+__attribute__((target("sse4.2")))
+static inline unsigned http_scan_blank_mask16(const char* p, __m128i nl) {
+    __m128i b = _mm_loadu_si128((const __m128i*)(p + 1));
+    __m128i c = _mm_loadu_si128((const __m128i*)(p + 2));
+    __m128i m = _mm_and_si128(nl, _mm_or_si128(_mm_cmpeq_epi8(b, _mm_set1_epi8('\n')),
+                                               _mm_and_si128(_mm_cmpeq_epi8(b, _mm_set1_epi8('\r')),
+                                                             _mm_cmpeq_epi8(c, _mm_set1_epi8('\n')))));
+    return (unsigned)_mm_movemask_epi8(m);
+}
+
+__attribute__((target("sse4.2")))
+static inline size_t http_scan_header_end_sse42(const char* data, size_t from, size_t len, size_t* resume) {
+    const __m128i lf = _mm_set1_epi8('\n');
+    size_t i = from;
+    // 大部分数据块里没有换行符（长头部值）：每32字节先只找'\n'，有换行符时才做完整判断
+    for (; i + 32 + 2 <= len; i += 32) {
+        __m128i n0 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + i)), lf);
+        __m128i n1 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + i + 16)), lf);
+        if (_mm_movemask_epi8(_mm_or_si128(n0, n1)) == 0) continue;
+        unsigned mask = http_scan_blank_mask16(data + i, n0) | (http_scan_blank_mask16(data + i + 16, n1) << 16);
+        if (mask) {
+            size_t k = i + (size_t)__builtin_ctz(mask);
+            return data[k + 1] == '\n' ? k + 2 : k + 3;
+        }
+    }
+    for (; i + 16 + 2 <= len; i += 16) {
+        unsigned mask = http_scan_blank_mask16(data + i, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + i)), lf));
+        if (mask) {
+            size_t k = i + (size_t)__builtin_ctz(mask);
+            return data[k + 1] == '\n' ? k + 2 : k + 3;
+        }
+    }
+    return http_scan_header_end_scalar(data, i, len, resume);
+}
+
+__attribute__((target("sse4.2")))
+static inline size_t http_scan_token_sse42(const char* data, size_t pos, size_t end) {
+    const __m128i lo_table = _mm_loadu_si128((const __m128i*)http_token_bits);
+    // 高半字节 h -> 1 << h（h >= 8 即非ASCII，结果为0）
+    const __m128i hi_table = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    for (; pos + 16 <= end; pos += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + pos));
+        __m128i lo = _mm_shuffle_epi8(lo_table, _mm_and_si128(v, nibble));
+        __m128i hi = _mm_shuffle_epi8(hi_table, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+        __m128i bad = _mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128());
+        unsigned mask = (unsigned)_mm_movemask_epi8(bad);
+        if (mask) return pos + (size_t)__builtin_ctz(mask);
+    }
+    return http_scan_token_scalar(data, pos, end);
+}
+
+// ====================== AVX2 实现 ======================
+/**
+ * @brief 同 http_scan_blank_mask16，处理 p[0, 32)（读取 p[0, 34)）
+ */
+__attribute__((target("avx2")))
+static inline uint32_t http_scan_blank_mask32(const char* p, __m256i nl) {
+    __m256i b = _mm256_loadu_si256((const __m256i*)(p + 1));
+    __m256i c = _mm256_loadu_si256((const __m256i*)(p + 2));
+    __m256i m = _mm256_and_si256(nl, _mm256_or_si256(_mm256_cmpeq_epi8(b, _mm256_set1_epi8('\n')),
+                                                     _mm256_and_si256(_mm256_cmpeq_epi8(b, _mm256_set1_epi8('\r')),
+                                                                      _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\n')))));
+    return (uint32_t)_mm256_movemask_epi8(m);
+}
+
+__attribute__((target("avx2")))
+static inline size_t http_scan_header_end_avx2(const char* data, size_t from, size_t len, size_t* resume) {
+    const __m256i lf = _mm256_set1_epi8('\n');
+    size_t i = from;
+    for (; i + 64 + 2 <= len; i += 64) {
+        __m256i n0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + i)), lf);
+        __m256i n1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + i + 32)), lf);
+        __m256i any = _mm256_or_si256(n0, n1);
+        if (_mm256_testz_si256(any, any)) continue;
+        uint64_t mask = http_scan_blank_mask32(data + i, n0) |
+                        ((uint64_t)http_scan_blank_mask32(data + i + 32, n1) << 32);
+        if (mask) {
+            size_t k = i + (size_t)__builtin_ctzll(mask);
+            return data[k + 1] == '\n' ? k + 2 : k + 3;
+        }
+    }
+    // 不足64字节的尾部（短请求的常见情况）交给16字节版本
+    return http_scan_header_end_sse42(data, i, len, resume);
+}
+
+__attribute__((target("avx2")))
+static inline size_t http_scan_token_avx2(const char* data, size_t pos, size_t end) {
+    // pshufb 在每个128位通道内查表，两个通道放同一张表
+    const __m256i lo_table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)http_token_bits));
+    const __m256i hi_table = _mm256_broadcastsi128_si256(
+        _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0, 0));
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    for (; pos + 32 <= end; pos += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(data + pos));
+        __m256i lo = _mm256_shuffle_epi8(lo_table, _mm256_and_si256(v, nibble));
+        __m256i hi = _mm256_shuffle_epi8(hi_table, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+        __m256i bad = _mm256_cmpeq_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256());
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(bad);
+        if (mask) return pos + (size_t)__builtin_ctz(mask);
+    }
+    return http_scan_token_sse42(data, pos, end);
+}
+#endif // HTTP_SCAN_X86
+
+// ====================== 运行时分发 ======================
+static http_scan_ops_t g_http_scan = {HTTP_SCAN_SCALAR, http_scan_header_end_scalar, http_scan_token_scalar};
+
+/**
+ * @brief CPU支持的最高一档
+ */
+static inline int http_scan_best_level(void) {
+#if HTTP_SCAN_X86
+    __builtin_cpu_init(); // 可能在其他构造函数之前调用
+    if (__builtin_cpu_supports("avx2")) return HTTP_SCAN_AVX2;
+    if (__builtin_cpu_supports("sse4.2")) return HTTP_SCAN_SSE42;
+#endif
+    return HTTP_SCAN_SCALAR;
+}
+
+/**
+ * @brief 选择扫描内核
+ * @param level http_scan_level_t，超过CPU支持的档位时降到CPU支持的最高一档
+ * @return 实际使用的档位
+ * @note 只应在启动时（解析开始之前）调用
+ */
+static inline int http_scan_select(int level) {
+    int best = http_scan_best_level();
+    if (level <= HTTP_SCAN_AUTO || level > best) level = best;
+    g_http_scan.level = level;
+    g_http_scan.header_end = http_scan_header_end_scalar;
+    g_http_scan.token = http_scan_token_scalar;
+#if HTTP_SCAN_X86
+    if (level == HTTP_SCAN_SSE42) {
+        g_http_scan.header_end = http_scan_header_end_sse42;
+        g_http_scan.token = http_scan_token_sse42;
+    } else if (level == HTTP_SCAN_AVX2) {
+        g_http_scan.header_end = http_scan_header_end_avx2;
+        g_http_scan.token = http_scan_token_avx2;
+    }
+#endif
+    return level;
+}
+
+__attribute__((constructor))
+static void http_scan_init(void) {
+    http_scan_select(HTTP_SCAN_AUTO);
+}
+
+static inline const char* http_scan_level_name(int level) {
+    switch (level) {
+    case HTTP_SCAN_SCALAR: return "scalar";
+    case HTTP_SCAN_SSE42: return "sse4.2";
+    case HTTP_SCAN_AVX2: return "avx2";
+    default: return "auto";
+    }
+}
+
+// ====================== 接口 ======================
+static inline size_t http_scan_header_end(const char* data, size_t from, size_t len, size_t* resume) {
+    return g_http_scan.header_end(data, from, len, resume);
+}
+
+static inline size_t http_scan_token(const char* data, size_t pos, size_t end) {
+    return g_http_scan.token(data, pos, end);
+}
+
+/**
+ * @brief 头部名与小写常量比较（不区分大小写），一次比较8字节
+ * @param lower 小写的头部名，只含小写字母、数字和'-'
+ * @note 头部名已按 token 校验过：按位或0x20之后等于小写字母、数字或'-'的 token 字节只有它们自己和
+ *       对应的大写字母，所以结果是精确的（'_' 等其他符号折叠后会变，这类名字用 strncasecmp）
+ */
+static inline int http_name_equals(const char* base, uint32_t off, uint32_t len, const char* lower, size_t n) {
+    if (len != n) return 0;
+    const char* p = base + off;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t a, b;
+        memcpy(&a, p + i, 8);
+        memcpy(&b, lower + i, 8);
+        if ((a | 0x2020202020202020ull) != b) return 0;
+    }
+    for (; i < n; i++) {
+        if (((unsigned char)p[i] | 0x20) != (unsigned char)lower[i]) return 0;
+    }
+    return 1;
+}
+
+#endif // _HTTP_SCAN_H_
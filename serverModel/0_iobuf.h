@@ -0,0 +1,299 @@
+#ifndef _IOBUF_H_
+#define _IOBUF_H_
+
+// 连接I/O用的可增长环形缓冲区
+// 读写位置单调递增、按容量取模，部分写之后只移动读位置，不需要把剩余数据memmove到开头；
+// 数据绕过末尾时用两段iovec，readv/writev一次系统调用处理完；
+// 空间不足时按2的幂扩容（一次拷贝，均摊O(1)），容量上限 max_cap 用于反压（超过时拒绝继续读入）
+// 不加锁：同一缓冲区同一时刻只能由一个线程使用（Reactor线程或连接的strand）
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+// ====================== 配置参数 ======================
+#define IOBUF_DEFAULT_CAPACITY 4096         // 首次分配的容量（2的幂）
+#define IOBUF_DEFAULT_MAX (4u * 1024 * 1024) // 默认容量上限
+#define IOBUF_READ_EXTRA 65536              // iobuf_read_fd 建议的栈上溢出缓冲区大小
+
+// ====================== 结构体 ======================
+/**
+ * @brief 环形缓冲区
+ * @note 可读数据为 [head, tail)，位置对 cap 取模；data 为NULL时表示尚未分配（延迟到第一次写入）
+ */
+typedef struct iobuf_s {
+    char* data;
+    size_t cap;                 // 容量（2的幂，0表示未分配）
+    size_t head;                // 读位置
+    size_t tail;                // 写位置
+    size_t init_cap;            // 首次分配的容量
+    size_t max_cap;             // 容量上限
+} iobuf_t;
+
+// ====================== 接口 ======================
+/**
+ * @brief 初始化（不分配内存，第一次写入时才分配）
+ * @param init_cap 首次分配的容量（0表示默认，向上取整到2的幂）
+ * @param max_cap 容量上限（0表示默认）
+ */
+static inline void iobuf_init(iobuf_t* buf, size_t init_cap, size_t max_cap) {
+    size_t n = 1;
+    if (init_cap == 0) init_cap = IOBUF_DEFAULT_CAPACITY;
+    while (n < init_cap) n <<= 1;
+    memset(buf, 0, sizeof(*buf));
+    buf->init_cap = n;
+    buf->max_cap = max_cap ? max_cap : IOBUF_DEFAULT_MAX;
+    if (buf->max_cap < n) buf->max_cap = n;
+}
+
+/**
+ * @brief 释放内存（之后可以继续使用，会重新分配）
+ */
+static inline void iobuf_free(iobuf_t* buf) {
+    free(buf->data);
+    buf->data = NULL;
+    buf->cap = buf->head = buf->tail = 0;
+}
+
+/**
+ * @brief 可读字节数
+ */
+static inline size_t iobuf_size(const iobuf_t* buf) {
+    return buf->tail - buf->head;
+}
+
+/**
+ * @brief 不扩容时的可写字节数
+ */
+static inline size_t iobuf_space(const iobuf_t* buf) {
+    return buf->cap - (buf->tail - buf->head);
+}
+
+/**
+ * @brief 清空（保留内存）
+ */
+static inline void iobuf_clear(iobuf_t* buf) {
+    buf->head = buf->tail = 0;
+}
+
+/**
+ * @brief 连接关闭后复用：清空数据，容量不超过 keep_cap 时保留内存，否则释放（大请求撑大的缓冲区不长期占用）
+ */
+static inline void iobuf_recycle(iobuf_t* buf, size_t keep_cap) {
+    if (buf->cap > keep_cap) iobuf_free(buf);
+    else iobuf_clear(buf);
+}
+
+/**
+ * @brief 保证至少有 n 字节可写空间，不够时扩容（可读数据拷贝到新缓冲区开头）
+ * @return 成功返回0，超过容量上限或内存不足返回-1
+ */
+static inline int iobuf_reserve(iobuf_t* buf, size_t n) {
+    size_t size = iobuf_size(buf);
+    if (buf->cap - size >= n) return 0;
+    if (size + n > buf->max_cap) return -1;
+    size_t cap = buf->cap ? buf->cap : buf->init_cap;
+    while (cap < size + n) cap <<= 1;
+    char* data = (char*)malloc(cap);
+    if (!data) return -1;
+    if (size > 0) {
+        size_t off = buf->head & (buf->cap - 1);
+        size_t first = buf->cap - off < size ? buf->cap - off : size;
+        memcpy(data, buf->data + off, first);
+        memcpy(data + first, buf->data, size - first);
+    }
+    free(buf->data);
+    buf->data = data;
+    buf->cap = cap;
+    buf->head = 0;
+    buf->tail = size;
+    return 0;
+}
+
+/**
+ * @brief 可读数据的iovec（最多两段）
+ * @return 段数（0表示没有数据）
+ */
+static inline int iobuf_readable_iov(const iobuf_t* buf, struct iovec iov[2]) {
+    size_t size = iobuf_size(buf);
+    if (size == 0) return 0;
+    size_t off = buf->head & (buf->cap - 1);
+    size_t first = buf->cap - off;
+    iov[0].iov_base = buf->data + off;
+    if (first >= size) {
+        iov[0].iov_len = size;
+        return 1;
+    }
+    iov[0].iov_len = first;
+    iov[1].iov_base = buf->data;
+    iov[1].iov_len = size - first;
+    return 2;
+}
+
+/**
+ * @brief 可写空间的iovec（最多两段，不扩容）
+ * @return 段数（0表示没有空间）
+ */
+static inline int iobuf_writable_iov(const iobuf_t* buf, struct iovec iov[2]) {
+    size_t space = iobuf_space(buf);
+    if (space == 0) return 0;
+    size_t off = buf->tail & (buf->cap - 1);
+    size_t first = buf->cap - off;
+    iov[0].iov_base = buf->data + off;
+    if (first >= space) {
+        iov[0].iov_len = space;
+        return 1;
+    }
+    iov[0].iov_len = first;
+    iov[1].iov_base = buf->data;
+    iov[1].iov_len = space - first;
+    return 2;
+}
+
+/**
+ * @brief 丢弃前 n 字节可读数据（已发送 / 已处理）
+ * @note 读空时回到位置0，之后的写入尽量不绕回
+ */
+static inline void iobuf_consume(iobuf_t* buf, size_t n) {
+    buf->head += n;
+    if (buf->head == buf->tail) buf->head = buf->tail = 0;
+}
+
+/**
+ * @brief 确认 n 字节已写入 iobuf_writable_iov 给出的空间
+ */
+static inline void iobuf_commit(iobuf_t* buf, size_t n) {
+    buf->tail += n;
+}
+
+/**
+ * @brief 追加数据（空间不够时扩容）
+ * @return 成功返回0，超过容量上限返回-1（不写入任何数据）
+ */
+static inline int iobuf_append(iobuf_t* buf, const void* src, size_t len) {
+    if (len == 0) return 0;
+    if (iobuf_reserve(buf, len) < 0) return -1;
+    size_t off = buf->tail & (buf->cap - 1);
+    size_t first = buf->cap - off < len ? buf->cap - off : len;
+    memcpy(buf->data + off, src, first);
+    if (len > first) memcpy(buf->data, (const char*)src + first, len - first);
+    buf->tail += len;
+    return 0;
+}
+
+/**
+ * @brief 把 src 的前 n 字节移到 dst 末尾（回显等场景）
+ * @return 成功返回0，dst超过容量上限返回-1（src不变）
+ */
+static inline int iobuf_move(iobuf_t* dst, iobuf_t* src, size_t n) {
+    struct iovec iov[2];
+    int cnt = iobuf_readable_iov(src, iov);
+    if (n > iobuf_size(src) || iobuf_reserve(dst, n) < 0) return -1;
+    size_t left = n;
+    for (int i = 0; i < cnt && left > 0; i++) {
+        size_t len = iov[i].iov_len < left ? iov[i].iov_len : left;
+        iobuf_append(dst, iov[i].iov_base, len);
+        left -= len;
+    }
+    iobuf_consume(src, n);
+    return 0;
+}
+
+static inline void iobuf_reverse(char* p, size_t n) {
+    for (size_t i = 0, j = n; i + 1 < j; i++, j--) {
+        char c = p[i];
+        p[i] = p[j - 1];
+        p[j - 1] = c;
+    }
+}
+
+/**
+ * @brief 使可读数据在内存中连续（解析器需要连续的数据）
+ * @return 可读数据的起始地址；没有数据返回NULL
+ * @note 只有数据绕过末尾时才整理：原地旋转到缓冲区开头，不分配内存。
+ *       读空时位置回到0，只有留下半个请求又继续读入时才会绕回，需要整理的通常只是这半个请求
+ */
+static inline char* iobuf_linearize(iobuf_t* buf) {
+    size_t size = iobuf_size(buf);
+    if (size == 0) return NULL;
+    size_t off = buf->head & (buf->cap - 1);
+    if (off + size > buf->cap) {
+        size_t first = buf->cap - off;      // 末尾一段 [off, cap)
+        size_t second = size - first;       // 开头一段 [0, second)
+        memmove(buf->data + second, buf->data + off, first); // [second | first | 空闲]
+        iobuf_reverse(buf->data, second);   // 三次反转：[second | first] -> [first | second]
+        iobuf_reverse(buf->data + second, first);
+        iobuf_reverse(buf->data, size);
+        buf->head = 0;
+        buf->tail = size;
+        return buf->data;
+    }
+    return buf->data + off;
+}
+
+/**
+ * @brief 拷贝出前 n 字节（不消费）
+ * @return 实际拷贝的字节数
+ */
+static inline size_t iobuf_peek(const iobuf_t* buf, void* dst, size_t n) {
+    struct iovec iov[2];
+    int cnt = iobuf_readable_iov(buf, iov);
+    size_t copied = 0;
+    for (int i = 0; i < cnt && copied < n; i++) {
+        size_t len = iov[i].iov_len < n - copied ? iov[i].iov_len : n - copied;
+        memcpy((char*)dst + copied, iov[i].iov_base, len);
+        copied += len;
+    }
+    return copied;
+}
+
+/**
+ * @brief 从fd读入（readv：缓冲区的空闲段 + 调用方栈上的溢出缓冲区）
+ * @param extra 溢出缓冲区（可为NULL），读到其中的数据再追加进来（按需扩容）
+ * @return 读到的字节数；0表示对端关闭；-1表示出错（errno），缓冲区已达上限时 errno = ENOBUFS
+ * @note 空闲缓冲区保持较小，一次系统调用也能读入大量数据（空间不够时才扩容）
+ */
+static inline ssize_t iobuf_read_fd(iobuf_t* buf, int fd, char* extra, size_t extra_len) {
+    if (iobuf_space(buf) == 0 && iobuf_reserve(buf, buf->cap ? buf->cap : buf->init_cap) < 0 &&
+        iobuf_reserve(buf, 1) < 0) {
+        errno = ENOBUFS;
+        return -1;
+    }
+    struct iovec iov[3];
+    int cnt = iobuf_writable_iov(buf, iov);
+    size_t space = iobuf_space(buf);
+    size_t extra_max = buf->max_cap - iobuf_size(buf) - space; // 扩容后最多还能放下的字节数
+    if (extra && extra_len > 0 && extra_max > 0) {
+        iov[cnt].iov_base = extra;
+        iov[cnt].iov_len = extra_len < extra_max ? extra_len : extra_max;
+        cnt++;
+    }
+    ssize_t n = readv(fd, iov, cnt);
+    if (n <= 0) return n;
+    if ((size_t)n <= space) {
+        buf->tail += (size_t)n;
+    } else {
+        buf->tail += space;
+        iobuf_append(buf, extra, (size_t)n - space); // 不会超过上限（extra_max）
+    }
+    return n;
+}
+
+/**
+ * @brief 把可读数据写到fd（writev），已写出的部分从缓冲区移除
+ * @return 写出的字节数；-1表示出错（errno，包括EAGAIN）
+ */
+static inline ssize_t iobuf_write_fd(iobuf_t* buf, int fd) {
+    struct iovec iov[2];
+    int cnt = iobuf_readable_iov(buf, iov);
+    if (cnt == 0) return 0;
+    ssize_t n = writev(fd, iov, cnt);
+    if (n > 0) iobuf_consume(buf, (size_t)n);
+    return n;
+}
+
+#endif // _IOBUF_H_
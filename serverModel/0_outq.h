@@ -0,0 +1,294 @@
+#ifndef _OUTQ_H_
+#define _OUTQ_H_
+
+// 连接的待发送队列：内联字节 + 引用计数的共享主体，一次writev写出
+// 响应头和主体是各自独立的iovec：
+//  - 内联字节（响应头、很小的主体）追加到环形缓冲区（0_iobuf.h）；
+//  - 共享主体（缓存的内容、由读缓冲区整块转成的大请求体）只登记引用和区间，不拷贝进连接的缓冲区，
+//    同一个主体可以同时被多个连接（多个线程）引用，最后一个引用释放时才释放内存
+// 发送时按入队顺序把 内联段 / 主体段 组装成iovec数组，一次writev写出（最多 OUTQ_MAX_IOV 段）；
+// 部分写之后只移动位置，写完的主体引用计数-1
+// 不加锁：同一队列同一时刻只能由一个线程使用（与 iobuf 相同）；主体的引用计数是原子的
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include "0_iobuf.h"
+
+// ====================== 配置参数 ======================
+#define OUTQ_MAX_IOV 64                 // 一次writev最多的段数
+#define OUTQ_INLINE_MAX 2048            // 比这更短的主体直接拷贝进内联缓冲区（小主体每个占一个iovec时，一次writev写出的字节太少，不如拷贝）
+#define OUTQ_INITIAL_SEGS 8             // 第一次登记主体时分配的段数（2的幂，按需翻倍）
+
+// ====================== 结构体 ======================
+/**
+ * @brief 引用计数的只读主体
+ */
+typedef struct shared_body_s {
+    int refs;                   // 引用计数（原子访问）
+    size_t len;
+    const char* data;
+    void* mem;                  // 最后一个引用释放时free的内存（NULL表示数据与结构体一起分配）
+} shared_body_t;
+
+// 静态的只读主体（固定文本）：初始的一个引用由它自己持有，计数不会降到0，不会被释放
+#define SHARED_BODY_STATIC(text) {1, sizeof(text) - 1, text, NULL}
+
+/**
+ * @brief 一个主体段：先发送 inline_len 字节内联数据，再发送 body 的 [off, off + len)
+ */
+typedef struct outq_seg_s {
+    size_t inline_len;
+    shared_body_t* body;
+    size_t off;
+    size_t len;
+} outq_seg_t;
+
+/**
+ * @brief 待发送队列
+ * @note 内联数据中最后一个主体段之后的部分（iobuf_size(&bytes) - assigned）排在所有主体之后
+ */
+typedef struct outq_s {
+    iobuf_t bytes;              // 内联数据
+    outq_seg_t* segs;           // 主体段（环形数组，NULL表示还没有登记过主体）
+    size_t seg_cap;             // 容量（2的幂）
+    size_t seg_head;            // 队首位置
+    size_t seg_count;           // 段数
+    size_t assigned;            // 内联数据中属于各主体段之前的字节数
+    size_t body_bytes;          // 各主体段待发送的字节数
+} outq_t;
+
+// ====================== 共享主体 ======================
+/**
+ * @brief 拷贝一份数据创建主体（一次分配，用于缓存的内容：创建时拷贝一次，之后每次发送只增加引用）
+ * @return 引用计数为1的主体；内存不足返回NULL
+ */
+static inline shared_body_t* shared_body_create(const void* data, size_t len) {
+    shared_body_t* body = (shared_body_t*)malloc(sizeof(shared_body_t) + len);
+    if (!body) return NULL;
+    body->refs = 1;
+    body->len = len;
+    body->data = (const char*)(body + 1);
+    body->mem = NULL;
+    memcpy(body + 1, data, len);
+    return body;
+}
+
+/**
+ * @brief 接管一块malloc分配的内存作为主体（不拷贝）
+ * @param mem 最后一个引用释放时free的内存
+ * @param data 主体在 mem 中的起始位置
+ * @return 引用计数为1的主体；内存不足返回NULL（mem 仍归调用方）
+ */
+static inline shared_body_t* shared_body_adopt(void* mem, const char* data, size_t len) {
+    shared_body_t* body = (shared_body_t*)malloc(sizeof(shared_body_t));
+    if (!body) return NULL;
+    body->refs = 1;
+    body->len = len;
+    body->data = data;
+    body->mem = mem;
+    return body;
+}
+
+static inline shared_body_t* shared_body_ref(shared_body_t* body) {
+    __atomic_add_fetch(&body->refs, 1, __ATOMIC_RELAXED);
+    return body;
+}
+
+/**
+ * @brief 释放一个引用，最后一个引用释放时释放内存
+ */
+static inline void shared_body_unref(shared_body_t* body) {
+    if (__atomic_sub_fetch(&body->refs, 1, __ATOMIC_ACQ_REL) != 0) return;
+    free(body->mem);
+    free(body);
+}
+
+// ====================== 接口 ======================
+/**
+ * @brief 初始化（不分配内存）
+ * @param init_cap / max_cap 内联缓冲区的首次分配容量和上限（见 iobuf_init）
+ */
+static inline void outq_init(outq_t* q, size_t init_cap, size_t max_cap) {
+    memset(q, 0, sizeof(*q));
+    iobuf_init(&q->bytes, init_cap, max_cap);
+}
+
+/**
+ * @brief 待发送的总字节数（内联 + 主体）
+ */
+static inline size_t outq_size(const outq_t* q) {
+    return iobuf_size(&q->bytes) + q->body_bytes;
+}
+
+/**
+ * @brief 追加内联数据
+ * @return 成功返回0，内联缓冲区超过上限返回-1
+ */
+static inline int outq_append(outq_t* q, const void* data, size_t len) {
+    return iobuf_append(&q->bytes, data, len);
+}
+
+/**
+ * @brief 登记主体的 [off, off + len) 区间（接管调用方持有的一个引用）
+ * @return 成功返回0，内存不足返回-1（引用已释放）
+ */
+static inline int outq_push_body(outq_t* q, shared_body_t* body, size_t off, size_t len) {
+    if (len == 0) {
+        shared_body_unref(body);
+        return 0;
+    }
+    if (q->seg_count == q->seg_cap) {
+        size_t cap = q->seg_cap ? q->seg_cap * 2 : OUTQ_INITIAL_SEGS;
+        outq_seg_t* segs = (outq_seg_t*)malloc(sizeof(outq_seg_t) * cap);
+        if (!segs) {
+            shared_body_unref(body);
+            return -1;
+        }
+        for (size_t i = 0; i < q->seg_count; i++) segs[i] = q->segs[(q->seg_head + i) & (q->seg_cap - 1)];
+        free(q->segs);
+        q->segs = segs;
+        q->seg_cap = cap;
+        q->seg_head = 0;
+    }
+    outq_seg_t* s = &q->segs[(q->seg_head + q->seg_count) & (q->seg_cap - 1)];
+    s->inline_len = iobuf_size(&q->bytes) - q->assigned; // 之前追加的内联数据先于本主体发送
+    s->body = body;
+    s->off = off;
+    s->len = len;
+    q->assigned += s->inline_len;
+    q->body_bytes += len;
+    q->seg_count++;
+    return 0;
+}
+
+/**
+ * @brief 追加主体的 [off, off + len) 区间（增加一个引用；很短的主体直接拷贝成内联数据）
+ * @return 成功返回0，失败返回-1
+ */
+static inline int outq_append_body(outq_t* q, shared_body_t* body, size_t off, size_t len) {
+    if (len < OUTQ_INLINE_MAX) return outq_append(q, body->data + off, len);
+    return outq_push_body(q, shared_body_ref(body), off, len);
+}
+
+/**
+ * @brief 把 src 的前 n 字节移入队列（回显）
+ * @param adopt_min 不小于这个长度且在 src 中连续时，把 src 的整块内存转成共享主体（不拷贝），
+ *        src 之后的剩余数据（下一个流水线请求的开头）拷贝到新分配的缓冲区；否则拷贝成内联数据
+ * @return 成功返回0，失败返回-1
+ */
+static inline int outq_move_iobuf(outq_t* q, iobuf_t* src, size_t n, size_t adopt_min) {
+    if (n > iobuf_size(src)) return -1;
+    if (n == 0) return 0;
+    size_t off = src->head & (src->cap - 1);
+    if (n < adopt_min || off + n > src->cap) return iobuf_move(&q->bytes, src, n);
+    shared_body_t* body = shared_body_adopt(src->data, src->data + off, n);
+    if (!body) return iobuf_move(&q->bytes, src, n);
+    iobuf_t old = *src;
+    src->data = NULL; // 下次写入时重新分配
+    src->cap = src->head = src->tail = 0;
+    old.head += n;
+    int ret = outq_push_body(q, body, 0, n); // 在此之后 old.data 由主体持有
+    if (iobuf_size(&old) > 0 && iobuf_move(src, &old, iobuf_size(&old)) < 0) ret = -1;
+    return ret;
+}
+
+/**
+ * @brief 内联数据中 [pos, pos + len)（相对读位置）的iovec
+ * @return 段数（0~2）
+ */
+static inline int outq_inline_iov(const outq_t* q, size_t pos, size_t len, struct iovec* iov) {
+    if (len == 0) return 0;
+    const iobuf_t* b = &q->bytes;
+    size_t off = (b->head + pos) & (b->cap - 1);
+    size_t first = b->cap - off < len ? b->cap - off : len;
+    iov[0].iov_base = b->data + off;
+    iov[0].iov_len = first;
+    if (first == len) return 1;
+    iov[1].iov_base = b->data;
+    iov[1].iov_len = len - first;
+    return 2;
+}
+
+/**
+ * @brief 丢弃前 n 字节（已发送），写完的主体释放引用
+ */
+static inline void outq_consume(outq_t* q, size_t n) {
+    while (n > 0 && q->seg_count > 0) {
+        outq_seg_t* s = &q->segs[q->seg_head];
+        size_t k = n < s->inline_len ? n : s->inline_len;
+        iobuf_consume(&q->bytes, k);
+        s->inline_len -= k;
+        q->assigned -= k;
+        n -= k;
+        if (s->inline_len > 0) return;
+        k = n < s->len ? n : s->len;
+        s->off += k;
+        s->len -= k;
+        q->body_bytes -= k;
+        n -= k;
+        if (s->len > 0) return;
+        shared_body_unref(s->body);
+        q->seg_head = (q->seg_head + 1) & (q->seg_cap - 1);
+        q->seg_count--;
+    }
+    iobuf_consume(&q->bytes, n);
+}
+
+/**
+ * @brief 把待发送数据写到fd（writev，内联段和主体段按顺序组装），已写出的部分从队列移除
+ * @return 写出的字节数；-1表示出错（errno，包括EAGAIN）
+ */
+static inline ssize_t outq_write_fd(outq_t* q, int fd) {
+    struct iovec iov[OUTQ_MAX_IOV];
+    int cnt = 0;
+    size_t pos = 0; // 已组装的内联字节数
+    size_t i = 0;
+    for (; i < q->seg_count && cnt + 3 <= OUTQ_MAX_IOV; i++) {
+        const outq_seg_t* s = &q->segs[(q->seg_head + i) & (q->seg_cap - 1)];
+        cnt += outq_inline_iov(q, pos, s->inline_len, iov + cnt);
+        pos += s->inline_len;
+        iov[cnt].iov_base = (void*)(s->body->data + s->off);
+        iov[cnt].iov_len = s->len;
+        cnt++;
+    }
+    if (i == q->seg_count && cnt + 2 <= OUTQ_MAX_IOV) cnt += outq_inline_iov(q, pos, iobuf_size(&q->bytes) - pos, iov + cnt);
+    if (cnt == 0) return 0;
+    ssize_t n = writev(fd, iov, cnt);
+    if (n > 0) outq_consume(q, (size_t)n);
+    return n;
+}
+
+/**
+ * @brief 清空（释放所有主体引用，保留内存）
+ */
+static inline void outq_clear(outq_t* q) {
+    for (size_t i = 0; i < q->seg_count; i++) shared_body_unref(q->segs[(q->seg_head + i) & (q->seg_cap - 1)].body);
+    q->seg_head = q->seg_count = 0;
+    q->assigned = q->body_bytes = 0;
+    iobuf_clear(&q->bytes);
+}
+
+/**
+ * @brief 连接关闭后复用：清空，内联缓冲区按 iobuf_recycle 的规则保留或释放（段数组保留）
+ */
+static inline void outq_recycle(outq_t* q, size_t keep_cap) {
+    outq_clear(q);
+    iobuf_recycle(&q->bytes, keep_cap);
+}
+
+/**
+ * @brief 释放全部内存（之后可以继续使用）
+ */
+static inline void outq_free(outq_t* q) {
+    outq_clear(q);
+    iobuf_free(&q->bytes);
+    free(q->segs);
+    q->segs = NULL;
+    q->seg_cap = 0;
+}
+
+#endif // _OUTQ_H_
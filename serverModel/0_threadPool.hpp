@@ -0,0 +1,1435 @@
+#ifndef _THREAD_POOL_HPP_
+#define _THREAD_POOL_HPP_
+
+#include "0_cpu_topology.h"
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <atomic>
+#include <condition_variable>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <optional>
+#include <exception>
+#include <future>
+#include <array>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef THREAD_POOL_TELEMETRY
+#define THREAD_POOL_TELEMETRY 1 // 遥测开关：编译时 -DTHREAD_POOL_TELEMETRY=0 关闭，记录代码全部编译掉
+#endif
+
+// ====================== 调度模式 ======================
+/**
+ * @brief 线程池调度模式
+ * @note SharedQueue：所有任务经过同一个加锁队列（原实现）
+ *       WorkStealing：每个worker持有一个Chase-Lev双端队列，worker内部提交的任务留在本地，
+ *                     空闲worker随机挑选其他worker窃取任务；外部提交仍走共享注入队列
+ */
+enum class SchedulingMode {
+    SharedQueue,
+    WorkStealing,
+};
+
+// ====================== Chase-Lev 工作窃取双端队列 ======================
+/**
+ * @brief 无锁工作窃取双端队列（Chase-Lev，C11内存模型版本）
+ * @note push/pop 只能由所属worker调用（操作bottom端），steal 可由任意线程调用（操作top端）
+ * @note 元素类型必须是指针，窃取时可能投机读取后放弃
+ */
+template <typename T>
+class WorkStealingDeque {
+private:
+    struct Array {
+        size_t capacity;
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+
+        explicit Array(size_t cap) : capacity(cap), mask(cap - 1), slots(new std::atomic<T>[cap]) {}
+        T get(int64_t i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T x) { slots[i & mask].store(x, std::memory_order_relaxed); }
+    };
+
+    alignas(64) std::atomic<int64_t> top;
+    alignas(64) std::atomic<int64_t> bottom;
+    alignas(64) std::atomic<Array*> array;
+    std::vector<std::unique_ptr<Array>> retired; // 扩容后的旧数组，窃取者可能仍在读取，析构时统一释放
+
+public:
+    explicit WorkStealingDeque(size_t capacity = 256) : top(0), bottom(0) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        retired.emplace_back(new Array(cap));
+        array.store(retired.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    /**
+     * @brief 压入bottom端（仅所属worker调用），满时扩容为两倍
+     */
+    void push(T x) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        Array* a = array.load(std::memory_order_relaxed);
+        if (b - t > static_cast<int64_t>(a->capacity) - 1) {
+            Array* bigger = new Array(a->capacity * 2);
+            for (int64_t i = t; i < b; ++i) {
+                bigger->put(i, a->get(i));
+            }
+            retired.emplace_back(bigger);
+            array.store(bigger, std::memory_order_release);
+            a = bigger;
+        }
+        a->put(b, x);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 从bottom端弹出（仅所属worker调用，LIFO，缓存友好）
+     * @return 任务，空时返回nullptr
+     */
+    T pop() {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Array* a = array.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        T x = nullptr;
+        if (t <= b) {
+            x = a->get(b);
+            if (t == b) {
+                // 只剩最后一个元素，与窃取者竞争
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                 std::memory_order_relaxed)) {
+                    x = nullptr;
+                }
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+        } else {
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return x;
+    }
+
+    /**
+     * @brief 从top端窃取（任意线程调用，FIFO）
+     * @return 任务，空或竞争失败时返回nullptr
+     */
+    T steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+
+        T x = nullptr;
+        if (t < b) {
+            Array* a = array.load(std::memory_order_acquire);
+            x = a->get(t);
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                             std::memory_order_relaxed)) {
+                return nullptr;
+            }
+        }
+        return x;
+    }
+
+    /**
+     * @brief 是否为空（并发下为近似值）
+     */
+    bool empty() const {
+        int64_t b = bottom.load(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_seq_cst);
+        return b <= t;
+    }
+};
+
+// ====================== 小对象优化的任务类型 ======================
+/**
+ * @brief 只可移动的 void() 可调用对象，内置固定大小的缓冲区
+ * @tparam Capacity 内联缓冲区大小（字节）
+ * @note 大小不超过Capacity、且移动构造不抛异常的可调用对象直接存放在缓冲区中，构造和移动都不分配内存；
+ *       更大的可调用对象退化为堆上存放（isInline()返回false）。
+ *       与std::function不同，可以保存只可移动的对象（如捕获了unique_ptr或TaskPromise的lambda）
+ */
+template <size_t Capacity = 64>
+class InlineTask {
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*move)(void* src, void* dst); // 移动到dst并析构src
+        void (*destroy)(void* storage);
+        bool inlineStored;
+    };
+
+    template <typename D>
+    static constexpr bool fitsInline = sizeof(D) <= Capacity &&
+                                       alignof(D) <= alignof(std::max_align_t) &&
+                                       std::is_nothrow_move_constructible<D>::value;
+
+    template <typename D>
+    static const Ops* inlineOps() {
+        static const Ops ops{
+            [](void* p) { (*static_cast<D*>(p))(); },
+            [](void* src, void* dst) {
+                D* from = static_cast<D*>(src);
+                ::new (dst) D(std::move(*from));
+                from->~D();
+            },
+            [](void* p) { static_cast<D*>(p)->~D(); },
+            true,
+        };
+        return &ops;
+    }
+
+    template <typename D>
+    static const Ops* heapOps() {
+        static const Ops ops{
+            [](void* p) { (**static_cast<D**>(p))(); },
+            [](void* src, void* dst) { *static_cast<D**>(dst) = *static_cast<D**>(src); },
+            [](void* p) { delete *static_cast<D**>(p); },
+            false,
+        };
+        return &ops;
+    }
+
+    alignas(std::max_align_t) unsigned char storage[Capacity];
+    const Ops* ops;
+
+public:
+    InlineTask() noexcept : ops(nullptr) {}
+
+    template <typename F, typename D = std::decay_t<F>,
+              typename = std::enable_if_t<!std::is_same<D, InlineTask>::value>>
+    InlineTask(F&& f) : ops(nullptr) {
+        if constexpr (fitsInline<D>) {
+            ::new (static_cast<void*>(storage)) D(std::forward<F>(f));
+            ops = inlineOps<D>();
+        } else {
+            *reinterpret_cast<D**>(storage) = new D(std::forward<F>(f));
+            ops = heapOps<D>();
+        }
+    }
+
+    InlineTask(InlineTask&& other) noexcept : ops(other.ops) {
+        if (ops) {
+            ops->move(other.storage, storage);
+            other.ops = nullptr;
+        }
+    }
+
+    InlineTask& operator=(InlineTask&& other) noexcept {
+        if (this != &other) {
+            reset();
+            ops = other.ops;
+            if (ops) {
+                ops->move(other.storage, storage);
+                other.ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    InlineTask(const InlineTask&) = delete;
+    InlineTask& operator=(const InlineTask&) = delete;
+
+    ~InlineTask() {
+        reset();
+    }
+
+    void operator()() {
+        if (!ops) throw std::bad_function_call();
+        ops->invoke(storage);
+    }
+
+    explicit operator bool() const noexcept {
+        return ops != nullptr;
+    }
+
+    /**
+     * @brief 可调用对象是否存放在内联缓冲区中（未发生堆分配）
+     */
+    bool isInline() const noexcept {
+        return ops && ops->inlineStored;
+    }
+
+    /**
+     * @brief 释放持有的可调用对象（及其捕获的资源）
+     */
+    void reset() noexcept {
+        if (ops) {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+};
+
+// ====================== 任务结果 ======================
+template <typename T>
+class TaskFuture;
+
+/**
+ * @brief TaskPromise/TaskFuture 共享的结果状态（一次分配）
+ */
+template <typename T>
+struct TaskState {
+    using Value = std::conditional_t<std::is_void<T>::value, bool, T>;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool ready = false;
+    std::optional<Value> value;
+    std::exception_ptr error;
+};
+
+/**
+ * @brief 任务结果的写入端（只可移动）
+ * @note 析构时仍未写入结果则写入broken_promise异常，避免任务被丢弃（线程池已停止）时等待方永久阻塞
+ */
+template <typename T>
+class TaskPromise {
+private:
+    std::shared_ptr<TaskState<T>> state;
+
+    template <typename Fn>
+    void complete(Fn&& fill) {
+        if (!state) return;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->ready) return;
+            fill(*state);
+            state->ready = true;
+        }
+        state->cv.notify_all();
+    }
+
+public:
+    TaskPromise() : state(std::make_shared<TaskState<T>>()) {}
+    TaskPromise(TaskPromise&&) noexcept = default;
+    TaskPromise& operator=(TaskPromise&&) noexcept = default;
+    TaskPromise(const TaskPromise&) = delete;
+    TaskPromise& operator=(const TaskPromise&) = delete;
+
+    ~TaskPromise() {
+        set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+    }
+
+    TaskFuture<T> get_future() {
+        return TaskFuture<T>(state);
+    }
+
+    template <typename... Args>
+    void set_value(Args&&... args) {
+        complete([&](TaskState<T>& s) {
+            if constexpr (std::is_void<T>::value) {
+                s.value.emplace(true);
+            } else {
+                s.value.emplace(std::forward<Args>(args)...);
+            }
+        });
+    }
+
+    void set_exception(std::exception_ptr e) {
+        complete([&](TaskState<T>& s) { s.error = std::move(e); });
+    }
+};
+
+/**
+ * @brief 任务结果的读取端（只可移动，get()只能调用一次）
+ */
+template <typename T>
+class TaskFuture {
+private:
+    friend class TaskPromise<T>;
+    std::shared_ptr<TaskState<T>> state;
+
+    explicit TaskFuture(std::shared_ptr<TaskState<T>> s) : state(std::move(s)) {}
+
+public:
+    TaskFuture() = default;
+    TaskFuture(TaskFuture&&) noexcept = default;
+    TaskFuture& operator=(TaskFuture&&) noexcept = default;
+
+    bool valid() const noexcept {
+        return state != nullptr;
+    }
+
+    bool ready() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->ready;
+    }
+
+    void wait() const {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->cv.wait(lock, [this]{return state->ready;});
+    }
+
+    /**
+     * @return 超时前结果已就绪返回true
+     */
+    template <typename Rep, typename Period>
+    bool wait_for(const std::chrono::duration<Rep, Period>& timeout) const {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        return state->cv.wait_for(lock, timeout, [this]{return state->ready;});
+    }
+
+    /**
+     * @brief 等待并取出结果；任务抛出的异常在此重新抛出
+     */
+    T get() {
+        wait();
+        std::shared_ptr<TaskState<T>> s = std::move(state);
+        if (s->error) std::rethrow_exception(s->error);
+        if constexpr (!std::is_void<T>::value) {
+            return std::move(*s->value);
+        }
+    }
+};
+
+// ====================== 弹性伸缩参数 ======================
+/**
+ * @brief 弹性模式参数
+ * @note maxThreads > minThreads 时启用：任务排队超过growWaitThreshold且没有空闲worker时扩容，
+ *       worker空闲超过idleTimeout且线程数多于minThreads时回收
+ */
+struct ElasticOptions {
+    size_t minThreads;
+    size_t maxThreads;
+    std::chrono::milliseconds idleTimeout{10000};
+    std::chrono::microseconds growWaitThreshold{1000};
+};
+
+// ====================== 背压策略 ======================
+/**
+ * @brief 共享队列已满（达到maxQueueSize）时新任务的处理方式
+ * @note 只作用于进入共享队列的任务；WorkStealing模式下worker内部提交到本地队列的任务不受限制
+ */
+enum class OverflowPolicy {
+    Block,          // 阻塞等待空位（默认）；OverflowOptions::timeout > 0 时最多等待该时长
+    Reject,         // 直接拒绝
+    CallerRuns,     // 在提交线程上直接执行
+    DropOldest,     // 丢弃共享队列中最旧的任务后入队（被丢弃任务的捕获在提交线程上析构）
+    Callback,       // 调用 OverflowOptions::callback，由回调按任务决定采用以上哪种方式
+};
+
+struct OverflowOptions {
+    OverflowPolicy policy = OverflowPolicy::Block;
+    std::chrono::milliseconds timeout{0};                  // Block：最长等待时间（0表示一直等待）
+    std::function<OverflowPolicy(size_t queued)> callback; // Callback：参数为当前排队数，返回Callback按Reject处理；
+                                                           // 在持有线程池锁时调用，回调内不能向本线程池提交任务
+};
+
+/**
+ * @brief 提交结果
+ */
+enum class SubmitResult {
+    Enqueued,       // 已入队
+    RanInline,      // 队列满，已在提交线程上执行（CallerRuns）
+    Rejected,       // 队列满，被拒绝
+    Timeout,        // 队列满，等待空位超时
+    Stopped,        // 线程池已停止
+};
+
+// ====================== 遥测 ======================
+/**
+ * @brief 线程池遥测快照（所有worker合并）
+ * @note wait：入队到开始执行（仅统计经过共享队列的任务）；busy：执行任务的时间；
+ *       idle：两次执行之间的时间（取任务、等锁、休眠）
+ */
+struct PoolTelemetry {
+    static constexpr size_t kBuckets = 32; // 第i桶为 [2^(i-1), 2^i) 纳秒，最后一桶包含更大的值
+
+    uint64_t tasks = 0;
+    uint64_t waitNs = 0;
+    uint64_t busyNs = 0;
+    uint64_t idleNs = 0;
+    uint64_t spinHits = 0;      // 在自旋/让出阶段等到任务的次数（省掉一次休眠和唤醒）
+    uint64_t parks = 0;         // 进入休眠的次数
+    std::array<uint64_t, kBuckets> waitHist{};
+    std::array<uint64_t, kBuckets> runHist{};
+
+    static size_t bucket(uint64_t ns) {
+        size_t b = ns == 0 ? 0 : static_cast<size_t>(64 - __builtin_clzll(ns));
+        return b < kBuckets ? b : kBuckets - 1;
+    }
+
+    /**
+     * @brief 由直方图估算分位数
+     * @return 分位数所在桶的上界（纳秒），直方图为空返回0
+     */
+    static uint64_t percentile(const std::array<uint64_t, kBuckets>& hist, double p) {
+        uint64_t total = 0;
+        for (uint64_t n : hist) total += n;
+        if (total == 0) return 0;
+        uint64_t rank = std::min(static_cast<uint64_t>(p * static_cast<double>(total)), total - 1);
+        uint64_t seen = 0;
+        for (size_t b = 0; b < kBuckets; ++b) {
+            seen += hist[b];
+            if (seen > rank) return b == 0 ? 0 : (1ull << b) - 1;
+        }
+        return (1ull << (kBuckets - 1)) - 1;
+    }
+};
+
+/**
+ * @brief 遥测用的低开销时钟：x86上读TSC（启动时按steady_clock标定），其他平台退化为steady_clock
+ */
+class TelemetryClock {
+public:
+    static uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    static uint64_t toNs(uint64_t t) {
+        return static_cast<uint64_t>(static_cast<double>(t) * nsPerTick());
+    }
+
+    /**
+     * @brief 每个tick的纳秒数（首次调用时标定约2毫秒）
+     */
+    static double nsPerTick() {
+        static const double ratio = calibrate();
+        return ratio;
+    }
+
+private:
+    static double calibrate() {
+#if defined(__x86_64__) || defined(__i386__)
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t c0 = __rdtsc();
+        while (std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(2)) {
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        uint64_t c1 = __rdtsc();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        return c1 > c0 ? ns / static_cast<double>(c1 - c0) : 1.0;
+#else
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::duration(1)).count();
+#endif
+    }
+};
+
+// ====================== 绑核参数 ======================
+/**
+ * @brief worker绑核方式
+ * @note Compact/Scatter/CpuList：第i个worker槽位绑定到顺序中的第 i % n 个CPU；
+ *       NumaNodes：worker槽位轮流分到各NUMA节点，绑定节点内全部CPU，
+ *                  WorkStealing模式下空闲worker优先窃取同节点worker的任务
+ */
+enum class AffinityMode {
+    None,
+    Compact,
+    Scatter,
+    CpuList,
+    NumaNodes,
+};
+
+struct AffinityOptions {
+    AffinityMode mode = AffinityMode::None;
+    std::vector<int> cpus;      // 仅CpuList使用
+};
+
+// ====================== 线程池 ======================
+class ThreadPool {
+public:
+    using Task = InlineTask<64>;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr uint64_t kDefaultIdleSpinNs = 50000; // 默认空闲自旋上限（纳秒）
+    static constexpr unsigned kIdleSpinCheck = 32;         // 自旋时每执行这么多次pause读一次时钟
+    static constexpr int kIdleYieldRounds = 4;             // 自旋结束后让出CPU并复查的次数，之后才休眠
+
+    /**
+     * @brief 共享队列中的任务（记录入队时间，用于弹性扩容判断）
+     */
+    struct QueuedTask {
+        Task fn;
+        Clock::time_point enqueued;
+#if THREAD_POOL_TELEMETRY
+        uint64_t enqueuedTicks = 0;
+#endif
+    };
+
+    /**
+     * @brief 共享队列：环形缓冲区，槽位预先分配，稳态下入队出队不分配内存
+     * @note 容量不足时扩容为两倍（只增不减）；出队时释放槽位中的可调用对象
+     */
+    class TaskRing {
+    private:
+        std::vector<QueuedTask> slots;
+        size_t head = 0;
+        size_t count = 0;
+
+    public:
+        explicit TaskRing(size_t capacity) : slots(capacity == 0 ? 1 : capacity) {}
+
+        bool empty() const { return count == 0; }
+        size_t size() const { return count; }
+        QueuedTask& front() { return slots[head]; }
+        QueuedTask& back() { return slots[(head + count - 1) % slots.size()]; }
+
+        void push(QueuedTask&& task) {
+            if (count == slots.size()) {
+                std::vector<QueuedTask> bigger(slots.size() * 2);
+                for (size_t i = 0; i < count; ++i) {
+                    bigger[i] = std::move(slots[(head + i) % slots.size()]);
+                }
+                slots.swap(bigger);
+                head = 0;
+            }
+            slots[(head + count) % slots.size()] = std::move(task);
+            ++count;
+        }
+
+        void pop() {
+            slots[head].fn.reset();
+            head = (head + 1) % slots.size();
+            --count;
+        }
+    };
+
+    /**
+     * @brief 每个worker槽位的遥测计数（只由该槽位的worker写，原子读写不加锁）
+     */
+    struct alignas(64) WorkerTelemetry {
+        std::atomic<uint64_t> tasks{0};
+        std::atomic<uint64_t> waitNs{0};
+        std::atomic<uint64_t> busyNs{0};
+        std::atomic<uint64_t> idleNs{0};
+        std::atomic<uint64_t> idleSince{0};           // 上个任务结束的tick（0表示正在执行任务）
+        std::atomic<uint64_t> spinHits{0};
+        std::atomic<uint64_t> parks{0};
+        std::atomic<uint64_t> waitHist[PoolTelemetry::kBuckets] = {};
+        std::atomic<uint64_t> runHist[PoolTelemetry::kBuckets] = {};
+
+        static void add(std::atomic<uint64_t>& c, uint64_t v) {
+            c.store(c.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * @brief 工作窃取模式下本地队列节点的线程本地缓存
+     * @note 节点由提交方worker分配、执行方（可能是窃取者）释放，各自在本线程缓存中复用
+     */
+    struct NodeCache {
+        static constexpr size_t kMaxCached = 256;
+        void* nodes[kMaxCached];
+        size_t count = 0;
+
+        ~NodeCache() {
+            while (count > 0) ::operator delete(nodes[--count]);
+        }
+    };
+
+    /**
+     * @brief 每个worker槽位的空闲等待状态（只由该槽位的worker访问）
+     */
+    struct alignas(64) IdleState {
+        uint64_t ewmaNs = 0;    // 最近空闲间隔的指数滑动平均（纳秒，决定自旋预算）
+    };
+
+    /**
+     * @brief 工作窃取模式下每个worker的本地状态
+     */
+    struct alignas(64) Worker {
+        WorkStealingDeque<Task*> deque;
+        uint64_t rngState;
+        int node = -1;          // NumaNodes模式下所在的节点下标
+    };
+
+    std::mutex mutex;
+    std::atomic<bool> stopFlag;
+    std::vector<std::thread> workers;                 // 按maxThreads预留槽位，弹性模式下槽位可复用
+    std::vector<char> workerUsed;                     // 槽位是否有存活的worker（受mutex保护）
+    TaskRing taskQueue;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+    size_t minThreads, maxThreads, maxQueueSize;
+    SchedulingMode mode;
+    bool elastic;
+    std::chrono::milliseconds idleTimeout;
+    std::chrono::microseconds growWaitThreshold;
+    Clock::time_point lastGrow;                       // 上次扩容时间（受mutex保护）
+    std::atomic<size_t> liveThreads;                  // 存活的worker数
+    std::vector<std::unique_ptr<Worker>> localQueues; // 仅WorkStealing模式使用
+    std::atomic<size_t> idleWorkers;                  // 正在条件变量上休眠的worker数
+    std::atomic<size_t> spinningWorkers;              // 正在自旋/让出等待任务的worker数
+    std::atomic<size_t> sharedQueued;                 // 共享队列长度（加锁写，自旋时不加锁读）
+    std::atomic<uint64_t> idleSpinNs;                 // 空闲自旋上限（纳秒，0表示不自旋）
+    std::atomic<int> idleYieldRounds;                 // 自旋后让出CPU复查的次数（0表示直接休眠）
+    std::unique_ptr<IdleState[]> idleState;           // 按槽位，容量为maxThreads
+    std::vector<int> cpuOrder;                        // 按槽位轮转绑定的CPU（Compact/Scatter/CpuList）
+    std::vector<cpu_set_t> nodeCpus;                  // 各节点的CPU集合（NumaNodes）
+    OverflowOptions overflow;                         // 背压策略（受mutex保护）
+#if THREAD_POOL_TELEMETRY
+    std::unique_ptr<WorkerTelemetry[]> telemetry;     // 按槽位，容量为maxThreads
+#endif
+
+    // 当前线程所属的线程池及worker编号（非worker线程为nullptr）
+    static ThreadPool*& currentPool() {
+        static thread_local ThreadPool* pool = nullptr;
+        return pool;
+    }
+    static size_t& currentIndex() {
+        static thread_local size_t index = 0;
+        return index;
+    }
+    static NodeCache& nodeCache() {
+        static thread_local NodeCache cache;
+        return cache;
+    }
+
+public:
+    ThreadPool(size_t threadsSize, size_t maxQueueSize = 1024,
+               SchedulingMode mode = SchedulingMode::SharedQueue,
+               const AffinityOptions& affinity = AffinityOptions())
+        : ThreadPool(ElasticOptions{threadsSize, threadsSize}, maxQueueSize, mode, affinity) {}
+
+    ThreadPool(const ElasticOptions& options, size_t maxQueueSize = 1024,
+               SchedulingMode mode = SchedulingMode::SharedQueue,
+               const AffinityOptions& affinity = AffinityOptions())
+        : stopFlag(false),
+          taskQueue(std::min<size_t>(maxQueueSize, 4096)),
+          minThreads(options.minThreads == 0 ? 1 : options.minThreads),
+          maxThreads(std::max(options.maxThreads, minThreads)),
+          maxQueueSize(maxQueueSize), mode(mode), elastic(maxThreads > minThreads),
+          idleTimeout(options.idleTimeout), growWaitThreshold(options.growWaitThreshold),
+          lastGrow(Clock::now()), liveThreads(0), idleWorkers(0), spinningWorkers(0), sharedQueued(0),
+          idleSpinNs(std::thread::hardware_concurrency() > 1 ? kDefaultIdleSpinNs : 0),
+          idleYieldRounds(kIdleYieldRounds),
+          idleState(new IdleState[maxThreads]) {
+        workers.resize(maxThreads);
+        workerUsed.assign(maxThreads, 0);
+#if THREAD_POOL_TELEMETRY
+        telemetry.reset(new WorkerTelemetry[maxThreads]);
+        TelemetryClock::nsPerTick(); // 标定放在构造时，不进入任务路径
+#endif
+        setupAffinity(affinity);
+        if (mode == SchedulingMode::WorkStealing) {
+            // 先创建全部本地队列（包括弹性扩容用的槽位），worker启动后即可互相窃取
+            for (size_t i = 0; i < maxThreads; ++i) {
+                localQueues.emplace_back(new Worker());
+                localQueues.back()->rngState = 0x9E3779B97F4A7C15ull * (i + 1);
+                if (!nodeCpus.empty()) localQueues.back()->node = static_cast<int>(i % nodeCpus.size());
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < minThreads; ++i) {
+            spawnLocked();
+        }
+        if (elastic) {
+            printf("ThreadPool init completed (elastic %zu-%zu threads).\n", minThreads, maxThreads);
+        } else {
+            printf("ThreadPool init completed.\n");
+        }
+    }
+    ~ThreadPool() {
+        shudown();
+    }
+
+    /**
+     * @brief 当前存活的worker数
+     */
+    size_t threadCount() const {
+        return liveThreads.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 设置共享队列已满时的背压策略（默认Block，一直等待）
+     */
+    void setOverflowPolicy(OverflowOptions options) {
+        std::lock_guard<std::mutex> lock(mutex);
+        overflow = std::move(options);
+        notFull.notify_all(); // 正在阻塞的提交方按新策略重新判断
+    }
+
+    /**
+     * @brief 设置worker空闲时的自旋上限（默认50微秒）
+     * @param limit 队列变空后最多自旋等待的时间，实际预算按最近的任务到达间隔自适应；
+     *              0表示不自旋也不让出，队列一空直接休眠
+     * @note 只有一个CPU时只让出不自旋（自旋只会占住提交线程需要的CPU）
+     */
+    void setIdleSpin(std::chrono::microseconds limit) {
+        uint64_t ns = limit.count() > 0 ? static_cast<uint64_t>(limit.count()) * 1000 : 0;
+        idleSpinNs.store(std::thread::hardware_concurrency() > 1 ? ns : 0, std::memory_order_relaxed);
+        idleYieldRounds.store(ns > 0 ? kIdleYieldRounds : 0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 提交任务
+     * @param task 任意 void() 可调用对象；不超过64字节的直接内联保存，不分配内存
+     * @return 提交结果；Rejected/Timeout/Stopped 时任务未被接收（右值传入的可调用对象不会被移走）
+     * @note WorkStealing模式下，worker线程内部提交的任务直接进入本地队列（不受maxQueueSize限制）；
+     *       其他线程提交的任务进入共享注入队列，队列满时按背压策略处理（setOverflowPolicy）
+     */
+    template <typename F>
+    SubmitResult submit(F&& task) {
+        if (mode == SchedulingMode::WorkStealing && currentPool() == this) {
+            if (stopFlag) return SubmitResult::Stopped;
+            localQueues[currentIndex()]->deque.push(allocNode(Task(std::forward<F>(task))));
+            wakeIdleWorkers(1);
+            return SubmitResult::Enqueued;
+        }
+        Task dropped; // DropOldest丢弃的任务，在解锁后析构
+        std::unique_lock<std::mutex> lock(mutex);
+        SubmitResult result = makeRoomLocked(lock, dropped);
+        if (result == SubmitResult::Enqueued) {
+            taskQueue.push(QueuedTask{Task(std::forward<F>(task)), elastic ? Clock::now() : Clock::time_point()});
+#if THREAD_POOL_TELEMETRY
+            taskQueue.back().enqueuedTicks = TelemetryClock::ticks();
+#endif
+            sharedQueued.store(taskQueue.size(), std::memory_order_seq_cst);
+            notifyLocked(1);
+            checkStallLocked();
+            return result;
+        }
+        lock.unlock();
+        if (result == SubmitResult::RanInline) {
+            Task inlineTask(std::forward<F>(task));
+            runTask(inlineTask);
+        }
+        return result;
+    }
+
+    /**
+     * @brief 提交任务并获取结果
+     * @param fn 无参可调用对象
+     * @return 任务结果的TaskFuture；任务抛出的异常在get()时重新抛出，
+     *         线程池已停止、任务被拒绝或被丢弃导致任务未执行时get()抛出broken_promise
+     * @note 除共享结果状态的一次分配外，与submit相同不分配内存
+     */
+    template <typename F, typename R = std::invoke_result_t<std::decay_t<F>&>>
+    TaskFuture<R> submit_future(F&& fn) {
+        TaskPromise<R> promise;
+        TaskFuture<R> future = promise.get_future();
+        submit([promise = std::move(promise), fn = std::forward<F>(fn)]() mutable {
+            try {
+                if constexpr (std::is_void<R>::value) {
+                    fn();
+                    promise.set_value();
+                } else {
+                    promise.set_value(fn());
+                }
+            }
+            catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        });
+        return future;
+    }
+
+    /**
+     * @brief 批量提交任务：只加一次锁，按入队数量一次性唤醒worker
+     * @param first,last 任务区间（元素为 void() 可调用对象，提交时被移动）
+     * @return 被接收的任务数（入队或在提交线程上执行）；即前k个任务已被接收，其余未被移动
+     * @note 共享队列剩余空间不足时，先提交能放下的部分并唤醒worker，再按背压策略逐个处理，
+     *       遇到第一个未被接收的任务即停止
+     */
+    template <typename Iterator>
+    size_t submit_bulk(Iterator first, Iterator last) {
+        size_t submitted = 0;
+        if (mode == SchedulingMode::WorkStealing && currentPool() == this) {
+            if (stopFlag) return 0;
+            auto& deque = localQueues[currentIndex()]->deque;
+            for (; first != last; ++first, ++submitted) {
+                deque.push(allocNode(Task(std::move(*first))));
+            }
+            wakeIdleWorkers(submitted);
+            return submitted;
+        }
+
+        std::vector<Task> dropped; // DropOldest丢弃的任务，在解锁后析构
+        std::unique_lock<std::mutex> lock(mutex);
+        while (first != last) {
+            Task oldest;
+            SubmitResult result = makeRoomLocked(lock, oldest);
+            if (oldest) dropped.push_back(std::move(oldest));
+            if (result == SubmitResult::RanInline) {
+                Task inlineTask(std::move(*first));
+                ++first;
+                ++submitted;
+                lock.unlock();
+                runTask(inlineTask);
+                lock.lock();
+                continue;
+            }
+            if (result != SubmitResult::Enqueued) break;
+            Clock::time_point now = elastic ? Clock::now() : Clock::time_point();
+#if THREAD_POOL_TELEMETRY
+            uint64_t ticks = TelemetryClock::ticks();
+#endif
+            size_t pushed = 0;
+            for (; first != last && taskQueue.size() < maxQueueSize; ++first, ++pushed) {
+                taskQueue.push(QueuedTask{Task(std::move(*first)), now});
+#if THREAD_POOL_TELEMETRY
+                taskQueue.back().enqueuedTicks = ticks;
+#endif
+            }
+            submitted += pushed;
+            sharedQueued.store(taskQueue.size(), std::memory_order_seq_cst);
+            notifyLocked(pushed);
+            checkStallLocked();
+        }
+        return submitted;
+    }
+
+    template <typename Range>
+    size_t submit_bulk(Range&& range) {
+        return submit_bulk(std::begin(range), std::end(range));
+    }
+
+    /**
+     * @brief 获取遥测快照（合并所有worker槽位，包括已回收worker的累计值）
+     * @note 编译时关闭遥测（THREAD_POOL_TELEMETRY=0）时返回全零
+     */
+    PoolTelemetry telemetrySnapshot() const {
+        PoolTelemetry out;
+#if THREAD_POOL_TELEMETRY
+        uint64_t now = TelemetryClock::ticks();
+        for (size_t i = 0; i < maxThreads; ++i) {
+            const WorkerTelemetry& w = telemetry[i];
+            out.tasks += w.tasks.load(std::memory_order_relaxed);
+            out.waitNs += w.waitNs.load(std::memory_order_relaxed);
+            out.busyNs += w.busyNs.load(std::memory_order_relaxed);
+            out.idleNs += w.idleNs.load(std::memory_order_relaxed);
+            out.spinHits += w.spinHits.load(std::memory_order_relaxed);
+            out.parks += w.parks.load(std::memory_order_relaxed);
+            uint64_t since = w.idleSince.load(std::memory_order_relaxed);
+            if (since != 0 && now > since) out.idleNs += TelemetryClock::toNs(now - since);
+            for (size_t b = 0; b < PoolTelemetry::kBuckets; ++b) {
+                out.waitHist[b] += w.waitHist[b].load(std::memory_order_relaxed);
+                out.runHist[b] += w.runHist[b].load(std::memory_order_relaxed);
+            }
+        }
+#endif
+        return out;
+    }
+
+    void shudown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopFlag) return;
+            stopFlag.store(true);
+        }
+        // stopFlag置位后不会再扩容或回收worker，workers不再变化
+        notFull.notify_all();
+        notEmpty.notify_all();
+        for (auto& t : workers) {
+            if(t.joinable()) {
+                t.join();
+            }
+        }
+    }
+
+private:
+    static void runTask(Task& task) {
+        try {
+            task();
+        }
+        catch(const std::exception& e) {
+            std::cerr << e.what() << '\n';
+        }
+    }
+
+    /**
+     * @brief 执行任务并记录遥测
+     * @param index worker槽位
+     * @param enqueuedTicks 入队时间（0表示未知，不计排队时间）
+     */
+    void runTaskTimed(size_t index, Task& task, uint64_t enqueuedTicks) {
+#if THREAD_POOL_TELEMETRY
+        WorkerTelemetry& w = telemetry[index];
+        uint64_t start = TelemetryClock::ticks();
+        uint64_t since = w.idleSince.load(std::memory_order_relaxed);
+        if (since != 0 && start > since) WorkerTelemetry::add(w.idleNs, TelemetryClock::toNs(start - since));
+        w.idleSince.store(0, std::memory_order_relaxed);
+        if (enqueuedTicks != 0) {
+            uint64_t wait = start > enqueuedTicks ? TelemetryClock::toNs(start - enqueuedTicks) : 0;
+            WorkerTelemetry::add(w.waitNs, wait);
+            WorkerTelemetry::add(w.waitHist[PoolTelemetry::bucket(wait)], 1);
+        }
+        runTask(task);
+        uint64_t end = TelemetryClock::ticks();
+        uint64_t run = TelemetryClock::toNs(end - start);
+        WorkerTelemetry::add(w.tasks, 1);
+        WorkerTelemetry::add(w.busyNs, run);
+        WorkerTelemetry::add(w.runHist[PoolTelemetry::bucket(run)], 1);
+        w.idleSince.store(end, std::memory_order_relaxed);
+#else
+        (void)index;
+        (void)enqueuedTicks;
+        runTask(task);
+#endif
+    }
+
+    /**
+     * @brief worker启动/退出时标记空闲计时的起止
+     */
+    void markIdle(size_t index, bool idle) {
+#if THREAD_POOL_TELEMETRY
+        WorkerTelemetry& w = telemetry[index];
+        if (idle) {
+            w.idleSince.store(TelemetryClock::ticks(), std::memory_order_relaxed);
+            return;
+        }
+        uint64_t since = w.idleSince.exchange(0, std::memory_order_relaxed);
+        uint64_t now = TelemetryClock::ticks();
+        if (since != 0 && now > since) WorkerTelemetry::add(w.idleNs, TelemetryClock::toNs(now - since));
+#else
+        (void)index;
+        (void)idle;
+#endif
+    }
+
+    // ---------------------- 本地队列节点 ----------------------
+    static Task* allocNode(Task&& task) {
+        NodeCache& cache = nodeCache();
+        void* mem = cache.count > 0 ? cache.nodes[--cache.count] : ::operator new(sizeof(Task));
+        return ::new (mem) Task(std::move(task));
+    }
+
+    static void freeNode(Task* node) {
+        node->~Task();
+        NodeCache& cache = nodeCache();
+        if (cache.count < NodeCache::kMaxCached) {
+            cache.nodes[cache.count++] = node;
+        } else {
+            ::operator delete(node);
+        }
+    }
+
+    // ---------------------- 绑核 ----------------------
+    /**
+     * @brief 根据绑核参数计算每个槽位的CPU（拓扑读取失败时打印警告并不绑核）
+     */
+    void setupAffinity(const AffinityOptions& affinity) {
+        if (affinity.mode == AffinityMode::None) return;
+        if (affinity.mode == AffinityMode::CpuList) {
+            cpuOrder = affinity.cpus;
+            return;
+        }
+        cpu_topology_t topo;
+        if (cpu_topology_load(&topo) != 0) {
+            std::cerr << "ThreadPool: read cpu topology failed, affinity disabled" << '\n';
+            return;
+        }
+        if (affinity.mode == AffinityMode::NumaNodes) {
+            nodeCpus.resize(topo.num_nodes);
+            for (int i = 0; i < topo.num_nodes; ++i) {
+                cpu_topology_node_cpus(&topo, topo.nodes[i], &nodeCpus[i]);
+            }
+        } else {
+            cpuOrder.resize(topo.num_cpus);
+            int n = cpu_topology_order(&topo, affinity.mode == AffinityMode::Scatter ? AFFINITY_SCATTER
+                                                                                     : AFFINITY_COMPACT,
+                                       cpuOrder.data());
+            cpuOrder.resize(n > 0 ? n : 0);
+        }
+        cpu_topology_free(&topo);
+    }
+
+    /**
+     * @brief worker启动后先绑定到槽位对应的CPU
+     */
+    void bindCurrentThread(size_t index) {
+        int ret = 0;
+        if (!cpuOrder.empty()) {
+            ret = cpu_bind_thread(pthread_self(), cpuOrder[index % cpuOrder.size()]);
+        } else if (!nodeCpus.empty()) {
+            const cpu_set_t& set = nodeCpus[index % nodeCpus.size()];
+            ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        }
+        if (ret != 0) {
+            std::cerr << "ThreadPool: bind worker " << index << " failed: " << ret << '\n';
+        }
+    }
+
+    // ---------------------- 弹性伸缩 ----------------------
+    /**
+     * @brief 在空闲槽位上启动一个worker（需持有mutex）
+     */
+    bool spawnLocked() {
+        for (size_t i = 0; i < maxThreads; ++i) {
+            if (workerUsed[i]) continue;
+            if (workers[i].joinable()) workers[i].join(); // 理论上不会发生：回收的worker已分离
+            if (mode == SchedulingMode::WorkStealing) {
+                workers[i] = std::thread([this, i]{this->bindCurrentThread(i); this->stealingLoop(i);});
+            } else {
+                workers[i] = std::thread([this, i]{this->bindCurrentThread(i); this->workLoop(i);});
+            }
+            workerUsed[i] = 1;
+            liveThreads.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief 取到一个排队过久的任务且没有空闲worker时扩容（需持有mutex）
+     * @note 两次扩容至少间隔growWaitThreshold，避免突发流量下一次性建满线程
+     */
+    void maybeGrowLocked(Clock::time_point enqueued) {
+        if (!elastic || stopFlag || idleWorkers.load(std::memory_order_relaxed) > 0 ||
+            liveThreads.load(std::memory_order_relaxed) >= maxThreads) {
+            return;
+        }
+        Clock::time_point now = Clock::now();
+        if (now - enqueued < growWaitThreshold || now - lastGrow < growWaitThreshold) return;
+        if (spawnLocked()) {
+            lastGrow = now;
+            printf("ThreadPool grow: %zu threads\n", liveThreads.load());
+        }
+    }
+
+    /**
+     * @brief 提交方检查：队首任务排队过久（worker全部阻塞在长任务上）时扩容（需持有mutex）
+     */
+    void checkStallLocked() {
+        if (elastic && !taskQueue.empty()) {
+            maybeGrowLocked(taskQueue.front().enqueued);
+        }
+    }
+
+    /**
+     * @brief 为一个新任务在共享队列中腾出位置，队列已满时按背压策略处理（需持有mutex）
+     * @param dropped DropOldest时被丢弃的任务移到这里，由调用方在解锁后析构
+     * @return Enqueued：可以入队；RanInline：调用方应在解锁后直接执行；其余：任务不被接收
+     * @note Block策略下等待期间策略可能被修改，每次被唤醒后重新判断；Callback可能因此被调用多次
+     */
+    SubmitResult makeRoomLocked(std::unique_lock<std::mutex>& lock, Task& dropped) {
+        Clock::time_point deadline;
+        bool timed = false;
+        while (true) {
+            if (stopFlag) return SubmitResult::Stopped;
+            if (taskQueue.size() < maxQueueSize) return SubmitResult::Enqueued;
+
+            OverflowPolicy policy = overflow.policy;
+            if (policy == OverflowPolicy::Callback) {
+                policy = overflow.callback ? overflow.callback(taskQueue.size()) : OverflowPolicy::Reject;
+            }
+            switch (policy) {
+            case OverflowPolicy::Block:
+                if (overflow.timeout.count() > 0) {
+                    if (!timed) {
+                        deadline = Clock::now() + overflow.timeout;
+                        timed = true;
+                    } else if (Clock::now() >= deadline) {
+                        return SubmitResult::Timeout;
+                    }
+                    notFull.wait_until(lock, deadline);
+                } else {
+                    notFull.wait(lock);
+                }
+                break;
+            case OverflowPolicy::CallerRuns:
+                return SubmitResult::RanInline;
+            case OverflowPolicy::DropOldest:
+                if (taskQueue.empty()) return SubmitResult::Rejected; // maxQueueSize为0
+                dropped = std::move(taskQueue.front().fn);
+                taskQueue.pop();
+                return SubmitResult::Enqueued;
+            default:
+                return SubmitResult::Rejected;
+            }
+        }
+    }
+
+    /**
+     * @brief 等待任务：先不加锁自旋、再让出CPU，仍没有任务才在条件变量上休眠；弹性模式下最多休眠idleTimeout
+     * @param index worker槽位
+     * @param pred 有任务或已停止（持有mutex时调用）
+     * @param hint 同pred，但不加锁调用（只读原子变量，允许偶尔不准，最终以pred为准）
+     * @return 条件满足返回true，空闲超时返回false
+     * @note 提交方看到有worker在自旋时少唤醒相应数量的休眠worker；
+     *       自旋结束后先加锁复查pred再休眠，不会漏掉这期间入队的任务
+     */
+    template <typename Pred, typename Hint>
+    bool waitForWork(size_t index, std::unique_lock<std::mutex>& lock, Pred pred, Hint hint) {
+        if (pred()) return true;
+        Clock::time_point start = Clock::now();
+        lock.unlock();
+#if THREAD_POOL_TELEMETRY
+        bool spun = spinForWork(index, start, hint);
+#else
+        spinForWork(index, start, hint);
+#endif
+        lock.lock();
+
+        bool ready = true;
+        if (!pred()) {
+#if THREAD_POOL_TELEMETRY
+            spun = false;
+#endif
+            idleWorkers.fetch_add(1, std::memory_order_seq_cst);
+#if THREAD_POOL_TELEMETRY
+            WorkerTelemetry::add(telemetry[index].parks, 1);
+#endif
+            if (elastic) {
+                ready = notEmpty.wait_for(lock, idleTimeout, pred);
+            } else {
+                notEmpty.wait(lock, pred);
+            }
+            idleWorkers.fetch_sub(1, std::memory_order_seq_cst);
+        }
+#if THREAD_POOL_TELEMETRY
+        if (spun) WorkerTelemetry::add(telemetry[index].spinHits, 1);
+#endif
+
+        // 更新空闲间隔的滑动平均（权重1/8）；截断过长的间隔，负载回升后几次就能恢复自旋
+        uint64_t limit = idleSpinNs.load(std::memory_order_relaxed);
+        uint64_t gap = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        uint64_t& ewma = idleState[index].ewmaNs;
+        ewma = ewma - ewma / 8 + std::min(gap, limit * 4) / 8;
+
+        // 提交方因为有worker自旋而少唤醒的任务：自己只取一个，其余交给休眠的worker
+        if (ready && taskQueue.size() > 1 && idleWorkers.load(std::memory_order_relaxed) > 0) {
+            notEmpty.notify_one();
+        }
+        return ready;
+    }
+
+    /**
+     * @brief 休眠前的自适应等待（不持有mutex）
+     * @return hint在等待期间成立返回true
+     * @note 自旋预算为最近空闲间隔平均值的2倍（不超过idleSpinNs）：到达间隔短时在自旋中接到任务，
+     *       省掉一次futex唤醒和两次上下文切换；平均间隔超过上限时只让出几次CPU。
+     *       同时自旋的worker不超过存活worker数的一半
+     */
+    template <typename Hint>
+    bool spinForWork(size_t index, Clock::time_point start, Hint hint) {
+        int yieldRounds = idleYieldRounds.load(std::memory_order_relaxed);
+        if (yieldRounds == 0) return false;
+        size_t limit = std::max<size_t>(1, liveThreads.load(std::memory_order_relaxed) / 2);
+        if (spinningWorkers.fetch_add(1, std::memory_order_seq_cst) >= limit) {
+            spinningWorkers.fetch_sub(1, std::memory_order_seq_cst);
+            return false;
+        }
+
+        bool found = false;
+        uint64_t maxNs = idleSpinNs.load(std::memory_order_relaxed);
+        uint64_t ewma = idleState[index].ewmaNs;
+        if (maxNs > 0 && ewma <= maxNs) {
+            Clock::time_point end = start + std::chrono::nanoseconds(std::min(ewma * 2 + maxNs / 16, maxNs));
+            for (unsigned i = 1; !(found = hint()); ++i) {
+                cpuRelax();
+                if (i % kIdleSpinCheck == 0 && Clock::now() >= end) break;
+            }
+        }
+        for (int i = 0; !found && i < yieldRounds; ++i) {
+            std::this_thread::yield();
+            found = hint();
+        }
+        spinningWorkers.fetch_sub(1, std::memory_order_seq_cst);
+        return found;
+    }
+
+    static void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#elif defined(__aarch64__)
+        __asm__ __volatile__("yield" ::: "memory");
+#endif
+    }
+
+    /**
+     * @brief 共享队列入队后唤醒休眠的worker（需持有mutex）
+     * @param n 新任务数
+     * @note idleWorkers在持有mutex时增减，这里读到的是准确值；正在自旋的worker会自己取走任务
+     */
+    void notifyLocked(size_t n) {
+        size_t idle = idleWorkers.load(std::memory_order_relaxed);
+        size_t spinning = spinningWorkers.load(std::memory_order_seq_cst);
+        if (idle == 0 || n <= spinning) return;
+        n -= spinning;
+        if (n >= idle) {
+            notEmpty.notify_all();
+        } else {
+            for (size_t i = 0; i < n; ++i) notEmpty.notify_one();
+        }
+    }
+
+    /**
+     * @brief 空闲超时的worker尝试退出（需持有mutex）
+     * @return 需要退出返回true（线程已分离，调用方应直接返回；解锁后线程池可能已析构，不能再访问成员）
+     */
+    bool retireLocked(size_t index) {
+        if (stopFlag || liveThreads.load(std::memory_order_relaxed) <= minThreads) return false;
+        markIdle(index, false);
+        workerUsed[index] = 0;
+        workers[index].detach();
+        liveThreads.fetch_sub(1, std::memory_order_relaxed);
+        printf("ThreadPool shrink: %zu threads\n", liveThreads.load());
+        return true;
+    }
+
+    // ---------------------- SharedQueue 模式 ----------------------
+    void workLoop(size_t index) {
+        markIdle(index, true);
+        while(true) {
+            Task task;
+            uint64_t enqueuedTicks = 0;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (!waitForWork(index, lock, [this]{return stopFlag || !taskQueue.empty();},
+                                 [this]{return stopFlag.load(std::memory_order_relaxed) ||
+                                               sharedQueued.load(std::memory_order_relaxed) > 0;})) {
+                    if (retireLocked(index)) return;
+                    continue;
+                }
+                if (stopFlag && taskQueue.empty()) break;
+                QueuedTask& front = taskQueue.front();
+                task = std::move(front.fn);
+                Clock::time_point enqueued = front.enqueued;
+#if THREAD_POOL_TELEMETRY
+                enqueuedTicks = front.enqueuedTicks;
+#endif
+                taskQueue.pop();
+                sharedQueued.store(taskQueue.size(), std::memory_order_relaxed);
+                notFull.notify_one();
+                if (elastic) maybeGrowLocked(enqueued);
+            }
+            runTaskTimed(index, task, enqueuedTicks);
+        }
+        markIdle(index, false);
+    }
+
+    // ---------------------- WorkStealing 模式 ----------------------
+    /**
+     * @brief 本地队列有新任务时唤醒休眠的worker
+     * @param n 新任务数
+     * @note 入队后全屏障再读idleWorkers，与休眠方"先登记再复查"配对，避免丢失唤醒
+     */
+    void wakeIdleWorkers(size_t n) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        size_t idle = idleWorkers.load(std::memory_order_seq_cst);
+        if (idle == 0 || n == 0) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        notifyLocked(n);
+    }
+
+    bool anyLocalWork() const {
+        for (const auto& w : localQueues) {
+            if (!w->deque.empty()) return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief 从随机选取的其他worker窃取一个任务（未启用的槽位队列为空，直接跳过）
+     * @note NumaNodes模式下先扫一遍同节点的worker，都为空时才跨节点窃取
+     */
+    Task* stealFromOthers(size_t self) {
+        size_t n = localQueues.size();
+        if (n <= 1) return nullptr;
+        uint64_t& x = localQueues[self]->rngState;
+        // xorshift64
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        size_t start = static_cast<size_t>(x % n);
+        int node = localQueues[self]->node;
+        for (int pass = (node >= 0 ? 0 : 1); pass < 2; ++pass) {
+            for (size_t i = 0; i < n; ++i) {
+                size_t victim = (start + i) % n;
+                if (victim == self || (pass == 0 && localQueues[victim]->node != node)) continue;
+                Task* task = localQueues[victim]->deque.steal();
+                if (task) return task;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief 工作窃取模式的worker循环：本地队列 -> 共享注入队列 -> 窃取 -> 休眠
+     * @note 只有本线程向自己的本地队列压入任务，空闲超时退出时本地队列必然为空
+     */
+    void stealingLoop(size_t index) {
+        currentPool() = this;
+        currentIndex() = index;
+        Worker& self = *localQueues[index];
+        markIdle(index, true);
+
+        while (true) {
+            // 1. 本地队列（LIFO）
+            Task* local = self.deque.pop();
+            if (local) {
+                runTaskTimed(index, *local, 0);
+                freeNode(local);
+                continue;
+            }
+
+            // 2. 共享注入队列：先不加锁看长度，为空时直接去窃取（空闲/窃取中的worker不争抢mutex），
+            //    这里偶尔读到旧值也没关系，休眠前第4步会在锁内复查
+            Task task;
+            bool gotShared = false;
+            uint64_t enqueuedTicks = 0;
+            if (sharedQueued.load(std::memory_order_relaxed) > 0) {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (!taskQueue.empty()) {
+                    QueuedTask& front = taskQueue.front();
+                    task = std::move(front.fn);
+                    Clock::time_point enqueued = front.enqueued;
+#if THREAD_POOL_TELEMETRY
+                    enqueuedTicks = front.enqueuedTicks;
+#endif
+                    taskQueue.pop();
+                    sharedQueued.store(taskQueue.size(), std::memory_order_relaxed);
+                    gotShared = true;
+                    notFull.notify_one();
+                    if (elastic) maybeGrowLocked(enqueued);
+                }
+            }
+            if (gotShared) {
+                runTaskTimed(index, task, enqueuedTicks);
+                continue;
+            }
+
+            // 3. 随机窃取
+            Task* stolen = stealFromOthers(index);
+            if (stolen) {
+                runTaskTimed(index, *stolen, 0);
+                freeNode(stolen);
+                continue;
+            }
+
+            // 4. 所有队列都为空：登记为空闲后复查，确实没有任务才休眠
+            std::unique_lock<std::mutex> lock(mutex);
+            bool ready = waitForWork(index, lock, [this]{
+                return stopFlag || !taskQueue.empty() || anyLocalWork();
+            }, [this]{
+                return stopFlag.load(std::memory_order_relaxed) ||
+                       sharedQueued.load(std::memory_order_relaxed) > 0 || anyLocalWork();
+            });
+            if (!ready && retireLocked(index)) {
+                currentPool() = nullptr;
+                return;
+            }
+            if (stopFlag && taskQueue.empty() && !anyLocalWork()) break;
+        }
+
+        markIdle(index, false);
+        currentPool() = nullptr;
+    }
+};
+
+#endif // _THREAD_POOL_HPP_
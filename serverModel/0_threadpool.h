@@ -1,16 +1,56 @@
 #ifndef _THREAD_POOL_H_
 #define _THREAD_POOL_H_
 
+#include "0_cpu_topology.h" // 需在系统头文件之前（定义_GNU_SOURCE）
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <pthread.h>
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <sched.h>
+#include <time.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 // ====================== 配置参数（可按需修改） ======================
 #define DEFAULT_THREAD_NUM 4    // 默认线程数
-#define MAX_TASK_QUEUE 1024     // 任务队列最大长度（0表示无限制）
+#define MAX_TASK_QUEUE 1024     // 任务队列最大长度（0表示不做额外限制，容量取 TASK_RING_DEFAULT_CAPACITY）
+#define TASK_RING_DEFAULT_CAPACITY 65536 // 环形队列默认容量（必须是2的幂）
+#define CACHE_LINE_SIZE 64      // CPU缓存行大小，用于填充避免伪共享
+#define TASK_SLAB_SIZE 256      // 每个slab包含的任务节点数
+#define TASK_CACHE_SIZE 64      // 线程本地任务节点缓存上限
+#define TASK_CACHE_BATCH 32     // 线程本地缓存与全局空闲链表之间每次搬运的节点数
+#define DEFAULT_IDLE_TIMEOUT_MS 10000 // 弹性模式：空闲线程回收超时（毫秒）
+#define DEFAULT_GROW_WAIT_US 1000     // 弹性模式：任务排队超过该时长（微秒）则扩容
+#define THREAD_POOL_LANES 3     // 优先级通道数
+#define DEFAULT_LANE_WEIGHT_HIGH 16   // 各通道默认调度权重（加权轮转，保证低优先级不被饿死）
+#define DEFAULT_LANE_WEIGHT_NORMAL 4
+#define DEFAULT_LANE_WEIGHT_LOW 1
+#ifndef THREAD_POOL_TELEMETRY
+#define THREAD_POOL_TELEMETRY 1 // 遥测开关：编译时 -DTHREAD_POOL_TELEMETRY=0 关闭，记录代码全部编译掉
+#endif
+#define THREAD_POOL_HIST_BUCKETS 32   // 直方图桶数：第i桶为 [2^(i-1), 2^i) 纳秒，最后一桶包含更大的值
+#define OVERFLOW_WAIT_SLICE_MS 1      // OVERFLOW_BLOCK：每次等待空位的最长时间，超时后重试入队（兜底丢失的通知）
+#define OVERFLOW_DROP_RETRY 8         // OVERFLOW_DROP_OLDEST：丢弃后仍被其他生产者抢占空位时的最大重试次数
+#define STRAND_BATCH 64               // strand每次被调度最多连续执行的任务数，超过后让出线程（不同strand之间公平）
+#define DEFAULT_IDLE_SPIN_US 50       // 队列变空后最多自旋等待的时间（微秒），实际预算按最近的任务到达间隔自适应
+#define IDLE_YIELD_ROUNDS 4           // 自旋结束后让出CPU并复查队列的次数，之后才休眠
+#define IDLE_SPIN_CHECK 32            // 自旋时每执行这么多次pause读一次时钟
+#define TIMER_BATCH 64                // 定时线程每次批量提交到线程池的最多到期任务数
+#define TIMER_RETRY_MS 1              // 到期任务因队列满未被接收时，稍后重试的间隔（毫秒）
+#define TIMER_COMPACT_MIN 64          // 堆中已取消的条目超过该数且超过堆的一半时整理堆
+#define THREAD_POOL_GROUP_MAX 8       // 线程池组最多包含的命名子线程池数
+#define THREAD_POOL_NAME_LEN 32       // 子线程池名称最大长度（含结尾'\0'）
+
+// ====================== 提交结果 ======================
+#define THREAD_POOL_OK 0              // 已入队
+#define THREAD_POOL_RAN_INLINE 1      // 队列满，任务已在提交线程上执行（OVERFLOW_CALLER_RUNS）
+#define THREAD_POOL_ERROR (-1)        // 参数错误、线程池已停止或内存不足
+#define THREAD_POOL_REJECTED (-2)     // 队列满，任务被拒绝
+#define THREAD_POOL_TIMEOUT (-3)      // 队列满，等待空位超时（OVERFLOW_BLOCK）
 
 // ====================== 任务结构体（通用任务封装） ======================
 /**
@@ -20,29 +60,412 @@
 typedef struct task {
     void (*func)(void*);        // 任务函数指针
     void* arg;                  // 任务函数参数
-    struct task* next;          // 链表节点，指向下一个任务
+    struct task* next;          // 空闲链表节点（仅在分配器缓存中使用）
+    uint64_t enqueue_ns;        // 入队时间（单调时钟，纳秒）
+    uint64_t deadline_ns;       // 截止时间（单调时钟，纳秒；0表示无截止时间）
+    void (*on_expired)(void*);  // 超时或被丢弃时的回调（用于释放arg，可为NULL）
+    int lane;                   // 所在优先级通道
 } task_t;
 
+// ====================== 优先级与截止时间 ======================
+/**
+ * @brief 任务优先级通道（数值越小优先级越高）
+ */
+typedef enum {
+    TASK_PRIO_HIGH = 0,         // 延迟敏感：小请求、健康检查
+    TASK_PRIO_NORMAL = 1,       // 默认
+    TASK_PRIO_LOW = 2,          // 批量/后台任务
+} task_priority_t;
+
+/**
+ * @brief 任务超过截止时间（出队时判断）后的处理方式
+ */
+typedef enum {
+    DEADLINE_DROP = 0,          // 丢弃，不执行（有on_expired回调则调用回调）
+    DEADLINE_FLAG = 1,          // 照常执行，任务内可通过 thread_pool_task_expired() 得知已超时
+} deadline_policy_t;
+
+// ====================== 背压策略 ======================
+/**
+ * @brief 通道已满时新任务的处理方式
+ */
+typedef enum {
+    OVERFLOW_REJECT = 0,        // 直接拒绝，返回 THREAD_POOL_REJECTED（默认）
+    OVERFLOW_BLOCK = 1,         // 阻塞等待空位，最多 overflow_timeout_ms（0表示一直等待）
+    OVERFLOW_CALLER_RUNS = 2,   // 在提交线程上直接执行任务，返回 THREAD_POOL_RAN_INLINE
+    OVERFLOW_DROP_OLDEST = 3,   // 丢弃通道中最旧的任务后入队（被丢弃的任务有on_expired回调则在提交线程上调用）
+    OVERFLOW_CALLBACK = 4,      // 调用 on_overflow，由回调按任务决定采用以上哪种方式
+} overflow_policy_t;
+
+struct thread_pool;
+
+/**
+ * @brief OVERFLOW_CALLBACK 的回调
+ * @param pool 线程池指针
+ * @param lane 已满的通道
+ * @param func 被阻挡的任务函数
+ * @param arg 被阻挡的任务参数
+ * @param user 配置中的 overflow_user
+ * @return 本次采用的处理方式（OVERFLOW_REJECT/BLOCK/CALLER_RUNS/DROP_OLDEST，其他值按REJECT处理）
+ * @note 在提交线程上调用，不持有线程池的锁
+ */
+typedef int (*thread_pool_overflow_fn)(struct thread_pool* pool, int lane, void (*func)(void*), void* arg, void* user);
+
+/**
+ * @brief 单个任务的提交选项
+ */
+typedef struct task_options {
+    int priority;               // 优先级通道（task_priority_t）
+    int deadline_ms;            // 相对截止时间（毫秒，0表示无截止时间）
+    void (*on_expired)(void*);  // 超时或被 OVERFLOW_DROP_OLDEST 丢弃时的回调（可为NULL）
+} task_options_t;
+
+/**
+ * @brief 单个优先级通道的统计
+ */
+typedef struct thread_pool_lane_stats {
+    size_t depth;               // 当前排队任务数（近似值）
+    uint64_t submitted;         // 累计入队数
+    uint64_t executed;          // 累计执行数（含超时后照常执行的）
+    uint64_t expired;           // 累计超时数
+    uint64_t rejected;          // 累计因队列满被拒绝数（含等待超时）
+    uint64_t dropped;           // 累计被 OVERFLOW_DROP_OLDEST 丢弃数
+    uint64_t ran_inline;        // 累计被 OVERFLOW_CALLER_RUNS 在提交线程上执行数
+    uint64_t wait_ns_total;     // 累计排队时间（纳秒）
+    uint64_t wait_ns_max;       // 最大排队时间（纳秒）
+} thread_pool_lane_stats_t;
+
+/**
+ * @brief 通道内部计数器：提交方的计数（原子访问，各通道独占缓存行）
+ */
+typedef struct lane_counters {
+    uint64_t submitted;
+    uint64_t rejected;
+    uint64_t dropped;
+    uint64_t ran_inline;
+} __attribute__((aligned(CACHE_LINE_SIZE))) lane_counters_t;
+
+/**
+ * @brief 单个工作线程在一个通道上的执行计数（只由本槽位的线程写，读取统计时合并，不共享缓存行）
+ */
+typedef struct worker_lane_counters {
+    uint64_t executed;
+    uint64_t expired;
+    uint64_t wait_ns_total;
+    uint64_t wait_ns_max;
+} worker_lane_counters_t;
+
+// ====================== 任务节点分配器（slab + 线程本地缓存） ======================
+/**
+ * @brief 任务节点分配统计
+ * @note 命中数在线程本地累计，按批次汇总到全局，读取到的值可能滞后不超过一个批次
+ */
+typedef struct task_alloc_stats {
+    uint64_t cache_hits;        // 直接从线程本地缓存分配的次数
+    uint64_t cache_misses;      // 本地缓存为空、需从全局空闲链表补充的次数
+    uint64_t slab_allocs;       // 全局空闲链表也为空、新分配slab的次数（即malloc次数）
+    uint64_t nodes_total;       // 已分配的任务节点总数
+} task_alloc_stats_t;
+
+/**
+ * @brief slab：一次malloc得到的一组任务节点
+ * @note slab在进程生命周期内不归还系统，空闲节点在全局空闲链表和各线程缓存之间流动
+ */
+typedef struct task_slab {
+    struct task_slab* next;
+    task_t tasks[TASK_SLAB_SIZE];
+} task_slab_t;
+
+/**
+ * @brief 线程本地任务节点缓存
+ */
+typedef struct task_cache {
+    task_t* head;               // 缓存链表头
+    int count;                  // 缓存节点数
+    int registered;             // 是否已注册线程退出回调
+    uint64_t hits;              // 尚未汇总到全局的命中数
+} task_cache_t;
+
+// ====================== 无锁MPMC环形队列 ======================
+/**
+ * @brief 环形队列槽位
+ * @note seq 为槽位序号（Vyukov 有界MPMC算法）：
+ *       seq == pos     表示槽位空闲，可由位置为pos的生产者写入
+ *       seq == pos + 1 表示槽位已写入，可由位置为pos的消费者读取
+ */
+typedef struct task_ring_cell {
+    size_t seq;                 // 槽位序号（原子访问）
+    task_t* task;               // 任务指针
+} task_ring_cell_t;
+
+/**
+ * @brief 有界无锁MPMC环形队列
+ * @note 生产者下标和消费者下标各占一个缓存行，避免生产者/消费者之间的伪共享
+ */
+typedef struct task_ring {
+    task_ring_cell_t* cells;    // 槽位数组
+    size_t mask;                // 容量-1（容量为2的幂）
+    char pad0[CACHE_LINE_SIZE];
+    size_t enqueue_pos __attribute__((aligned(CACHE_LINE_SIZE))); // 生产者下标（原子访问）
+    char pad1[CACHE_LINE_SIZE - sizeof(size_t)];
+    size_t dequeue_pos __attribute__((aligned(CACHE_LINE_SIZE))); // 消费者下标（原子访问）
+    char pad2[CACHE_LINE_SIZE - sizeof(size_t)];
+} task_ring_t;
+
+// ====================== 遥测 ======================
+/**
+ * @brief 线程池遥测数据（每个工作线程一份，快照时合并）
+ * @note wait：入队到开始执行；busy：执行任务的时间；idle：休眠等待任务的时间
+ */
+typedef struct thread_pool_telemetry {
+    uint64_t tasks;             // 取到的任务数
+    uint64_t wait_ns;           // 累计排队时间
+    uint64_t busy_ns;           // 累计执行时间
+    uint64_t idle_ns;           // 累计休眠时间
+    uint64_t spin_hits;         // 在自旋/让出阶段等到任务的次数（省掉一次休眠和唤醒）
+    uint64_t parks;             // 进入休眠的次数
+    uint64_t wait_hist[THREAD_POOL_HIST_BUCKETS]; // 排队时间直方图（log2纳秒）
+    uint64_t run_hist[THREAD_POOL_HIST_BUCKETS];  // 执行时间直方图（log2纳秒）
+} thread_pool_telemetry_t;
+
+/**
+ * @brief 工作线程上下文（每个线程槽位一份，按缓存行对齐）
+ */
+typedef struct thread_pool_worker {
+    struct thread_pool* pool;   // 所属线程池
+    int slot;                   // 线程槽位下标
+    uint64_t idle_ewma_ns;      // 最近空闲间隔的指数滑动平均（纳秒，决定自旋预算，只由本线程访问）
+    worker_lane_counters_t lanes[THREAD_POOL_LANES]; // 各通道的执行计数（原子读写，不加锁）
+#if THREAD_POOL_TELEMETRY
+    uint64_t run_start_ns;      // 当前任务的开始时间（0表示没有在执行的任务）
+    uint64_t idle_since_ns;     // 开始休眠的时间（0表示未休眠，原子访问，快照时计入进行中的休眠）
+    thread_pool_telemetry_t telemetry; // 只由本槽位的线程写（原子读写，不加锁）
+#endif
+} __attribute__((aligned(CACHE_LINE_SIZE))) thread_pool_worker_t;
+
+// ====================== 线程池配置 ======================
+/**
+ * @brief 线程池创建参数
+ * @note max_threads > min_threads 时启用弹性模式：
+ *       任务排队时间超过 grow_wait_us 且没有空闲线程时扩容（不超过max_threads），
+ *       线程空闲超过 idle_timeout_ms 时回收（不少于min_threads）
+ */
+typedef struct thread_pool_config {
+    int min_threads;            // 最小（常驻）线程数
+    int max_threads;            // 最大线程数
+    int idle_timeout_ms;        // 空闲线程回收超时（毫秒，0表示不回收）
+    int grow_wait_us;           // 扩容阈值：任务排队等待时间（微秒）
+    int max_task;               // 每个优先级通道的最大长度（0表示不做额外限制）
+    int lane_weights[THREAD_POOL_LANES]; // 各通道调度权重（≤0按1处理）
+    int deadline_policy;        // 超时任务处理方式（deadline_policy_t）
+    int affinity;               // 工作线程绑核策略（affinity_policy_t）
+    const int* cpu_list;        // AFFINITY_CPU_LIST：第i个线程槽位绑定到 cpu_list[i % cpu_list_len]
+    int cpu_list_len;
+    int numa_node;              // AFFINITY_NUMA_NODE：绑定的节点；≥0时线程池内部结构也在该节点上分配（-1表示不指定）
+    int overflow_policy;        // 通道已满时的处理方式（overflow_policy_t）
+    int overflow_timeout_ms;    // OVERFLOW_BLOCK：最长等待时间（毫秒，0表示一直等待）
+    thread_pool_overflow_fn on_overflow; // OVERFLOW_CALLBACK：回调
+    void* overflow_user;        // 传给 on_overflow 的用户数据
+    int idle_spin_us;           // 空闲自旋上限（微秒，0表示不自旋也不让出，队列一空直接休眠；只有一个CPU时只让出不自旋）
+} thread_pool_config_t;
+
+// ====================== 延时/周期任务 ======================
+/**
+ * @brief 定时任务句柄：低32位为定时器表下标+1，高32位为代数（定时器结束后代数递增，旧句柄随即失效）
+ * @note 0 表示无效句柄
+ */
+typedef uint64_t thread_pool_timer_t;
+
+/**
+ * @brief 定时器状态
+ */
+typedef enum {
+    TIMER_FREE = 0,             // 空闲（在空闲链表中）
+    TIMER_PENDING = 1,          // 在堆中等待到期
+    TIMER_QUEUED = 2,           // 已到期，作为普通任务进入了线程池队列
+    TIMER_RUNNING = 3,          // 任务正在执行
+} timer_state_t;
+
+/**
+ * @brief 定时器（单独分配，地址在线程池生命周期内不变，释放后进入空闲链表复用）
+ */
+typedef struct timer_entry {
+    void (*func)(void*);        // 任务函数指针
+    void* arg;                  // 任务函数参数
+    uint64_t due_ns;            // 到期时间（单调时钟，纳秒）
+    uint64_t period_ns;         // 周期（纳秒，0表示一次性）
+    struct thread_pool* pool;   // 所属线程池
+    struct timer_entry* next_free; // 空闲链表
+    uint32_t index;             // 在定时器表中的下标
+    uint32_t gen;               // 代数（与句柄比对）
+    int state;                  // timer_state_t
+    int cancelled;              // 已取消（堆中的条目不立即移除，到期或整理堆时释放）
+} timer_entry_t;
+
+/**
+ * @brief 最小堆节点（到期时间冗余存放在节点中，比较时不访问定时器本身）
+ */
+typedef struct timer_heap_node {
+    uint64_t due_ns;
+    timer_entry_t* entry;
+} timer_heap_node_t;
+
+/**
+ * @brief 线程池的定时器集合：一个定时线程 + 按到期时间排序的最小堆
+ * @note 定时线程在首次调度时创建；到期的定时器成批提交到线程池的 NORMAL 通道，由工作线程执行。
+ *       取消只设置标记（O(1)），已取消的条目在到期时释放，或在已取消条目过多时整理堆一并释放
+ */
+typedef struct thread_pool_timers {
+    pthread_mutex_t mutex;      // 保护以下所有字段
+    pthread_cond_t cond;        // 最早到期时间提前或停止时通知定时线程（CLOCK_MONOTONIC）
+    pthread_t thread;           // 定时线程
+    int started;                // 定时线程是否已创建
+    int stop;                   // 停止标记
+    timer_heap_node_t* heap;    // 最小堆（容量不小于已分配的定时器数，入堆不会失败）
+    int heap_len;
+    int heap_cap;
+    int heap_cancelled;         // 堆中已取消、尚未释放的条目数
+    timer_entry_t** table;      // 定时器表（句柄下标 -> 定时器）
+    uint32_t table_len;
+    uint32_t table_cap;
+    timer_entry_t* free_list;   // 空闲定时器
+} thread_pool_timers_t;
+
 // ====================== 线程池核心结构体 ======================
 /**
  * @brief 线程池结构体
- * @note 所有成员变量需通过互斥锁保护，避免多线程竞争
+ * @note 任务队列为无锁环形队列；空闲线程先自旋再在 park_seq 上futex休眠；互斥锁保护线程数组（弹性伸缩）
  */
 typedef struct thread_pool {
-    pthread_t* threads;         // 线程数组
-    int thread_num;             // 线程数量
-    task_t* task_queue;         // 任务队列（链表头节点）
-    int task_count;             // 当前任务数
-    int max_task;               // 最大任务数（0表示无限制）
-    pthread_mutex_t mutex;      // 保护任务队列的互斥锁
-    pthread_cond_t cond;        // 任务通知条件变量
-    int is_running;             // 线程池运行标记（1：运行，0：停止）
+    task_ring_t lanes[THREAD_POOL_LANES]; // 各优先级通道的任务队列（无锁MPMC环形队列）
+    lane_counters_t lane_counters[THREAD_POOL_LANES]; // 各通道统计
+    int lane_weights[THREAD_POOL_LANES]; // 各通道调度权重
+    int deadline_policy;        // 超时任务处理方式
+    int affinity;               // 绑核策略
+    int* cpu_order;             // 按线程槽位轮转绑定的CPU（COMPACT/SCATTER/CPU_LIST）
+    int cpu_order_len;
+    cpu_set_t node_cpus;        // AFFINITY_NUMA_NODE：节点的CPU集合
+    int numa_node;              // 所在NUMA节点（-1表示不指定）
+    pthread_t* threads;         // 线程数组（容量为max_threads）
+    thread_pool_worker_t* workers; // 工作线程上下文（容量为max_threads，与threads一一对应）
+    char* thread_used;          // 线程数组槽位是否在用（弹性模式下线程会被回收）
+    int thread_num;             // 当前线程数量（原子读，加锁写）
+    int min_threads;            // 最小线程数
+    int max_threads;            // 最大线程数
+    int elastic;                // 是否启用弹性伸缩
+    int idle_timeout_ms;        // 空闲线程回收超时（毫秒）
+    uint64_t grow_wait_ns;      // 扩容阈值（纳秒）
+    uint64_t last_grow_ns;      // 上次扩容时间（原子访问，用于限制扩容频率）
+    uint64_t last_dequeue_ns;   // 最近一次取任务的时间（原子访问，用于发现线程全部阻塞）
+    int max_task;               // 每个通道的最大任务数（0表示不做额外限制）
+    int overflow_policy;        // 通道已满时的处理方式
+    int overflow_timeout_ms;    // OVERFLOW_BLOCK 最长等待时间（毫秒）
+    thread_pool_overflow_fn on_overflow; // OVERFLOW_CALLBACK 回调
+    void* overflow_user;
+    int space_waiters;          // 正在等待空位的提交线程数（原子访问）
+    pthread_mutex_t space_mutex; // 保护提交线程等待空位
+    pthread_cond_t space_cond;  // 空位通知条件变量（CLOCK_MONOTONIC）
+    pthread_mutex_t mutex;      // 保护线程数组的互斥锁
+    uint64_t spin_max_ns;       // 空闲自旋上限（纳秒，0表示不自旋）
+    int yield_rounds;           // 自旋后让出CPU复查的次数（0表示直接休眠）
+    int spinning;               // 正在自旋/让出等待任务的线程数（原子访问）
+    uint32_t park_seq;          // 休眠用的futex字，每次唤醒递增（原子访问）
+    int idle_num;               // 正在休眠的线程数（原子访问）
+    int is_running;             // 线程池运行标记（1：运行，0：停止，原子访问）
+    int force_stop;             // 强制退出标记（1：丢弃未执行任务）
+    thread_pool_timers_t timers; // 延时/周期任务
 } thread_pool_t;
 
+// ====================== 串行执行器（strand） ======================
+/**
+ * @brief 串行执行器：投递到同一个strand的任务按投递顺序执行，且任何时刻最多一个在执行
+ * @note 任务先进入strand自己的无锁MPSC队列，strand有任务时才以一个普通任务的形式（thread_pool_strand_run）
+ *       进入线程池，由某个工作线程连续执行一批。任务之间天然串行，任务内访问strand保护的数据不需要加锁
+ * @note state：最低位为调度令牌（1表示已经或即将有 thread_pool_strand_run 在线程池中），其余位为未执行的任务数。
+ *       投递方在令牌空闲时取得令牌，由它负责把 thread_pool_strand_run 提交到线程池；
+ *       strand执行完所有任务时把state从"无任务+持有令牌"原子地置为0，此后不再访问strand
+ */
+typedef struct thread_pool_strand {
+    thread_pool_t* pool;        // 执行strand的线程池
+    task_t* head;               // MPSC队列生产者端（原子交换）
+    char pad0[CACHE_LINE_SIZE - sizeof(void*)];
+    task_t* tail;               // MPSC队列消费者端（只由持有令牌的线程访问）
+    task_t stub;                // 哨兵节点
+    size_t state;               // 调度令牌 + 任务数*2（原子访问）
+} thread_pool_strand_t;
+
+// ====================== 命名子线程池（隔舱） ======================
+/**
+ * @brief 线程池组：按名称区分的一组相互隔离的子线程池（如 "cpu"、"io-blocking"）
+ * @note 每个子线程池有独立的队列、线程数和统计，阻塞型任务占满自己的子线程池时，
+ *       其他子线程池的排队时间不受影响（隔舱）。调用方在启动时用名称查到编号，之后按编号提交
+ */
+typedef struct thread_pool_group {
+    int count;                  // 子线程池数
+    char names[THREAD_POOL_GROUP_MAX][THREAD_POOL_NAME_LEN]; // 子线程池名称
+    thread_pool_t* pools[THREAD_POOL_GROUP_MAX]; // 子线程池
+    int owned[THREAD_POOL_GROUP_MAX]; // 是否由组创建（销毁组时一并销毁）
+} thread_pool_group_t;
+
+/**
+ * @brief 子线程池统计（各优先级通道合计；排队/执行时间分位数来自遥测，自创建起累计）
+ */
+typedef struct thread_pool_group_stats {
+    const char* name;           // 子线程池名称
+    int threads;                // 当前线程数
+    size_t depth;               // 当前排队任务数（近似值）
+    uint64_t submitted;         // 累计入队数
+    uint64_t executed;          // 累计执行数
+    uint64_t rejected;          // 累计因队列满被拒绝数
+    uint64_t wait_p99_ns;       // 排队时间p99（纳秒，编译时关闭遥测为0）
+    uint64_t run_p99_ns;        // 执行时间p99（纳秒，编译时关闭遥测为0）
+} thread_pool_group_stats_t;
+
 // ====================== 全局静态函数声明（内部使用） ======================
 static void* worker_loop(void* arg);  // 工作线程函数
 static task_t* task_create(void (*func)(void*), void* arg); // 创建任务
 static void task_destroy(task_t* task); // 销毁任务
+static int task_ring_init(task_ring_t* ring, size_t capacity); // 初始化环形队列
+static void task_ring_destroy(task_ring_t* ring); // 销毁环形队列
+static int task_ring_push(task_ring_t* ring, task_t* task); // 入队
+static int task_ring_push_batch(task_ring_t* ring, task_t** tasks, int n); // 批量入队
+static task_t* task_ring_pop(task_ring_t* ring); // 出队
+static size_t task_ring_size(task_ring_t* ring); // 当前元素数（近似值）
+static void task_cache_refill(task_cache_t* cache); // 从全局空闲链表补充本地缓存
+static void task_cache_flush(task_cache_t* cache, int keep); // 本地缓存归还全局空闲链表
+static void thread_pool_wake(thread_pool_t* pool, int n); // 唤醒休眠线程
+static int thread_pool_idle_spin(thread_pool_t* pool, thread_pool_worker_t* worker, uint64_t idle_start); // 休眠前自旋/让出等待任务
+static int thread_pool_futex_wait(uint32_t* addr, uint32_t val, const struct timespec* deadline); // futex等待
+static void thread_pool_futex_wake(uint32_t* addr, int n); // futex唤醒
+static inline void thread_pool_cpu_relax(void); // 自旋等待提示（pause）
+static uint64_t thread_pool_now_ns(void); // 单调时钟（纳秒）
+static int thread_pool_spawn_locked(thread_pool_t* pool); // 新建工作线程（需持有mutex）
+static void thread_pool_try_grow(thread_pool_t* pool); // 弹性扩容
+static void thread_pool_check_stall(thread_pool_t* pool, uint64_t now); // 提交方检查线程是否全部阻塞
+static size_t thread_pool_pending(thread_pool_t* pool); // 所有通道排队任务数
+static task_t* thread_pool_next_task(thread_pool_t* pool, int* credits); // 按加权轮转取任务
+static void thread_pool_release(thread_pool_t* pool); // 释放队列、线程数组和线程池本身
+static int thread_pool_setup_affinity(thread_pool_t* pool, const thread_pool_config_t* conf); // 计算绑核方案
+static inline void telemetry_end_run(thread_pool_worker_t* worker, uint64_t now); // 结束当前任务的计时
+static int thread_pool_try_push(thread_pool_t* pool, task_ring_t* ring, task_t* task); // 按max_task限制入队
+static int thread_pool_overflow(thread_pool_t* pool, task_t* task); // 通道已满时按背压策略处理任务
+static int thread_pool_wait_space(thread_pool_t* pool, task_ring_t* ring, task_t* task); // 阻塞等待空位后入队
+static inline void thread_pool_notify_space(thread_pool_t* pool); // 取走任务后通知等待空位的提交线程
+static void strand_queue_push(thread_pool_strand_t* strand, task_t* node); // strand队列入队（多生产者）
+static task_t* strand_queue_pop(thread_pool_strand_t* strand); // strand队列出队（只由持有令牌的线程调用）
+static int thread_pool_timers_init(thread_pool_t* pool); // 初始化定时器锁和条件变量
+static void thread_pool_timers_stop(thread_pool_t* pool); // 停止并回收定时线程
+static thread_pool_timer_t thread_pool_schedule(thread_pool_t* pool, uint64_t delay_ns, uint64_t period_ns,
+                                                void (*func)(void*), void* arg); // 添加定时器
+static void* timer_loop(void* arg); // 定时线程函数
+static void timer_run(void* arg); // 到期定时器在工作线程上的执行函数
+static timer_entry_t* timer_alloc_locked(thread_pool_timers_t* timers); // 分配定时器（需持有timers.mutex）
+static void timer_free_locked(thread_pool_timers_t* timers, timer_entry_t* entry); // 释放定时器（需持有timers.mutex）
+static void timer_heap_push_locked(thread_pool_timers_t* timers, timer_entry_t* entry); // 入堆（需持有timers.mutex）
+static timer_entry_t* timer_heap_pop_locked(thread_pool_timers_t* timers); // 取出堆顶（需持有timers.mutex）
+static void timer_heap_sift_down(thread_pool_timers_t* timers, int i); // 下沉
+static void timer_heap_compact_locked(thread_pool_timers_t* timers); // 移除已取消的条目并重建堆
+static int thread_pool_group_register(thread_pool_group_t* group, const char* name, thread_pool_t* pool, int owned); // 登记子线程池
 
 // ====================== 线程池核心接口 ======================
 /**
@@ -52,15 +475,42 @@ static void task_destroy(task_t* task); // 销毁任务
  */
 thread_pool_t* thread_pool_create(int thread_num);
 
+/**
+ * @brief 初始化线程池配置为默认值（固定DEFAULT_THREAD_NUM个线程）
+ * @param cfg 配置
+ */
+void thread_pool_config_init(thread_pool_config_t* cfg);
+
+/**
+ * @brief 按配置创建线程池
+ * @param cfg 配置（min_threads≤0则使用默认值，max_threads小于min_threads时按min_threads处理）
+ * @return 成功返回线程池指针，失败返回NULL
+ */
+thread_pool_t* thread_pool_create_ex(const thread_pool_config_t* cfg);
+
 /**
  * @brief 向线程池提交任务
  * @param pool 线程池指针
  * @param func 任务函数指针
  * @param arg 任务函数参数
- * @return 成功返回0，失败返回-1
+ * @return THREAD_POOL_OK：已入队；THREAD_POOL_RAN_INLINE：已在当前线程执行；
+ *         负值：任务未被接收（THREAD_POOL_ERROR/REJECTED/TIMEOUT）
+ * @note 通道已满时按配置的背压策略处理（overflow_policy_t）
  */
 int thread_pool_add_task(thread_pool_t* pool, void (*func)(void*), void* arg);
 
+/**
+ * @brief 批量提交任务：一次占用队列位置，一次唤醒（进入 NORMAL 通道）
+ * @param pool 线程池指针
+ * @param funcs 任务函数指针数组
+ * @param args 任务函数参数数组
+ * @param n 任务数
+ * @return 被接收的任务数（入队或在当前线程执行），参数错误返回-1
+ * @note 放不下的任务按背压策略逐个处理，遇到第一个未被接收的任务即停止，
+ *       即返回值k表示前k个任务已被接收、从第k个起未被接收
+ */
+int thread_pool_add_tasks(thread_pool_t* pool, void (*const funcs[])(void*), void* const args[], int n);
+
 /**
  * @brief 销毁线程池
  * @param pool 线程池指针
@@ -68,237 +518,2304 @@ int thread_pool_add_task(thread_pool_t* pool, void (*func)(void*), void* arg);
  */
 void thread_pool_destroy(thread_pool_t* pool, int force);
 
-// ====================== 内部实现函数 ======================
 /**
- * @brief 工作线程函数（循环获取并执行任务）
- * @param arg 线程池指针
- * @return NULL
+ * @brief 按选项提交任务（优先级通道 + 截止时间）
+ * @param pool 线程池指针
+ * @param func 任务函数指针
+ * @param arg 任务函数参数
+ * @param opts 提交选项（NULL等同于 NORMAL 通道、无截止时间）
+ * @return 同 thread_pool_add_task
  */
-static void* worker_loop(void* arg) {
-    thread_pool_t* pool = (thread_pool_t*)arg;
-    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL); // 允许线程被取消
+int thread_pool_add_task_ex(thread_pool_t* pool, void (*func)(void*), void* arg, const task_options_t* opts);
 
-    while (1) {
-        // 1. 加锁获取任务
-        pthread_mutex_lock(&pool->mutex);
+/**
+ * @brief 当前正在执行的任务是否已超过截止时间（仅 DEADLINE_FLAG 策略下有意义）
+ * @return 已超时返回1，否则返回0
+ */
+int thread_pool_task_expired(void);
 
-        // 2. 等待任务（队列为空且线程池运行中）
-        while (pool->task_count == 0 && pool->is_running) {
-            pthread_cond_wait(&pool->cond, &pool->mutex);
-        }
+/**
+ * @brief 获取优先级通道统计
+ * @param pool 线程池指针
+ * @param lane 通道（task_priority_t）
+ * @param stats 输出统计
+ * @return 成功返回0，参数错误返回-1
+ */
+int thread_pool_get_lane_stats(thread_pool_t* pool, int lane, thread_pool_lane_stats_t* stats);
 
-        // 3. 检查线程池是否停止
-        if (!pool->is_running) {
-            pthread_mutex_unlock(&pool->mutex);
-            pthread_exit(NULL); // 退出线程
-        }
+// ====================== 串行执行器接口 ======================
+/**
+ * @brief 初始化strand
+ * @param strand strand（可内嵌在调用方的结构体中）
+ * @param pool 执行strand的线程池
+ * @return 成功返回0，参数错误返回-1
+ */
+int thread_pool_strand_init(thread_pool_strand_t* strand, thread_pool_t* pool);
 
-        // 4. 从队列头部取出任务
-        task_t* task = pool->task_queue;
-        pool->task_queue = task->next;
-        pool->task_count--;
+/**
+ * @brief 销毁strand，未执行的任务被丢弃（有on_expired回调的任务不会调用回调）
+ * @param strand strand（必须空闲，见 thread_pool_strand_idle）
+ */
+void thread_pool_strand_destroy(thread_pool_strand_t* strand);
 
-        pthread_mutex_unlock(&pool->mutex);
+/**
+ * @brief 向strand投递任务并在需要时调度strand
+ * @param strand strand
+ * @param func 任务函数指针
+ * @param arg 任务函数参数
+ * @return THREAD_POOL_OK：已投递；THREAD_POOL_ERROR：参数错误或内存不足；
+ *         THREAD_POOL_REJECTED：任务已进入strand，但线程池拒绝了strand的调度，
+ *         调用方持有调度令牌，须稍后再把 thread_pool_strand_run(strand) 提交到线程池（否则strand不再执行）
+ * @note thread_pool_strand_run 的提交遵循线程池的背压策略（CALLER_RUNS时在当前线程执行）
+ */
+int thread_pool_strand_post(thread_pool_strand_t* strand, void (*func)(void*), void* arg);
 
-        // 5. 执行任务（解锁后执行，避免长时间占用锁）
-        if (task && task->func) {
-            task->func(task->arg);
-        }
+/**
+ * @brief 只把任务放入strand，不提交到线程池（用于批量调度）
+ * @param strand strand
+ * @param func 任务函数指针
+ * @param arg 任务函数参数
+ * @return 1：调用方取得调度令牌，须把 thread_pool_strand_run(strand) 提交到线程池（可与其他任务一起批量提交）；
+ *         0：strand已被调度，任务会按顺序执行；THREAD_POOL_ERROR：参数错误或内存不足
+ */
+int thread_pool_strand_enqueue(thread_pool_strand_t* strand, void (*func)(void*), void* arg);
 
-        // 6. 销毁已执行的任务
-        task_destroy(task);
-    }
+/**
+ * @brief strand的执行函数（以strand为参数提交到线程池）
+ * @param arg strand
+ * @note 每次最多执行 STRAND_BATCH 个任务；还有任务时重新提交自己（线程池已满则在当前线程继续执行）
+ */
+void thread_pool_strand_run(void* arg);
 
-    return NULL;
-}
+/**
+ * @brief strand是否空闲（没有未执行的任务，也没有被调度）
+ * @return 空闲返回1；返回1之后strand不会再被线程池访问，调用方确认不再投递时即可销毁
+ */
+int thread_pool_strand_idle(thread_pool_strand_t* strand);
 
+// ====================== NUMA 子线程池 ======================
 /**
- * @brief 创建单个任务
- * @param func 任务函数
- * @param arg 任务参数
- * @return 任务指针，失败返回NULL
+ * @brief 每个NUMA节点一个子线程池，节点内的线程绑定在该节点的CPU上，任务队列也分配在该节点上
+ * @note 调用方按连接等粒度固定选择子线程池，使同一份数据始终在同一节点上处理；
+ *       数据本身应由子线程池中的线程首次写入（Linux按首次触碰分配物理页），才会落在本节点内存上
  */
-static task_t* task_create(void (*func)(void*), void* arg) {
-    task_t* task = (task_t*)malloc(sizeof(task_t));
-    if (!task) {
-        perror("malloc task failed");
-        return NULL;
-    }
-    task->func = func;
-    task->arg = arg;
-    task->next = NULL;
-    return task;
-}
+typedef struct numa_thread_pool {
+    int num_nodes;              // 子线程池数（包含可用CPU的节点数）
+    int nodes[CPU_TOPOLOGY_MAX_NODES]; // 各子线程池对应的节点编号
+    thread_pool_t* pools[CPU_TOPOLOGY_MAX_NODES]; // 子线程池
+    unsigned next;              // 轮转分配计数（原子访问）
+} numa_thread_pool_t;
 
 /**
- * @brief 销毁单个任务
- * @param task 任务指针
+ * @brief 创建按NUMA节点划分的线程池组
+ * @param cfg 每个子线程池的配置（affinity/numa_node被忽略）；
+ *            min_threads≤0表示取节点CPU数，max_threads≤0表示取min_threads的2倍
+ * @return 成功返回线程池组指针，失败返回NULL
  */
-static void task_destroy(task_t* task) {
-    if (task) {
-        free(task);
-    }
-}
+numa_thread_pool_t* numa_thread_pool_create(const thread_pool_config_t* cfg);
 
 /**
- * @brief 创建线程池（实现）
+ * @brief 选择子线程池编号
+ * @param npool 线程池组
+ * @param hint <0：调用线程当前所在节点（不在组内时轮转）；≥0：hint对子线程池数取模
+ * @return 子线程池编号（npool->pools的下标）
  */
-thread_pool_t* thread_pool_create(int thread_num) {
-    // 1. 参数校验
-    if (thread_num <= 0) {
-        thread_num = DEFAULT_THREAD_NUM;
-    }
+int numa_thread_pool_pick(numa_thread_pool_t* npool, int hint);
 
-    // 2. 初始化线程池结构体
-    thread_pool_t* pool = (thread_pool_t*)malloc(sizeof(thread_pool_t));
-    if (!pool) {
-        perror("malloc thread_pool failed");
-        return NULL;
-    }
-    memset(pool, 0, sizeof(thread_pool_t));
+/**
+ * @brief 销毁线程池组
+ * @param npool 线程池组
+ * @param force 同 thread_pool_destroy
+ */
+void numa_thread_pool_destroy(numa_thread_pool_t* npool, int force);
 
-    // 3. 设置线程池参数
-    pool->thread_num = thread_num;
-    pool->max_task = MAX_TASK_QUEUE;
-    pool->is_running = 1; // 标记为运行状态
+/**
+ * @brief 获取任务节点分配统计（所有线程池共享同一个分配器）
+ * @param stats 输出统计
+ */
+void thread_pool_task_alloc_stats(task_alloc_stats_t* stats);
 
-    // 4. 创建线程数组
-    pool->threads = (pthread_t*)malloc(sizeof(pthread_t) * thread_num);
-    if (!pool->threads) {
-        perror("malloc threads failed");
-        free(pool);
-        return NULL;
-    }
+/**
+ * @brief 获取线程池遥测快照（合并所有线程槽位，包括已回收线程的累计值）
+ * @param pool 线程池指针
+ * @param out 输出快照
+ * @return 成功返回0；参数错误或编译时关闭了遥测返回-1（out清零）
+ */
+int thread_pool_get_telemetry(thread_pool_t* pool, thread_pool_telemetry_t* out);
 
-    // 5. 初始化互斥锁和条件变量
-    if (pthread_mutex_init(&pool->mutex, NULL) != 0) {
-        perror("pthread_mutex_init failed");
-        free(pool->threads);
-        free(pool);
-        return NULL;
-    }
-    if (pthread_cond_init(&pool->cond, NULL) != 0) {
-        perror("pthread_cond_init failed");
-        pthread_mutex_destroy(&pool->mutex);
-        free(pool->threads);
-        free(pool);
-        return NULL;
-    }
+/**
+ * @brief 由直方图估算分位数
+ * @param hist 直方图（thread_pool_telemetry_t 中的 wait_hist 或 run_hist）
+ * @param p 分位（0~1，如0.99）
+ * @return 分位数所在桶的上界（纳秒），直方图为空返回0
+ */
+uint64_t thread_pool_hist_percentile(const uint64_t hist[THREAD_POOL_HIST_BUCKETS], double p);
 
-    // 6. 创建工作线程
-    for (int i = 0; i < thread_num; i++) {
-        if (pthread_create(&pool->threads[i], NULL, worker_loop, pool) != 0) {
-            perror("pthread_create failed");
-            // 销毁已创建的线程
-            for (int j = 0; j < i; j++) {
-                pthread_cancel(pool->threads[j]);
-                pthread_join(pool->threads[j], NULL);
-            }
-            pthread_mutex_destroy(&pool->mutex);
-            pthread_cond_destroy(&pool->cond);
-            free(pool->threads);
-            free(pool);
-            return NULL;
-        }
-    }
+// ====================== 命名子线程池接口 ======================
+/**
+ * @brief 创建空的线程池组
+ * @return 成功返回线程池组指针，失败返回NULL
+ */
+thread_pool_group_t* thread_pool_group_create(void);
 
-    printf("thread pool created: %d threads, max task: %d\n", thread_num, pool->max_task);
-    return pool;
-}
+/**
+ * @brief 按配置新建一个命名子线程池
+ * @param group 线程池组
+ * @param name 名称（组内唯一）
+ * @param cfg 子线程池配置（NULL表示默认配置）
+ * @return 子线程池编号；名称重复、组已满或创建失败返回-1
+ */
+int thread_pool_group_add(thread_pool_group_t* group, const char* name, const thread_pool_config_t* cfg);
 
 /**
- * @brief 提交任务到线程池（实现）
+ * @brief 把已有线程池登记为命名子线程池（只参与路由和统计，销毁组时不销毁它）
+ * @return 子线程池编号；名称重复、组已满或参数错误返回-1
  */
-int thread_pool_add_task(thread_pool_t* pool, void (*func)(void*), void* arg) {
-    // 1. 参数校验
-    if (!pool || !func || pool->is_running == 0) {
-        fprintf(stderr, "invalid param or pool stopped\n");
-        return -1;
-    }
+int thread_pool_group_attach(thread_pool_group_t* group, const char* name, thread_pool_t* pool);
 
-    // 2. 加锁保护任务队列
-    pthread_mutex_lock(&pool->mutex);
+/**
+ * @brief 按名称查找子线程池编号
+ * @return 子线程池编号，找不到返回-1
+ */
+int thread_pool_group_find(thread_pool_group_t* group, const char* name);
 
-    // 3. 检查任务队列是否已满（如果设置了最大任务数）
-    if (pool->max_task > 0 && pool->task_count >= pool->max_task) {
-        fprintf(stderr, "task queue full, reject task\n");
-        pthread_mutex_unlock(&pool->mutex);
-        return -1;
-    }
+/**
+ * @brief 向指定编号的子线程池提交任务
+ * @param group 线程池组
+ * @param index 子线程池编号（thread_pool_group_add/attach/find 的返回值）
+ * @param func 任务函数指针
+ * @param arg 任务函数参数
+ * @return 同 thread_pool_add_task；编号无效返回 THREAD_POOL_ERROR
+ */
+int thread_pool_group_submit(thread_pool_group_t* group, int index, void (*func)(void*), void* arg);
 
-    // 4. 创建新任务
-    task_t* new_task = task_create(func, arg);
-    if (!new_task) {
-        pthread_mutex_unlock(&pool->mutex);
-        return -1;
-    }
+/**
+ * @brief 获取子线程池统计
+ * @return 成功返回0，参数错误返回-1
+ */
+int thread_pool_group_get_stats(thread_pool_group_t* group, int index, thread_pool_group_stats_t* stats);
 
-    // 5. 将任务添加到队列尾部
-    if (!pool->task_queue) {
-        pool->task_queue = new_task; // 队列为空，直接作为头节点
-    } else {
-        task_t* tmp = pool->task_queue;
-        while (tmp->next) {
-            tmp = tmp->next;
-        }
-        tmp->next = new_task;
-    }
-    pool->task_count++;
+/**
+ * @brief 输出所有子线程池的统计（每个子线程池一行）
+ * @param group 线程池组
+ * @param out 输出流
+ */
+void thread_pool_group_report(thread_pool_group_t* group, FILE* out);
 
-    // 6. 唤醒等待的工作线程
-    pthread_cond_signal(&pool->cond);
-    pthread_mutex_unlock(&pool->mutex);
+/**
+ * @brief 销毁线程池组：按登记的逆序销毁组创建的子线程池（登记的已有线程池由调用方销毁）
+ * @param group 线程池组
+ * @param force 同 thread_pool_destroy
+ */
+void thread_pool_group_destroy(thread_pool_group_t* group, int force);
 
-    return 0;
-}
+// ====================== 延时/周期任务接口 ======================
+/**
+ * @brief 延时执行任务
+ * @param pool 线程池指针
+ * @param delay_ms 延时（毫秒，0表示尽快执行）
+ * @param func 任务函数指针
+ * @param arg 任务函数参数
+ * @return 定时任务句柄；参数错误、线程池已停止或内存不足返回0
+ * @note 到期后任务进入 NORMAL 通道，与普通任务一起排队；任务不会阻塞任何线程等待到期
+ */
+thread_pool_timer_t thread_pool_schedule_after(thread_pool_t* pool, int delay_ms, void (*func)(void*), void* arg);
 
 /**
- * @brief 销毁线程池（实现）
+ * @brief 周期执行任务（首次在一个周期后执行）
+ * @param pool 线程池指针
+ * @param period_ms 周期（毫秒，>0）
+ * @param func 任务函数指针
+ * @param arg 任务函数参数
+ * @return 定时任务句柄；参数错误、线程池已停止或内存不足返回0
+ * @note 按固定频率触发；上一次执行结束前不会再次触发，执行超过一个周期时错过的触发不补跑
  */
-void thread_pool_destroy(thread_pool_t* pool, int force) {
-    if (!pool) return;
+thread_pool_timer_t thread_pool_schedule_every(thread_pool_t* pool, int period_ms, void (*func)(void*), void* arg);
 
-    // 1. 加锁标记线程池停止
-    pthread_mutex_lock(&pool->mutex);
-    pool->is_running = 0;
-    pthread_mutex_unlock(&pool->mutex);
+/**
+ * @brief 取消定时任务（O(1)：只设置标记，不在堆中查找）
+ * @param pool 线程池指针
+ * @param timer 定时任务句柄
+ * @return 0：已取消，任务不会再执行；
+ *         1：已取消，但周期任务的本次执行正在进行（结束后不再触发，调用方释放arg前需等它结束）；
+ *         -1：句柄无效、已取消或一次性任务已经开始执行
+ */
+int thread_pool_timer_cancel(thread_pool_t* pool, thread_pool_timer_t timer);
 
-    // 2. 唤醒所有等待的线程
-    pthread_cond_broadcast(&pool->cond);
+// ====================== 分配器全局状态 ======================
+static struct {
+    pthread_mutex_t mutex;      // 保护全局空闲链表和slab链表
+    task_t* free_list;          // 全局空闲链表
+    int free_count;             // 全局空闲节点数
+    task_slab_t* slabs;         // 所有已分配的slab
+    pthread_once_t key_once;    // 线程退出回调注册
+    pthread_key_t key;
+    uint64_t cache_hits;        // 以下统计原子访问
+    uint64_t cache_misses;
+    uint64_t slab_allocs;
+} g_task_allocator = { PTHREAD_MUTEX_INITIALIZER, NULL, 0, NULL, PTHREAD_ONCE_INIT, 0, 0, 0, 0 };
 
-    // 3. 等待所有线程退出
-    for (int i = 0; i < pool->thread_num; i++) {
-        if (pthread_join(pool->threads[i], NULL) != 0) {
-            perror("pthread_join failed");
-        }
+static __thread task_cache_t t_task_cache;
+static __thread int t_task_expired; // 当前执行的任务是否已超时
+
+// ====================== 环形队列实现 ======================
+/**
+ * @brief 初始化环形队列
+ * @param ring 队列指针
+ * @param capacity 期望容量（向上取整为2的幂）
+ * @return 成功返回0，失败返回-1
+ */
+static int task_ring_init(task_ring_t* ring, size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
     }
 
-    // 4. 清理任务队列（强制退出时销毁未执行任务）
-    if (force) {
-        task_t* tmp = pool->task_queue;
-        while (tmp) {
-            task_t* next = tmp->next;
-            task_destroy(tmp);
-            tmp = next;
-        }
-        pool->task_queue = NULL;
-        pool->task_count = 0;
-    } else {
-        // 非强制退出：等待所有任务执行完（已由工作线程处理）
-        pthread_mutex_lock(&pool->mutex);
-        while (pool->task_count > 0) {
-            pthread_cond_wait(&pool->cond, &pool->mutex);
-        }
-        pthread_mutex_unlock(&pool->mutex);
+    ring->cells = (task_ring_cell_t*)malloc(sizeof(task_ring_cell_t) * size);
+    if (!ring->cells) {
+        perror("malloc task ring failed");
+        return -1;
     }
+    for (size_t i = 0; i < size; i++) {
+        ring->cells[i].seq = i;
+        ring->cells[i].task = NULL;
+    }
+    ring->mask = size - 1;
+    ring->enqueue_pos = 0;
+    ring->dequeue_pos = 0;
+    return 0;
+}
 
-    // 5. 释放资源
-    pthread_mutex_destroy(&pool->mutex);
-    pthread_cond_destroy(&pool->cond);
-    free(pool->threads);
-    free(pool);
+/**
+ * @brief 销毁环形队列（不销毁队列中的任务）
+ * @param ring 队列指针
+ */
+static void task_ring_destroy(task_ring_t* ring) {
+    free(ring->cells);
+    ring->cells = NULL;
+}
 
-    printf("thread pool destroyed (force: %d)\n", force);
+/**
+ * @brief 入队（多生产者安全）
+ * @param ring 队列指针
+ * @param task 任务指针
+ * @return 成功返回0，队列已满返回-1
+ */
+static int task_ring_push(task_ring_t* ring, task_t* task) {
+    task_ring_cell_t* cell;
+    size_t pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+
+    while (1) {
+        cell = &ring->cells[pos & ring->mask];
+        size_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            // 槽位空闲，尝试占有该位置（失败时pos被更新为最新值）
+            if (__atomic_compare_exchange_n(&ring->enqueue_pos, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return -1; // 槽位仍被上一轮数据占用：队列已满
+        } else {
+            pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->task = task;
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE); // 发布数据
+    return 0;
+}
+
+/**
+ * @brief 批量入队（多生产者安全）
+ * @param ring 队列指针
+ * @param tasks 任务指针数组
+ * @param n 任务数
+ * @return 实际入队数（按剩余空间截断，可能为0）
+ * @note 用一次CAS占用连续的n个位置，再逐个写入。
+ *       位置对应的槽位可能还在被上一轮的消费者读取，此时短暂等待其释放
+ */
+static int task_ring_push_batch(task_ring_t* ring, task_t** tasks, int n) {
+    size_t capacity = ring->mask + 1;
+    size_t pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+    size_t count;
+
+    while (1) {
+        size_t deq = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_ACQUIRE);
+        size_t used = pos - deq;
+        if (used >= capacity) {
+            // 队列已满；或pos已过期（其他生产者已推进），重新读取后再判断
+            size_t latest = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+            if (latest == pos) return 0;
+            pos = latest;
+            continue;
+        }
+        count = capacity - used;
+        if (count > (size_t)n) count = (size_t)n;
+        if (__atomic_compare_exchange_n(&ring->enqueue_pos, &pos, pos + count, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        task_ring_cell_t* cell = &ring->cells[(pos + i) & ring->mask];
+        int spins = 0;
+        while (__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) != pos + i) {
+            if (++spins > 64) {
+                sched_yield();
+                spins = 0;
+            }
+        }
+        cell->task = tasks[i];
+        __atomic_store_n(&cell->seq, pos + i + 1, __ATOMIC_RELEASE);
+    }
+    return (int)count;
+}
+
+/**
+ * @brief 出队（多消费者安全）
+ * @param ring 队列指针
+ * @return 成功返回任务指针，队列为空返回NULL
+ */
+static task_t* task_ring_pop(task_ring_t* ring) {
+    task_ring_cell_t* cell;
+    size_t pos = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_RELAXED);
+
+    while (1) {
+        cell = &ring->cells[pos & ring->mask];
+        size_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ring->dequeue_pos, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return NULL; // 槽位尚未写入：队列为空
+        } else {
+            pos = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    task_t* task = cell->task;
+    // 释放槽位给下一轮的生产者
+    __atomic_store_n(&cell->seq, pos + ring->mask + 1, __ATOMIC_RELEASE);
+    return task;
+}
+
+/**
+ * @brief 获取队列当前元素数（并发下为近似值）
+ * @param ring 队列指针
+ * @return 元素数
+ */
+static size_t task_ring_size(task_ring_t* ring) {
+    size_t deq = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_SEQ_CST);
+    size_t enq = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_SEQ_CST);
+    return enq > deq ? enq - deq : 0;
+}
+
+// ====================== 遥测记录 ======================
+/**
+ * @brief 计数器累加（只有本线程写，用原子读+原子写代替带锁前缀的原子加）
+ */
+static inline void telemetry_add(uint64_t* counter, uint64_t v) {
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + v, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 纳秒数对应的直方图桶（log2）
+ */
+static inline int telemetry_bucket(uint64_t ns) {
+    int b = ns == 0 ? 0 : 64 - __builtin_clzll(ns);
+    return b < THREAD_POOL_HIST_BUCKETS ? b : THREAD_POOL_HIST_BUCKETS - 1;
+}
+
+/**
+ * @brief 结束当前任务的计时（记入执行时间和直方图）
+ * @param worker 工作线程上下文
+ * @param now 当前时间（纳秒）
+ * @note 任务的结束时间取下一次取到任务或准备休眠时的时间戳，
+ *       因此执行时间包含销毁任务节点和取下一个任务的开销（几十纳秒量级）
+ */
+static inline void telemetry_end_run(thread_pool_worker_t* worker, uint64_t now) {
+#if THREAD_POOL_TELEMETRY
+    if (worker->run_start_ns == 0) return;
+    uint64_t run = now - worker->run_start_ns;
+    telemetry_add(&worker->telemetry.busy_ns, run);
+    telemetry_add(&worker->telemetry.run_hist[telemetry_bucket(run)], 1);
+    worker->run_start_ns = 0;
+#else
+    (void)worker;
+    (void)now;
+#endif
+}
+
+// ====================== 内部实现函数 ======================
+/**
+ * @brief 工作线程函数（循环获取并执行任务）
+ * @param arg 工作线程上下文
+ * @return NULL
+ * @note 取任务无锁；队列为空时先自旋、再让出CPU，仍没有任务才在futex上休眠。
+ *       休眠前先登记 idle_num 再复查队列，与提交方"入队后检查 idle_num"配对，避免丢失唤醒
+ * @note 弹性模式下：取到的任务排队过久时尝试扩容；空闲超时且线程数多于min_threads时自行退出
+ */
+static void* worker_loop(void* arg) {
+    thread_pool_worker_t* worker = (thread_pool_worker_t*)arg;
+    thread_pool_t* pool = worker->pool;
+    int credits[THREAD_POOL_LANES] = {0}; // 本线程在当前轮转周期内各通道剩余的调度次数
+
+    while (1) {
+        // 1. 强制退出时不再处理剩余任务
+        if (!__atomic_load_n(&pool->is_running, __ATOMIC_ACQUIRE) && pool->force_stop) {
+            break;
+        }
+
+        // 2. 无锁取任务（按优先级加权轮转）
+        task_t* task = thread_pool_next_task(pool, credits);
+        if (task) {
+            thread_pool_notify_space(pool);
+            worker_lane_counters_t* counters = &worker->lanes[task->lane]; // 本线程独占，不写共享缓存行
+            uint64_t now = thread_pool_now_ns();
+            uint64_t wait = now - task->enqueue_ns;
+            telemetry_add(&counters->wait_ns_total, wait);
+            if (wait > counters->wait_ns_max) {
+                __atomic_store_n(&counters->wait_ns_max, wait, __ATOMIC_RELAXED);
+            }
+#if THREAD_POOL_TELEMETRY
+            // 复用取任务时的时间戳：上一个任务在此结束，本任务在此开始，稳态下不额外读时钟
+            telemetry_end_run(worker, now);
+            thread_pool_telemetry_t* tm = &worker->telemetry;
+            telemetry_add(&tm->tasks, 1);
+            telemetry_add(&tm->wait_ns, wait);
+            telemetry_add(&tm->wait_hist[telemetry_bucket(wait)], 1);
+            worker->run_start_ns = now;
+#endif
+
+            // 3. 弹性模式：排队时间超过阈值说明线程不够用
+            if (pool->elastic) {
+                __atomic_store_n(&pool->last_dequeue_ns, now, __ATOMIC_RELAXED);
+                if (wait > pool->grow_wait_ns) {
+                    thread_pool_try_grow(pool);
+                }
+            }
+
+            // 4. 截止时间检查：丢弃或标记后照常执行
+            int expired = task->deadline_ns != 0 && now > task->deadline_ns;
+            if (expired) {
+                telemetry_add(&counters->expired, 1);
+                if (pool->deadline_policy == DEADLINE_DROP) {
+                    if (task->on_expired) {
+                        task->on_expired(task->arg);
+                    }
+                    task_destroy(task);
+                    continue;
+                }
+            }
+
+            // 5. 执行任务
+            t_task_expired = expired;
+            if (task->func) {
+                task->func(task->arg);
+            }
+            t_task_expired = 0;
+            telemetry_add(&counters->executed, 1);
+            // 6. 销毁已执行的任务
+            task_destroy(task);
+            continue;
+        }
+
+        // 7. 队列为空：先自旋/让出CPU等待（自适应预算），仍没有任务才休眠
+        uint64_t idle_start = thread_pool_now_ns();
+#if THREAD_POOL_TELEMETRY
+        telemetry_end_run(worker, idle_start);
+        __atomic_store_n(&worker->idle_since_ns, idle_start, __ATOMIC_RELAXED);
+#endif
+        int timed_out = 0;
+        if (thread_pool_idle_spin(pool, worker, idle_start)) {
+#if THREAD_POOL_TELEMETRY
+            telemetry_add(&worker->telemetry.spin_hits, 1);
+#endif
+        } else {
+            // 8. 登记为休眠线程后复查队列，确实为空才在futex上休眠
+            //    先读 park_seq：复查之后提交方的唤醒会改变它，futex_wait 立即返回，不会丢失唤醒
+            int timed = pool->elastic && pool->idle_timeout_ms > 0;
+            struct timespec deadline;
+            if (timed) {
+                clock_gettime(CLOCK_MONOTONIC, &deadline);
+                deadline.tv_sec += pool->idle_timeout_ms / 1000;
+                deadline.tv_nsec += (long)(pool->idle_timeout_ms % 1000) * 1000000L;
+                if (deadline.tv_nsec >= 1000000000L) {
+                    deadline.tv_sec++;
+                    deadline.tv_nsec -= 1000000000L;
+                }
+            }
+            uint32_t seq = __atomic_load_n(&pool->park_seq, __ATOMIC_SEQ_CST);
+            __atomic_add_fetch(&pool->idle_num, 1, __ATOMIC_SEQ_CST);
+#if THREAD_POOL_TELEMETRY
+            telemetry_add(&worker->telemetry.parks, 1);
+#endif
+            while (thread_pool_pending(pool) == 0 &&
+                   __atomic_load_n(&pool->is_running, __ATOMIC_ACQUIRE)) {
+                if (thread_pool_futex_wait(&pool->park_seq, seq, timed ? &deadline : NULL) == ETIMEDOUT) {
+                    timed_out = 1;
+                    break;
+                }
+                seq = __atomic_load_n(&pool->park_seq, __ATOMIC_SEQ_CST);
+            }
+            __atomic_sub_fetch(&pool->idle_num, 1, __ATOMIC_SEQ_CST);
+        }
+        uint64_t idle_end = thread_pool_now_ns();
+#if THREAD_POOL_TELEMETRY
+        telemetry_add(&worker->telemetry.idle_ns, idle_end - idle_start);
+        __atomic_store_n(&worker->idle_since_ns, 0, __ATOMIC_RELAXED);
+#endif
+
+        // 9. 更新空闲间隔的滑动平均（权重1/8）；截断过长的间隔，负载回升后几次就能恢复自旋
+        uint64_t gap = idle_end - idle_start;
+        if (gap > pool->spin_max_ns * 4) gap = pool->spin_max_ns * 4;
+        worker->idle_ewma_ns = worker->idle_ewma_ns - worker->idle_ewma_ns / 8 + gap / 8;
+
+        // 10. 提交方看到有线程在自旋时会少唤醒休眠线程，取到任务前把多出的任务交给其他线程
+        size_t pending = thread_pool_pending(pool);
+        if (pending > 1) {
+            thread_pool_wake(pool, pending > INT_MAX ? INT_MAX : (int)pending - 1);
+        }
+
+        // 11. 线程池停止且任务已取完则退出（非强制模式会先把队列中的任务执行完）
+        int stop = !__atomic_load_n(&pool->is_running, __ATOMIC_ACQUIRE) && pending == 0;
+
+        // 12. 弹性模式：空闲超时且线程数多于下限，回收当前线程（线程自行分离，销毁时无需join）
+        //     已先撤销空闲登记再复查队列：之后入队的任务由其他线程处理
+        if (!stop && timed_out && pending == 0) {
+            pthread_mutex_lock(&pool->mutex);
+            if (__atomic_load_n(&pool->is_running, __ATOMIC_ACQUIRE) &&
+                thread_pool_pending(pool) == 0 && pool->thread_num > pool->min_threads) {
+                pool->thread_used[worker->slot] = 0;
+                __atomic_sub_fetch(&pool->thread_num, 1, __ATOMIC_RELAXED);
+                pthread_detach(pthread_self());
+                printf("thread pool shrink: %d threads\n", pool->thread_num);
+                pthread_mutex_unlock(&pool->mutex);
+                return NULL;
+            }
+            pthread_mutex_unlock(&pool->mutex);
+        }
+        if (stop) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 单调时钟（纳秒）
+ */
+static uint64_t thread_pool_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief 所有通道排队任务数（近似值）
+ */
+static size_t thread_pool_pending(thread_pool_t* pool) {
+    size_t n = 0;
+    for (int i = 0; i < THREAD_POOL_LANES; i++) {
+        n += task_ring_size(&pool->lanes[i]);
+    }
+    return n;
+}
+
+/**
+ * @brief 入队（通道长度达到max_task时视为已满）
+ * @return 成功返回0，通道已满返回-1
+ */
+static int thread_pool_try_push(thread_pool_t* pool, task_ring_t* ring, task_t* task) {
+    if (pool->max_task > 0 && task_ring_size(ring) >= (size_t)pool->max_task) {
+        return -1;
+    }
+    return task_ring_push(ring, task);
+}
+
+/**
+ * @brief 通道已满时按背压策略处理任务（接管task的所有权）
+ * @param pool 线程池指针
+ * @param task 入队失败的任务
+ * @return THREAD_POOL_OK：已入队；THREAD_POOL_RAN_INLINE：已在当前线程执行；
+ *         THREAD_POOL_REJECTED/TIMEOUT/ERROR：任务已销毁
+ */
+static int thread_pool_overflow(thread_pool_t* pool, task_t* task) {
+    task_ring_t* ring = &pool->lanes[task->lane];
+    lane_counters_t* counters = &pool->lane_counters[task->lane];
+    int policy = pool->overflow_policy;
+    if (policy == OVERFLOW_CALLBACK) {
+        policy = pool->on_overflow
+                     ? pool->on_overflow(pool, task->lane, task->func, task->arg, pool->overflow_user)
+                     : OVERFLOW_REJECT;
+    }
+
+    int ret = THREAD_POOL_REJECTED;
+    switch (policy) {
+    case OVERFLOW_BLOCK:
+        ret = thread_pool_wait_space(pool, ring, task);
+        break;
+    case OVERFLOW_CALLER_RUNS: {
+        // 在提交线程上执行：任务节点先归还，执行期间不占用队列
+        void (*func)(void*) = task->func;
+        void* arg = task->arg;
+        task_destroy(task);
+        __atomic_add_fetch(&counters->ran_inline, 1, __ATOMIC_RELAXED);
+        func(arg);
+        return THREAD_POOL_RAN_INLINE;
+    }
+    case OVERFLOW_DROP_OLDEST:
+        for (int i = 0; i < OVERFLOW_DROP_RETRY; i++) {
+            task_t* oldest = task_ring_pop(ring);
+            if (oldest) {
+                __atomic_add_fetch(&counters->dropped, 1, __ATOMIC_RELAXED);
+                if (oldest->on_expired) {
+                    oldest->on_expired(oldest->arg);
+                }
+                task_destroy(oldest);
+            }
+            if (thread_pool_try_push(pool, ring, task) == 0) {
+                ret = THREAD_POOL_OK;
+                break;
+            }
+            if (!oldest) break;
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (ret != THREAD_POOL_OK) {
+        __atomic_add_fetch(&counters->rejected, 1, __ATOMIC_RELAXED);
+        task_destroy(task);
+    }
+    return ret;
+}
+
+/**
+ * @brief 阻塞等待通道出现空位后入队
+ * @return THREAD_POOL_OK：已入队；THREAD_POOL_TIMEOUT：超时；THREAD_POOL_ERROR：线程池已停止
+ * @note 工作线程取走任务后只在有等待者时才加锁通知（无等待者时只多一次原子读）；
+ *       等待者登记与工作线程检查之间没有全屏障，通知可能丢失，因此每次最多等待
+ *       OVERFLOW_WAIT_SLICE_MS 后主动重试入队
+ */
+static int thread_pool_wait_space(thread_pool_t* pool, task_ring_t* ring, task_t* task) {
+    uint64_t deadline = 0;
+    if (pool->overflow_timeout_ms > 0) {
+        deadline = thread_pool_now_ns() + (uint64_t)pool->overflow_timeout_ms * 1000000ull;
+    }
+
+    int ret = THREAD_POOL_OK;
+    pthread_mutex_lock(&pool->space_mutex);
+    __atomic_add_fetch(&pool->space_waiters, 1, __ATOMIC_SEQ_CST);
+    while (thread_pool_try_push(pool, ring, task) != 0) {
+        if (!__atomic_load_n(&pool->is_running, __ATOMIC_ACQUIRE)) {
+            ret = THREAD_POOL_ERROR;
+            break;
+        }
+        uint64_t now = thread_pool_now_ns();
+        if (deadline != 0 && now >= deadline) {
+            ret = THREAD_POOL_TIMEOUT;
+            break;
+        }
+        uint64_t wake = now + OVERFLOW_WAIT_SLICE_MS * 1000000ull;
+        if (deadline != 0 && wake > deadline) {
+            wake = deadline;
+        }
+        struct timespec ts;
+        ts.tv_sec = (time_t)(wake / 1000000000ull);
+        ts.tv_nsec = (long)(wake % 1000000000ull);
+        pthread_cond_timedwait(&pool->space_cond, &pool->space_mutex, &ts);
+    }
+    __atomic_sub_fetch(&pool->space_waiters, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&pool->space_mutex);
+    return ret;
+}
+
+/**
+ * @brief 取走任务后通知等待空位的提交线程
+ */
+static inline void thread_pool_notify_space(thread_pool_t* pool) {
+    if (__atomic_load_n(&pool->space_waiters, __ATOMIC_RELAXED) > 0) {
+        pthread_mutex_lock(&pool->space_mutex);
+        pthread_cond_signal(&pool->space_cond);
+        pthread_mutex_unlock(&pool->space_mutex);
+    }
+}
+
+/**
+ * @brief 按加权轮转从各通道取任务
+ * @param pool 线程池指针
+ * @param credits 调用线程的各通道剩余调度次数
+ * @return 任务指针，所有通道为空返回NULL
+ * @note 优先取高优先级通道，但每个轮转周期内每个通道最多被调度 lane_weights[i] 次；
+ *       周期内高优先级额度用完后轮到低优先级通道，保证低优先级任务不会被饿死。
+ *       通道为空时不消耗额度，只有高优先级任务时仍然全部走高优先级
+ */
+static task_t* thread_pool_next_task(thread_pool_t* pool, int* credits) {
+    for (int round = 0; round < 2; round++) {
+        int any_pending = 0;
+        for (int i = 0; i < THREAD_POOL_LANES; i++) {
+            if (credits[i] <= 0) continue;
+            task_t* task = task_ring_pop(&pool->lanes[i]);
+            if (task) {
+                credits[i]--;
+                return task;
+            }
+        }
+        // 有额度的通道都为空：开始新的轮转周期
+        for (int i = 0; i < THREAD_POOL_LANES; i++) {
+            credits[i] = pool->lane_weights[i];
+            any_pending |= task_ring_size(&pool->lanes[i]) > 0;
+        }
+        if (!any_pending) break;
+    }
+    return NULL;
+}
+
+/**
+ * @brief 释放所有通道队列、线程数组和线程池本身（不销毁队列中的任务）
+ * @note 创建失败的各个阶段也调用此函数，未分配的字段为NULL
+ */
+static void thread_pool_release(thread_pool_t* pool) {
+    for (int i = 0; i < THREAD_POOL_LANES; i++) {
+        task_ring_destroy(&pool->lanes[i]);
+    }
+    free(pool->threads);
+    free(pool->workers);
+    free(pool->thread_used);
+    free(pool->cpu_order);
+    for (uint32_t i = 0; i < pool->timers.table_len; i++) {
+        free(pool->timers.table[i]);
+    }
+    free(pool->timers.table);
+    free(pool->timers.heap);
+    free(pool);
+}
+
+/**
+ * @brief 根据配置计算工作线程的绑核方案
+ * @param pool 线程池指针
+ * @param conf 配置
+ * @return 成功返回0，失败返回-1
+ * @note 拓扑中找不到指定节点时打印警告并退化为不绑核
+ */
+static int thread_pool_setup_affinity(thread_pool_t* pool, const thread_pool_config_t* conf) {
+    pool->affinity = conf->affinity;
+    pool->numa_node = conf->numa_node;
+    if (conf->affinity == AFFINITY_NONE) return 0;
+
+    if (conf->affinity == AFFINITY_CPU_LIST) {
+        if (!conf->cpu_list || conf->cpu_list_len <= 0) {
+            fprintf(stderr, "affinity: empty cpu list\n");
+            return -1;
+        }
+        pool->cpu_order = (int*)malloc(sizeof(int) * conf->cpu_list_len);
+        if (!pool->cpu_order) return -1;
+        memcpy(pool->cpu_order, conf->cpu_list, sizeof(int) * conf->cpu_list_len);
+        pool->cpu_order_len = conf->cpu_list_len;
+        return 0;
+    }
+
+    cpu_topology_t topo;
+    if (cpu_topology_load(&topo) != 0) {
+        perror("cpu_topology_load failed");
+        return -1;
+    }
+    int ret = 0;
+    if (conf->affinity == AFFINITY_COMPACT || conf->affinity == AFFINITY_SCATTER) {
+        pool->cpu_order = (int*)malloc(sizeof(int) * (topo.num_cpus > 0 ? topo.num_cpus : 1));
+        if (!pool->cpu_order) {
+            ret = -1;
+        } else {
+            pool->cpu_order_len = cpu_topology_order(&topo, conf->affinity, pool->cpu_order);
+            if (pool->cpu_order_len < 0) ret = -1;
+        }
+    } else if (conf->affinity == AFFINITY_NUMA_NODE) {
+        if (cpu_topology_node_cpus(&topo, conf->numa_node, &pool->node_cpus) == 0) {
+            fprintf(stderr, "affinity: numa node %d has no usable cpu, affinity disabled\n", conf->numa_node);
+            pool->affinity = AFFINITY_NONE;
+            pool->numa_node = -1;
+        }
+    } else {
+        fprintf(stderr, "affinity: unknown policy %d\n", conf->affinity);
+        ret = -1;
+    }
+    cpu_topology_free(&topo);
+    return ret;
+}
+
+/**
+ * @brief 在空闲槽位上新建一个工作线程（调用方需持有 pool->mutex）
+ * @param pool 线程池指针
+ * @return 成功返回0，失败返回-1
+ */
+static int thread_pool_spawn_locked(thread_pool_t* pool) {
+    for (int i = 0; i < pool->max_threads; i++) {
+        if (pool->thread_used[i]) continue;
+        // 创建前设置好CPU亲和性，线程从第一条指令起就运行在目标CPU上（首次触碰的内存也在本节点）
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        if (pool->cpu_order_len > 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(pool->cpu_order[i % pool->cpu_order_len], &set);
+            pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+        } else if (pool->affinity == AFFINITY_NUMA_NODE) {
+            pthread_attr_setaffinity_np(&attr, sizeof(pool->node_cpus), &pool->node_cpus);
+        }
+        int ret = pthread_create(&pool->threads[i], &attr, worker_loop, &pool->workers[i]);
+        pthread_attr_destroy(&attr);
+        if (ret != 0) {
+            errno = ret;
+            perror("pthread_create failed");
+            return -1;
+        }
+        pool->thread_used[i] = 1;
+        __atomic_add_fetch(&pool->thread_num, 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+    return -1;
+}
+
+/**
+ * @brief 弹性扩容：没有空闲线程且未达上限时新建一个线程
+ * @param pool 线程池指针
+ * @note 两次扩容至少间隔 grow_wait_ns，避免突发流量下一次性建满线程
+ */
+static void thread_pool_try_grow(thread_pool_t* pool) {
+    if (__atomic_load_n(&pool->idle_num, __ATOMIC_RELAXED) > 0 ||
+        __atomic_load_n(&pool->thread_num, __ATOMIC_RELAXED) >= pool->max_threads) {
+        return;
+    }
+    uint64_t now = thread_pool_now_ns();
+    uint64_t last = __atomic_load_n(&pool->last_grow_ns, __ATOMIC_RELAXED);
+    if (now - last < pool->grow_wait_ns ||
+        !__atomic_compare_exchange_n(&pool->last_grow_ns, &last, now, 0,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    if (__atomic_load_n(&pool->is_running, __ATOMIC_ACQUIRE) &&
+        pool->thread_num < pool->max_threads &&
+        thread_pool_spawn_locked(pool) == 0) {
+        printf("thread pool grow: %d threads\n", pool->thread_num);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+/**
+ * @brief 线程退出时把本地缓存全部归还全局空闲链表
+ * @param arg 线程本地缓存指针
+ */
+static void task_cache_on_thread_exit(void* arg) {
+    task_cache_flush((task_cache_t*)arg, 0);
+}
+
+static void task_cache_key_init(void) {
+    pthread_key_create(&g_task_allocator.key, task_cache_on_thread_exit);
+}
+
+/**
+ * @brief 从全局空闲链表补充本地缓存（全局也为空时分配新slab）
+ * @param cache 线程本地缓存
+ */
+static void task_cache_refill(task_cache_t* cache) {
+    if (!cache->registered) {
+        pthread_once(&g_task_allocator.key_once, task_cache_key_init);
+        pthread_setspecific(g_task_allocator.key, cache);
+        cache->registered = 1;
+    }
+
+    pthread_mutex_lock(&g_task_allocator.mutex);
+    if (!g_task_allocator.free_list) {
+        task_slab_t* slab = (task_slab_t*)malloc(sizeof(task_slab_t));
+        if (!slab) {
+            pthread_mutex_unlock(&g_task_allocator.mutex);
+            perror("malloc task slab failed");
+            return;
+        }
+        for (int i = 0; i < TASK_SLAB_SIZE; i++) {
+            slab->tasks[i].next = (i + 1 < TASK_SLAB_SIZE) ? &slab->tasks[i + 1] : NULL;
+        }
+        g_task_allocator.free_list = &slab->tasks[0];
+        g_task_allocator.free_count = TASK_SLAB_SIZE;
+        slab->next = g_task_allocator.slabs;
+        g_task_allocator.slabs = slab;
+        __atomic_add_fetch(&g_task_allocator.slab_allocs, 1, __ATOMIC_RELAXED);
+    }
+    // 一次搬运一批节点，摊薄加锁开销
+    for (int i = 0; i < TASK_CACHE_BATCH && g_task_allocator.free_list; i++) {
+        task_t* task = g_task_allocator.free_list;
+        g_task_allocator.free_list = task->next;
+        g_task_allocator.free_count--;
+        task->next = cache->head;
+        cache->head = task;
+        cache->count++;
+    }
+    pthread_mutex_unlock(&g_task_allocator.mutex);
+
+    __atomic_add_fetch(&g_task_allocator.cache_misses, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&g_task_allocator.cache_hits, cache->hits, __ATOMIC_RELAXED);
+    cache->hits = 0;
+}
+
+/**
+ * @brief 本地缓存归还全局空闲链表
+ * @param cache 线程本地缓存
+ * @param keep 本地保留的节点数
+ */
+static void task_cache_flush(task_cache_t* cache, int keep) {
+    if (cache->count <= keep) return;
+
+    // 先在锁外摘下要归还的一段链表
+    task_t* first = cache->head;
+    task_t* last = first;
+    int n = cache->count - keep;
+    for (int i = 1; i < n; i++) {
+        last = last->next;
+    }
+    cache->head = last->next;
+    cache->count = keep;
+
+    pthread_mutex_lock(&g_task_allocator.mutex);
+    last->next = g_task_allocator.free_list;
+    g_task_allocator.free_list = first;
+    g_task_allocator.free_count += n;
+    pthread_mutex_unlock(&g_task_allocator.mutex);
+
+    __atomic_add_fetch(&g_task_allocator.cache_hits, cache->hits, __ATOMIC_RELAXED);
+    cache->hits = 0;
+}
+
+/**
+ * @brief 创建单个任务
+ * @param func 任务函数
+ * @param arg 任务参数
+ * @return 任务指针，失败返回NULL
+ * @note 优先从线程本地缓存取节点，稳态下不加锁、不调用malloc
+ */
+static task_t* task_create(void (*func)(void*), void* arg) {
+    task_cache_t* cache = &t_task_cache;
+    if (cache->head) {
+        cache->hits++;
+    } else {
+        task_cache_refill(cache);
+        if (!cache->head) {
+            return NULL;
+        }
+    }
+    task_t* task = cache->head;
+    cache->head = task->next;
+    cache->count--;
+
+    task->func = func;
+    task->arg = arg;
+    task->next = NULL;
+    task->enqueue_ns = 0;
+    task->deadline_ns = 0;
+    task->on_expired = NULL;
+    task->lane = TASK_PRIO_NORMAL;
+    return task;
+}
+
+/**
+ * @brief 销毁单个任务（归还到线程本地缓存）
+ * @param task 任务指针
+ * @note 任务通常由提交线程分配、工作线程释放，缓存超过上限时成批归还全局空闲链表
+ */
+static void task_destroy(task_t* task) {
+    if (!task) return;
+
+    task_cache_t* cache = &t_task_cache;
+    task->next = cache->head;
+    cache->head = task;
+    cache->count++;
+    if (cache->count > TASK_CACHE_SIZE) {
+        task_cache_flush(cache, TASK_CACHE_SIZE - TASK_CACHE_BATCH);
+    }
+}
+
+/**
+ * @brief 获取任务节点分配统计（实现）
+ */
+void thread_pool_task_alloc_stats(task_alloc_stats_t* stats) {
+    if (!stats) return;
+    stats->cache_hits = __atomic_load_n(&g_task_allocator.cache_hits, __ATOMIC_RELAXED)
+                        + t_task_cache.hits; // 加上当前线程尚未汇总的部分
+    stats->cache_misses = __atomic_load_n(&g_task_allocator.cache_misses, __ATOMIC_RELAXED);
+    stats->slab_allocs = __atomic_load_n(&g_task_allocator.slab_allocs, __ATOMIC_RELAXED);
+    stats->nodes_total = stats->slab_allocs * TASK_SLAB_SIZE;
+}
+
+/**
+ * @brief 获取线程池遥测快照（实现）
+ */
+int thread_pool_get_telemetry(thread_pool_t* pool, thread_pool_telemetry_t* out) {
+    if (!out) return -1;
+    memset(out, 0, sizeof(*out));
+#if THREAD_POOL_TELEMETRY
+    if (!pool) return -1;
+    uint64_t now = thread_pool_now_ns();
+    for (int i = 0; i < pool->max_threads; i++) {
+        const thread_pool_telemetry_t* tm = &pool->workers[i].telemetry;
+        uint64_t idle_since = __atomic_load_n(&pool->workers[i].idle_since_ns, __ATOMIC_RELAXED);
+        if (idle_since != 0 && now > idle_since) {
+            out->idle_ns += now - idle_since; // 正在休眠的时间
+        }
+        out->tasks += __atomic_load_n(&tm->tasks, __ATOMIC_RELAXED);
+        out->wait_ns += __atomic_load_n(&tm->wait_ns, __ATOMIC_RELAXED);
+        out->busy_ns += __atomic_load_n(&tm->busy_ns, __ATOMIC_RELAXED);
+        out->idle_ns += __atomic_load_n(&tm->idle_ns, __ATOMIC_RELAXED);
+        out->spin_hits += __atomic_load_n(&tm->spin_hits, __ATOMIC_RELAXED);
+        out->parks += __atomic_load_n(&tm->parks, __ATOMIC_RELAXED);
+        for (int b = 0; b < THREAD_POOL_HIST_BUCKETS; b++) {
+            out->wait_hist[b] += __atomic_load_n(&tm->wait_hist[b], __ATOMIC_RELAXED);
+            out->run_hist[b] += __atomic_load_n(&tm->run_hist[b], __ATOMIC_RELAXED);
+        }
+    }
+    return 0;
+#else
+    (void)pool;
+    return -1;
+#endif
+}
+
+/**
+ * @brief 由直方图估算分位数（实现）
+ */
+uint64_t thread_pool_hist_percentile(const uint64_t hist[THREAD_POOL_HIST_BUCKETS], double p) {
+    uint64_t total = 0;
+    for (int b = 0; b < THREAD_POOL_HIST_BUCKETS; b++) total += hist[b];
+    if (total == 0) return 0;
+    uint64_t rank = (uint64_t)(p * (double)total);
+    if (rank >= total) rank = total - 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < THREAD_POOL_HIST_BUCKETS; b++) {
+        seen += hist[b];
+        if (seen > rank) return b == 0 ? 0 : (1ull << b) - 1;
+    }
+    return (1ull << (THREAD_POOL_HIST_BUCKETS - 1)) - 1;
+}
+
+/**
+ * @brief 创建线程池（实现）
+ */
+thread_pool_t* thread_pool_create(int thread_num) {
+    thread_pool_config_t cfg;
+    thread_pool_config_init(&cfg);
+    if (thread_num > 0) {
+        cfg.min_threads = thread_num;
+        cfg.max_threads = thread_num;
+    }
+    return thread_pool_create_ex(&cfg);
+}
+
+/**
+ * @brief 初始化线程池配置（实现）
+ */
+void thread_pool_config_init(thread_pool_config_t* cfg) {
+    if (!cfg) return;
+    cfg->min_threads = DEFAULT_THREAD_NUM;
+    cfg->max_threads = DEFAULT_THREAD_NUM;
+    cfg->idle_timeout_ms = DEFAULT_IDLE_TIMEOUT_MS;
+    cfg->grow_wait_us = DEFAULT_GROW_WAIT_US;
+    cfg->max_task = MAX_TASK_QUEUE;
+    cfg->lane_weights[TASK_PRIO_HIGH] = DEFAULT_LANE_WEIGHT_HIGH;
+    cfg->lane_weights[TASK_PRIO_NORMAL] = DEFAULT_LANE_WEIGHT_NORMAL;
+    cfg->lane_weights[TASK_PRIO_LOW] = DEFAULT_LANE_WEIGHT_LOW;
+    cfg->deadline_policy = DEADLINE_DROP;
+    cfg->affinity = AFFINITY_NONE;
+    cfg->cpu_list = NULL;
+    cfg->cpu_list_len = 0;
+    cfg->numa_node = -1;
+    cfg->overflow_policy = OVERFLOW_REJECT;
+    cfg->overflow_timeout_ms = 0;
+    cfg->on_overflow = NULL;
+    cfg->overflow_user = NULL;
+    cfg->idle_spin_us = DEFAULT_IDLE_SPIN_US;
+}
+
+/**
+ * @brief 按配置创建线程池（实现）
+ */
+thread_pool_t* thread_pool_create_ex(const thread_pool_config_t* cfg) {
+    // 1. 参数校验
+    thread_pool_config_t conf;
+    if (cfg) {
+        conf = *cfg;
+    } else {
+        thread_pool_config_init(&conf);
+    }
+    if (conf.min_threads <= 0) {
+        conf.min_threads = DEFAULT_THREAD_NUM;
+    }
+    if (conf.max_threads < conf.min_threads) {
+        conf.max_threads = conf.min_threads;
+    }
+
+    // 2. 初始化线程池结构体（按缓存行对齐，保证队列下标的填充生效）
+    //    指定了NUMA节点时，线程池结构体和任务队列首次写入时分配在该节点上
+    numa_policy_save_t mem_policy;
+    int prefer_node = conf.numa_node >= 0 && numa_prefer_begin(conf.numa_node, &mem_policy) == 0;
+    thread_pool_t* pool = NULL;
+    if (posix_memalign((void**)&pool, CACHE_LINE_SIZE, sizeof(thread_pool_t)) != 0) {
+        perror("malloc thread_pool failed");
+        if (prefer_node) numa_prefer_end(&mem_policy);
+        return NULL;
+    }
+    memset(pool, 0, sizeof(thread_pool_t));
+
+    // 3. 设置线程池参数
+    pool->min_threads = conf.min_threads;
+    pool->max_threads = conf.max_threads;
+    pool->elastic = conf.max_threads > conf.min_threads;
+    pool->idle_timeout_ms = conf.idle_timeout_ms;
+    pool->grow_wait_ns = (uint64_t)(conf.grow_wait_us > 0 ? conf.grow_wait_us : 0) * 1000ull;
+    pool->last_dequeue_ns = thread_pool_now_ns();
+    pool->max_task = conf.max_task;
+    pool->deadline_policy = conf.deadline_policy;
+    pool->overflow_policy = conf.overflow_policy;
+    pool->overflow_timeout_ms = conf.overflow_timeout_ms;
+    pool->on_overflow = conf.on_overflow;
+    pool->overflow_user = conf.overflow_user;
+    // 只有一个CPU时自旋只会占住提交线程需要的CPU，直接关闭
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    pool->spin_max_ns = conf.idle_spin_us > 0 && ncpu > 1 ? (uint64_t)conf.idle_spin_us * 1000ull : 0;
+    pool->yield_rounds = conf.idle_spin_us > 0 ? IDLE_YIELD_ROUNDS : 0;
+    for (int i = 0; i < THREAD_POOL_LANES; i++) {
+        pool->lane_weights[i] = conf.lane_weights[i] > 0 ? conf.lane_weights[i] : 1;
+    }
+    pool->is_running = 1; // 标记为运行状态
+
+    // 4. 创建各优先级通道的任务队列
+    for (int i = 0; i < THREAD_POOL_LANES; i++) {
+        if (task_ring_init(&pool->lanes[i],
+                           pool->max_task > 0 ? (size_t)pool->max_task : TASK_RING_DEFAULT_CAPACITY) != 0) {
+            if (prefer_node) numa_prefer_end(&mem_policy);
+            thread_pool_release(pool);
+            return NULL;
+        }
+    }
+    if (prefer_node) numa_prefer_end(&mem_policy);
+
+    // 5. 创建线程数组（按最大线程数分配槽位）并计算绑核方案
+    pool->threads = (pthread_t*)malloc(sizeof(pthread_t) * pool->max_threads);
+    pool->thread_used = (char*)calloc(pool->max_threads, sizeof(char));
+    if (posix_memalign((void**)&pool->workers, CACHE_LINE_SIZE,
+                       sizeof(thread_pool_worker_t) * pool->max_threads) != 0) {
+        pool->workers = NULL;
+    }
+    if (!pool->threads || !pool->thread_used || !pool->workers) {
+        perror("malloc threads failed");
+        thread_pool_release(pool);
+        return NULL;
+    }
+    memset(pool->workers, 0, sizeof(thread_pool_worker_t) * pool->max_threads);
+    for (int i = 0; i < pool->max_threads; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].slot = i;
+    }
+    if (thread_pool_setup_affinity(pool, &conf) != 0) {
+        thread_pool_release(pool);
+        return NULL;
+    }
+
+    // 6. 初始化互斥锁和条件变量（条件变量使用单调时钟，等待空位的超时不受系统时间调整影响）
+    if (pthread_mutex_init(&pool->mutex, NULL) != 0) {
+        perror("pthread_mutex_init failed");
+        thread_pool_release(pool);
+        return NULL;
+    }
+    if (pthread_mutex_init(&pool->space_mutex, NULL) != 0) {
+        perror("pthread_mutex_init failed");
+        pthread_mutex_destroy(&pool->mutex);
+        thread_pool_release(pool);
+        return NULL;
+    }
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    if (pthread_cond_init(&pool->space_cond, &cond_attr) != 0) {
+        perror("pthread_cond_init failed");
+        pthread_condattr_destroy(&cond_attr);
+        pthread_mutex_destroy(&pool->mutex);
+        pthread_mutex_destroy(&pool->space_mutex);
+        thread_pool_release(pool);
+        return NULL;
+    }
+    pthread_condattr_destroy(&cond_attr);
+    if (thread_pool_timers_init(pool) != 0) {
+        pthread_mutex_destroy(&pool->mutex);
+        pthread_mutex_destroy(&pool->space_mutex);
+        pthread_cond_destroy(&pool->space_cond);
+        thread_pool_release(pool);
+        return NULL;
+    }
+
+    // 7. 创建常驻工作线程
+    pthread_mutex_lock(&pool->mutex);
+    for (int i = 0; i < pool->min_threads; i++) {
+        if (thread_pool_spawn_locked(pool) != 0) {
+            // 停止并回收已创建的线程（线程休眠在futex上，不是取消点，需要显式唤醒）
+            pool->force_stop = 1;
+            __atomic_store_n(&pool->is_running, 0, __ATOMIC_RELEASE);
+            __atomic_add_fetch(&pool->park_seq, 1, __ATOMIC_SEQ_CST);
+            thread_pool_futex_wake(&pool->park_seq, INT_MAX);
+            pthread_mutex_unlock(&pool->mutex);
+            for (int j = 0; j < i; j++) {
+                pthread_join(pool->threads[j], NULL);
+            }
+            pthread_mutex_destroy(&pool->mutex);
+            pthread_mutex_destroy(&pool->space_mutex);
+            pthread_cond_destroy(&pool->space_cond);
+            pthread_mutex_destroy(&pool->timers.mutex);
+            pthread_cond_destroy(&pool->timers.cond);
+            thread_pool_release(pool);
+            return NULL;
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (pool->elastic) {
+        printf("thread pool created: %d-%d threads (elastic), max task: %d\n",
+               pool->min_threads, pool->max_threads, pool->max_task);
+    } else {
+        printf("thread pool created: %d threads, max task: %d\n", pool->thread_num, pool->max_task);
+    }
+    return pool;
+}
+
+/**
+ * @brief 提交任务到线程池（实现）
+ */
+int thread_pool_add_task(thread_pool_t* pool, void (*func)(void*), void* arg) {
+    return thread_pool_add_task_ex(pool, func, arg, NULL);
+}
+
+/**
+ * @brief 按选项提交任务（实现）
+ * @note 入队无锁；仅当有线程在休眠时才加锁唤醒
+ */
+int thread_pool_add_task_ex(thread_pool_t* pool, void (*func)(void*), void* arg, const task_options_t* opts) {
+    // 1. 参数校验
+    if (!pool || !func || !__atomic_load_n(&pool->is_running, __ATOMIC_ACQUIRE)) {
+        fprintf(stderr, "invalid param or pool stopped\n");
+        return THREAD_POOL_ERROR;
+    }
+    int lane = opts ? opts->priority : TASK_PRIO_NORMAL;
+    if (lane < 0 || lane >= THREAD_POOL_LANES) {
+        fprintf(stderr, "invalid task priority %d\n", lane);
+        return THREAD_POOL_ERROR;
+    }
+    task_ring_t* ring = &pool->lanes[lane];
+    lane_counters_t* counters = &pool->lane_counters[lane];
+
+    // 2. 创建新任务
+    task_t* new_task = task_create(func, arg);
+    if (!new_task) {
+        return THREAD_POOL_ERROR;
+    }
+    uint64_t now = thread_pool_now_ns();
+    new_task->enqueue_ns = now;
+    new_task->lane = lane;
+    if (opts) {
+        new_task->on_expired = opts->on_expired;
+        if (opts->deadline_ms > 0) {
+            new_task->deadline_ns = now + (uint64_t)opts->deadline_ms * 1000000ull;
+        }
+    }
+
+    // 3. 将任务添加到队列尾部，通道已满（超过max_task或环形队列已满）时按背压策略处理
+    if (thread_pool_try_push(pool, ring, new_task) != 0) {
+        int ret = thread_pool_overflow(pool, new_task);
+        if (ret != THREAD_POOL_OK) {
+            return ret;
+        }
+    }
+    __atomic_add_fetch(&counters->submitted, 1, __ATOMIC_RELAXED);
+
+    // 4. 有线程在休眠时才唤醒
+    thread_pool_wake(pool, 1);
+    if (pool->elastic) {
+        thread_pool_check_stall(pool, now);
+    }
+    return THREAD_POOL_OK;
+}
+
+/**
+ * @brief 当前任务是否已超时（实现）
+ */
+int thread_pool_task_expired(void) {
+    return t_task_expired;
+}
+
+/**
+ * @brief 获取优先级通道统计（实现）
+ */
+int thread_pool_get_lane_stats(thread_pool_t* pool, int lane, thread_pool_lane_stats_t* stats) {
+    if (!pool || !stats || lane < 0 || lane >= THREAD_POOL_LANES) return -1;
+    lane_counters_t* counters = &pool->lane_counters[lane];
+    stats->depth = task_ring_size(&pool->lanes[lane]);
+    stats->submitted = __atomic_load_n(&counters->submitted, __ATOMIC_RELAXED);
+    stats->rejected = __atomic_load_n(&counters->rejected, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&counters->dropped, __ATOMIC_RELAXED);
+    stats->ran_inline = __atomic_load_n(&counters->ran_inline, __ATOMIC_RELAXED);
+    // 执行方的计数分散在各工作线程中，这里合并（槽位在线程退出后保留，计数不会丢失）
+    stats->executed = stats->expired = stats->wait_ns_total = stats->wait_ns_max = 0;
+    for (int i = 0; i < pool->max_threads; i++) {
+        const worker_lane_counters_t* wc = &pool->workers[i].lanes[lane];
+        stats->executed += __atomic_load_n(&wc->executed, __ATOMIC_RELAXED);
+        stats->expired += __atomic_load_n(&wc->expired, __ATOMIC_RELAXED);
+        stats->wait_ns_total += __atomic_load_n(&wc->wait_ns_total, __ATOMIC_RELAXED);
+        uint64_t max = __atomic_load_n(&wc->wait_ns_max, __ATOMIC_RELAXED);
+        if (max > stats->wait_ns_max) stats->wait_ns_max = max;
+    }
+    return 0;
+}
+
+/**
+ * @brief 提交方检查：队列非空、没有空闲线程且长时间没有线程取任务（全部阻塞在长任务上）时扩容
+ * @param pool 线程池指针
+ * @param now 当前时间（纳秒）
+ */
+static void thread_pool_check_stall(thread_pool_t* pool, uint64_t now) {
+    if (__atomic_load_n(&pool->idle_num, __ATOMIC_RELAXED) > 0) return;
+    uint64_t last = __atomic_load_n(&pool->last_dequeue_ns, __ATOMIC_RELAXED);
+    if (now > last && now - last > pool->grow_wait_ns && thread_pool_pending(pool) > 0) {
+        thread_pool_try_grow(pool);
+    }
+}
+
+/**
+ * @brief 唤醒休眠的工作线程
+ * @param pool 线程池指针
+ * @param n 新入队的任务数
+ * @note 入队后全屏障再读 idle_num，与 worker_loop 中的"登记+复查"配对，避免丢失唤醒；
+ *       没有线程休眠时不做系统调用。正在自旋的线程会自己取走任务，相应少唤醒几个
+ *       （自旋线程放弃自旋后同样先登记再复查，不会漏掉这里没有唤醒的任务）
+ */
+static void thread_pool_wake(thread_pool_t* pool, int n) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int idle = __atomic_load_n(&pool->idle_num, __ATOMIC_SEQ_CST);
+    if (idle <= 0 || n <= 0) return;
+    n -= __atomic_load_n(&pool->spinning, __ATOMIC_SEQ_CST);
+    if (n <= 0) return;
+
+    __atomic_add_fetch(&pool->park_seq, 1, __ATOMIC_SEQ_CST);
+    thread_pool_futex_wake(&pool->park_seq, n >= idle ? INT_MAX : n); // 任务数不少于空闲线程数：全部唤醒
+}
+
+/**
+ * @brief 休眠前的自适应等待：先自旋，再让出CPU，期间有任务入队则不必休眠
+ * @param pool 线程池指针
+ * @param worker 工作线程上下文
+ * @param idle_start 队列变空的时间（纳秒）
+ * @return 等到任务返回1，需要休眠返回0
+ * @note 自旋预算为最近空闲间隔平均值的2倍（不超过 spin_max_ns）：到达间隔短时在自旋中接到任务，
+ *       省掉一次futex唤醒和两次上下文切换；平均间隔超过上限时自旋接不到任务，只让出CPU后休眠。
+ *       同时自旋的线程不超过当前线程数的一半，其余线程直接休眠
+ */
+static int thread_pool_idle_spin(thread_pool_t* pool, thread_pool_worker_t* worker, uint64_t idle_start) {
+    if (pool->yield_rounds == 0) return 0;
+    int limit = __atomic_load_n(&pool->thread_num, __ATOMIC_RELAXED) / 2;
+    if (limit < 1) limit = 1;
+    if (__atomic_add_fetch(&pool->spinning, 1, __ATOMIC_SEQ_CST) > limit) {
+        __atomic_sub_fetch(&pool->spinning, 1, __ATOMIC_SEQ_CST);
+        return 0;
+    }
+
+    int found = 0;
+    if (pool->spin_max_ns > 0 && worker->idle_ewma_ns <= pool->spin_max_ns) {
+        uint64_t budget = worker->idle_ewma_ns * 2 + pool->spin_max_ns / 16;
+        if (budget > pool->spin_max_ns) budget = pool->spin_max_ns;
+        for (unsigned i = 1; __atomic_load_n(&pool->is_running, __ATOMIC_RELAXED); i++) {
+            if (thread_pool_pending(pool) > 0) {
+                found = 1;
+                break;
+            }
+            thread_pool_cpu_relax();
+            if (i % IDLE_SPIN_CHECK == 0 && thread_pool_now_ns() - idle_start >= budget) {
+                break;
+            }
+        }
+    }
+    for (int i = 0; !found && i < pool->yield_rounds &&
+                    __atomic_load_n(&pool->is_running, __ATOMIC_RELAXED); i++) {
+        sched_yield();
+        found = thread_pool_pending(pool) > 0;
+    }
+    __atomic_sub_fetch(&pool->spinning, 1, __ATOMIC_SEQ_CST);
+    return found;
+}
+
+/**
+ * @brief futex等待：*addr 仍等于 val 时休眠
+ * @param deadline 绝对超时时间（CLOCK_MONOTONIC，NULL表示不超时）
+ * @return 被唤醒返回0，否则返回 errno（EAGAIN：值已改变；ETIMEDOUT：超时；EINTR：被信号打断）
+ */
+static int thread_pool_futex_wait(uint32_t* addr, uint32_t val, const struct timespec* deadline) {
+    if (syscall(SYS_futex, addr, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG, val, deadline,
+                NULL, FUTEX_BITSET_MATCH_ANY) == 0) {
+        return 0;
+    }
+    return errno;
+}
+
+/**
+ * @brief futex唤醒最多n个等待线程
+ */
+static void thread_pool_futex_wake(uint32_t* addr, int n) {
+    syscall(SYS_futex, addr, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, n, NULL, NULL, 0);
+}
+
+/**
+ * @brief 自旋等待提示：降低自旋对同核超线程的干扰和退出自旋时的流水线清空开销
+ */
+static inline void thread_pool_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#endif
+}
+
+/**
+ * @brief 批量提交任务到线程池（实现）
+ */
+int thread_pool_add_tasks(thread_pool_t* pool, void (*const funcs[])(void*), void* const args[], int n) {
+    // 1. 参数校验
+    if (!pool || !funcs || n < 0 || !__atomic_load_n(&pool->is_running, __ATOMIC_ACQUIRE)) {
+        fprintf(stderr, "invalid param or pool stopped\n");
+        return -1;
+    }
+
+    task_ring_t* ring = &pool->lanes[TASK_PRIO_NORMAL];
+    lane_counters_t* counters = &pool->lane_counters[TASK_PRIO_NORMAL];
+    task_t* batch[64];
+    int submitted = 0;
+    while (submitted < n) {
+        // 2. 按剩余空间截断本批数量
+        int want = n - submitted;
+        if (want > (int)(sizeof(batch) / sizeof(batch[0]))) {
+            want = (int)(sizeof(batch) / sizeof(batch[0]));
+        }
+        if (pool->max_task > 0) {
+            size_t size = task_ring_size(ring);
+            int room = size >= (size_t)pool->max_task ? 0 : (int)(pool->max_task - size);
+            if (want > room) want = room;
+        }
+        if (want == 0) break;
+
+        // 3. 创建任务（线程本地缓存，不加锁）
+        uint64_t now = thread_pool_now_ns();
+        int created = 0;
+        for (; created < want; created++) {
+            batch[created] = task_create(funcs[submitted + created], args ? args[submitted + created] : NULL);
+            if (!batch[created]) break;
+            batch[created]->enqueue_ns = now;
+            batch[created]->lane = TASK_PRIO_NORMAL;
+        }
+
+        // 4. 一次占用队列位置
+        int pushed = task_ring_push_batch(ring, batch, created);
+        for (int i = pushed; i < created; i++) {
+            task_destroy(batch[i]);
+        }
+        submitted += pushed;
+        __atomic_add_fetch(&counters->submitted, pushed, __ATOMIC_RELAXED);
+        thread_pool_wake(pool, pushed);
+        if (pool->elastic) {
+            thread_pool_check_stall(pool, now);
+        }
+        if (pushed < want) break;
+    }
+
+    // 5. 放不下的任务按背压策略逐个处理，遇到未被接收的任务即停止（该任务已计入rejected）
+    int counted = 0;
+    if (submitted < n && pool->overflow_policy != OVERFLOW_REJECT) {
+        while (submitted < n &&
+               thread_pool_add_task_ex(pool, funcs[submitted], args ? args[submitted] : NULL, NULL) >= 0) {
+            submitted++;
+        }
+        counted = submitted < n;
+    }
+    if (submitted < n) {
+        __atomic_add_fetch(&counters->rejected, n - submitted - counted, __ATOMIC_RELAXED);
+    }
+    return submitted;
+}
+
+/**
+ * @brief 销毁线程池（实现）
+ */
+void thread_pool_destroy(thread_pool_t* pool, int force) {
+    if (!pool) return;
+
+    // 1. 先停止定时线程（不再有到期任务进入队列），再加锁标记线程池停止
+    //    已进入队列的周期任务执行完后不再重新入堆
+    thread_pool_timers_stop(pool);
+    pthread_mutex_lock(&pool->mutex);
+    pool->force_stop = force;
+    __atomic_store_n(&pool->is_running, 0, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&pool->mutex);
+    // 2. 唤醒所有等待的线程（包括等待空位的提交线程，它们会返回 THREAD_POOL_ERROR）
+    __atomic_add_fetch(&pool->park_seq, 1, __ATOMIC_SEQ_CST);
+    thread_pool_futex_wake(&pool->park_seq, INT_MAX);
+    pthread_mutex_lock(&pool->space_mutex);
+    pthread_cond_broadcast(&pool->space_cond);
+    pthread_mutex_unlock(&pool->space_mutex);
+
+    // 3. 等待所有线程退出（非强制模式下线程会先执行完队列中的任务）
+    //    is_running置0后不会再扩容或回收线程，thread_used不再变化
+    for (int i = 0; i < pool->max_threads; i++) {
+        if (!pool->thread_used[i]) continue;
+        if (pthread_join(pool->threads[i], NULL) != 0) {
+            perror("pthread_join failed");
+        }
+    }
+
+    // 4. 清理任务队列中剩余的任务（强制退出时丢弃的任务、或停止期间并发提交的任务）
+    for (int i = 0; i < THREAD_POOL_LANES; i++) {
+        task_t* task;
+        while ((task = task_ring_pop(&pool->lanes[i])) != NULL) {
+            task_destroy(task);
+        }
+    }
+
+    // 5. 等待提交线程离开等待空位的循环后释放资源
+    while (__atomic_load_n(&pool->space_waiters, __ATOMIC_ACQUIRE) > 0) {
+        sched_yield();
+    }
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_mutex_destroy(&pool->space_mutex);
+    pthread_cond_destroy(&pool->space_cond);
+    pthread_mutex_destroy(&pool->timers.mutex);
+    pthread_cond_destroy(&pool->timers.cond);
+    thread_pool_release(pool); // 同时释放所有定时器（包括强制退出时被丢弃的到期任务对应的定时器）
+
+    printf("thread pool destroyed (force: %d)\n", force);
+}
+
+// ====================== 串行执行器实现 ======================
+/**
+ * @brief strand队列入队（Vyukov 无锁MPSC队列）
+ * @note 交换head之后、链接prev->next之前，消费者看到的队列在此处暂时断开（出队返回NULL），
+ *       调用方已先把任务计入state，strand_run发现"有任务但取不到"时重新调度自己稍后再取
+ */
+static void strand_queue_push(thread_pool_strand_t* strand, task_t* node) {
+    __atomic_store_n(&node->next, NULL, __ATOMIC_RELAXED);
+    task_t* prev = __atomic_exchange_n(&strand->head, node, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief strand队列出队
+ * @return 任务节点；队列为空或生产者正在入队返回NULL
+ */
+static task_t* strand_queue_pop(thread_pool_strand_t* strand) {
+    task_t* tail = strand->tail;
+    task_t* next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if (tail == &strand->stub) {
+        if (!next) return NULL;
+        strand->tail = next;
+        tail = next;
+        next = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+    }
+    if (next) {
+        strand->tail = next;
+        return tail;
+    }
+    if (tail != __atomic_load_n(&strand->head, __ATOMIC_ACQUIRE)) {
+        return NULL; // 生产者正在入队
+    }
+    // 队列只剩最后一个节点：放回哨兵后才能取出它
+    strand_queue_push(strand, &strand->stub);
+    next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if (next) {
+        strand->tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+/**
+ * @brief 初始化strand（实现）
+ */
+int thread_pool_strand_init(thread_pool_strand_t* strand, thread_pool_t* pool) {
+    if (!strand || !pool) return -1;
+    memset(strand, 0, sizeof(thread_pool_strand_t));
+    strand->pool = pool;
+    strand->head = &strand->stub;
+    strand->tail = &strand->stub;
+    return 0;
+}
+
+/**
+ * @brief 销毁strand（实现）
+ */
+void thread_pool_strand_destroy(thread_pool_strand_t* strand) {
+    if (!strand) return;
+    task_t* task;
+    while ((task = strand_queue_pop(strand)) != NULL) {
+        task_destroy(task);
+    }
+}
+
+/**
+ * @brief 只把任务放入strand（实现）
+ */
+int thread_pool_strand_enqueue(thread_pool_strand_t* strand, void (*func)(void*), void* arg) {
+    if (!strand || !func) return THREAD_POOL_ERROR;
+    task_t* node = task_create(func, arg);
+    if (!node) return THREAD_POOL_ERROR;
+
+    // 先计数再入队：state中的任务数不会少于队列中可见的节点数
+    size_t old = __atomic_fetch_add(&strand->state, 2, __ATOMIC_SEQ_CST);
+    strand_queue_push(strand, node);
+    if (old & 1) {
+        return 0; // 已被调度，当前持有令牌的一方会执行到这个任务
+    }
+    // 令牌空闲：与其他投递方竞争，取得令牌的一方负责调度
+    return (__atomic_fetch_or(&strand->state, 1, __ATOMIC_SEQ_CST) & 1) ? 0 : 1;
+}
+
+/**
+ * @brief 向strand投递任务（实现）
+ */
+int thread_pool_strand_post(thread_pool_strand_t* strand, void (*func)(void*), void* arg) {
+    int ret = thread_pool_strand_enqueue(strand, func, arg);
+    if (ret <= 0) {
+        return ret;
+    }
+    ret = thread_pool_add_task(strand->pool, thread_pool_strand_run, strand);
+    return ret >= 0 ? THREAD_POOL_OK : THREAD_POOL_REJECTED;
+}
+
+/**
+ * @brief strand的执行函数（实现）
+ * @note 只有持有令牌的线程会进入这里，队列消费端因此是单线程的
+ */
+void thread_pool_strand_run(void* arg) {
+    thread_pool_strand_t* strand = (thread_pool_strand_t*)arg;
+    while (1) {
+        // 1. 连续执行一批任务
+        size_t ran = 0;
+        task_t* task;
+        while (ran < STRAND_BATCH && (task = strand_queue_pop(strand)) != NULL) {
+            task->func(task->arg);
+            task_destroy(task);
+            ran++;
+        }
+
+        // 2. 扣除已执行的任务数；没有剩余任务时归还令牌（CAS成功后不再访问strand）
+        size_t state = __atomic_sub_fetch(&strand->state, ran * 2, __ATOMIC_SEQ_CST);
+        while (state == 1) {
+            if (__atomic_compare_exchange_n(&strand->state, &state, 0, 0,
+                                            __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+                return;
+            }
+        }
+
+        // 3. 还有任务（或有生产者正在入队）：重新提交自己，让出当前线程；
+        //    不经过背压策略，线程池已满时直接在当前线程继续
+        task_t* self = task_create(thread_pool_strand_run, strand);
+        if (self) {
+            task_ring_t* ring = &strand->pool->lanes[TASK_PRIO_NORMAL];
+            self->enqueue_ns = thread_pool_now_ns();
+            self->lane = TASK_PRIO_NORMAL;
+            if (thread_pool_try_push(strand->pool, ring, self) == 0) {
+                __atomic_add_fetch(&strand->pool->lane_counters[TASK_PRIO_NORMAL].submitted, 1, __ATOMIC_RELAXED);
+                thread_pool_wake(strand->pool, 1);
+                return;
+            }
+            task_destroy(self);
+        }
+        if (ran == 0) {
+            sched_yield(); // 生产者正在入队，稍后再取
+        }
+    }
+}
+
+/**
+ * @brief strand是否空闲（实现）
+ */
+int thread_pool_strand_idle(thread_pool_strand_t* strand) {
+    return __atomic_load_n(&strand->state, __ATOMIC_ACQUIRE) == 0;
+}
+
+// ====================== 延时/周期任务实现 ======================
+/**
+ * @brief 初始化定时器锁和条件变量（定时线程在首次调度时创建）
+ * @return 成功返回0，失败返回-1
+ */
+static int thread_pool_timers_init(thread_pool_t* pool) {
+    thread_pool_timers_t* timers = &pool->timers;
+    if (pthread_mutex_init(&timers->mutex, NULL) != 0) {
+        perror("pthread_mutex_init failed");
+        return -1;
+    }
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    if (pthread_cond_init(&timers->cond, &cond_attr) != 0) {
+        perror("pthread_cond_init failed");
+        pthread_condattr_destroy(&cond_attr);
+        pthread_mutex_destroy(&timers->mutex);
+        return -1;
+    }
+    pthread_condattr_destroy(&cond_attr);
+    return 0;
+}
+
+/**
+ * @brief 停止并回收定时线程（堆中未到期的定时器不再执行，由 thread_pool_release 释放）
+ */
+static void thread_pool_timers_stop(thread_pool_t* pool) {
+    thread_pool_timers_t* timers = &pool->timers;
+    pthread_mutex_lock(&timers->mutex);
+    timers->stop = 1;
+    int started = timers->started;
+    pthread_cond_signal(&timers->cond);
+    pthread_mutex_unlock(&timers->mutex);
+    if (started && pthread_join(timers->thread, NULL) != 0) {
+        perror("pthread_join timer thread failed");
+    }
+}
+
+/**
+ * @brief 分配定时器：优先复用空闲定时器，否则新建并登记到定时器表
+ * @return 定时器；内存不足返回NULL
+ * @note 同时保证堆容量不小于定时器总数，之后的入堆（包括周期任务重新入堆）不会失败
+ */
+static timer_entry_t* timer_alloc_locked(thread_pool_timers_t* timers) {
+    timer_entry_t* entry = timers->free_list;
+    if (entry) {
+        timers->free_list = entry->next_free;
+        return entry;
+    }
+
+    // 1. 扩容定时器表和堆
+    if (timers->table_len == timers->table_cap) {
+        uint32_t cap = timers->table_cap ? timers->table_cap * 2 : 64;
+        timer_entry_t** table = (timer_entry_t**)realloc(timers->table, sizeof(timer_entry_t*) * cap);
+        if (!table) return NULL;
+        timers->table = table;
+        timers->table_cap = cap;
+    }
+    if ((uint32_t)timers->heap_cap <= timers->table_len) {
+        int cap = timers->heap_cap ? timers->heap_cap * 2 : 64;
+        timer_heap_node_t* heap = (timer_heap_node_t*)realloc(timers->heap, sizeof(timer_heap_node_t) * cap);
+        if (!heap) return NULL;
+        timers->heap = heap;
+        timers->heap_cap = cap;
+    }
+
+    // 2. 新建定时器
+    entry = (timer_entry_t*)calloc(1, sizeof(timer_entry_t));
+    if (!entry) return NULL;
+    entry->index = timers->table_len;
+    timers->table[timers->table_len++] = entry;
+    return entry;
+}
+
+/**
+ * @brief 释放定时器：代数递增使旧句柄失效，放回空闲链表
+ */
+static void timer_free_locked(thread_pool_timers_t* timers, timer_entry_t* entry) {
+    entry->gen++;
+    entry->state = TIMER_FREE;
+    entry->cancelled = 0;
+    entry->func = NULL;
+    entry->arg = NULL;
+    entry->next_free = timers->free_list;
+    timers->free_list = entry;
+}
+
+/**
+ * @brief 入堆（上浮）；成为新的堆顶时通知定时线程提前醒来
+ */
+static void timer_heap_push_locked(thread_pool_timers_t* timers, timer_entry_t* entry) {
+    int i = timers->heap_len++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (timers->heap[parent].due_ns <= entry->due_ns) break;
+        timers->heap[i] = timers->heap[parent];
+        i = parent;
+    }
+    timers->heap[i].due_ns = entry->due_ns;
+    timers->heap[i].entry = entry;
+    if (i == 0) {
+        pthread_cond_signal(&timers->cond);
+    }
+}
+
+/**
+ * @brief 下沉
+ */
+static void timer_heap_sift_down(thread_pool_timers_t* timers, int i) {
+    timer_heap_node_t node = timers->heap[i];
+    int n = timers->heap_len;
+    while (1) {
+        int child = 2 * i + 1;
+        if (child >= n) break;
+        if (child + 1 < n && timers->heap[child + 1].due_ns < timers->heap[child].due_ns) {
+            child++;
+        }
+        if (node.due_ns <= timers->heap[child].due_ns) break;
+        timers->heap[i] = timers->heap[child];
+        i = child;
+    }
+    timers->heap[i] = node;
+}
+
+/**
+ * @brief 取出堆顶
+ */
+static timer_entry_t* timer_heap_pop_locked(thread_pool_timers_t* timers) {
+    timer_entry_t* entry = timers->heap[0].entry;
+    if (--timers->heap_len > 0) {
+        timers->heap[0] = timers->heap[timers->heap_len];
+        timer_heap_sift_down(timers, 0);
+    }
+    return entry;
+}
+
+/**
+ * @brief 移除已取消的条目并重建堆（O(n)，只在已取消条目超过一半时进行，均摊到每次取消为O(1)）
+ */
+static void timer_heap_compact_locked(thread_pool_timers_t* timers) {
+    int n = 0;
+    for (int i = 0; i < timers->heap_len; i++) {
+        timer_entry_t* entry = timers->heap[i].entry;
+        if (entry->cancelled) {
+            timer_free_locked(timers, entry);
+        } else {
+            timers->heap[n++] = timers->heap[i];
+        }
+    }
+    timers->heap_len = n;
+    timers->heap_cancelled = 0;
+    for (int i = n / 2 - 1; i >= 0; i--) {
+        timer_heap_sift_down(timers, i);
+    }
+}
+
+/**
+ * @brief 添加定时器，需要时创建定时线程
+ * @param delay_ns 首次到期的延时
+ * @param period_ns 周期（0表示一次性）
+ * @return 定时任务句柄，失败返回0
+ */
+static thread_pool_timer_t thread_pool_schedule(thread_pool_t* pool, uint64_t delay_ns, uint64_t period_ns,
+                                                void (*func)(void*), void* arg) {
+    if (!pool || !func || !__atomic_load_n(&pool->is_running, __ATOMIC_ACQUIRE)) {
+        fprintf(stderr, "invalid param or pool stopped\n");
+        return 0;
+    }
+    thread_pool_timers_t* timers = &pool->timers;
+    pthread_mutex_lock(&timers->mutex);
+    if (timers->stop) {
+        pthread_mutex_unlock(&timers->mutex);
+        return 0;
+    }
+    if (!timers->started) {
+        if (pthread_create(&timers->thread, NULL, timer_loop, pool) != 0) {
+            perror("pthread_create timer thread failed");
+            pthread_mutex_unlock(&timers->mutex);
+            return 0;
+        }
+        timers->started = 1;
+    }
+    timer_entry_t* entry = timer_alloc_locked(timers);
+    if (!entry) {
+        perror("malloc timer failed");
+        pthread_mutex_unlock(&timers->mutex);
+        return 0;
+    }
+    entry->func = func;
+    entry->arg = arg;
+    entry->pool = pool;
+    entry->due_ns = thread_pool_now_ns() + delay_ns;
+    entry->period_ns = period_ns;
+    entry->state = TIMER_PENDING;
+    timer_heap_push_locked(timers, entry);
+    thread_pool_timer_t id = ((uint64_t)entry->gen << 32) | (uint64_t)(entry->index + 1);
+    pthread_mutex_unlock(&timers->mutex);
+    return id;
+}
+
+/**
+ * @brief 定时线程：等到堆顶到期，取出一批到期的定时器，解锁后一次批量提交到线程池
+ * @note 提交遵循线程池的背压策略：OVERFLOW_BLOCK 时定时线程会等待空位；
+ *       未被接收的定时器（队列满）在 TIMER_RETRY_MS 后重试，不会丢失
+ */
+static void* timer_loop(void* arg) {
+    thread_pool_t* pool = (thread_pool_t*)arg;
+    thread_pool_timers_t* timers = &pool->timers;
+    void (*funcs[TIMER_BATCH])(void*);
+    void* args[TIMER_BATCH];
+    for (int i = 0; i < TIMER_BATCH; i++) {
+        funcs[i] = timer_run;
+    }
+
+    pthread_mutex_lock(&timers->mutex);
+    while (!timers->stop) {
+        // 1. 等到堆顶到期（新的堆顶或停止时被提前唤醒）
+        if (timers->heap_len == 0) {
+            pthread_cond_wait(&timers->cond, &timers->mutex);
+            continue;
+        }
+        uint64_t now = thread_pool_now_ns();
+        uint64_t due = timers->heap[0].due_ns;
+        if (due > now) {
+            struct timespec ts;
+            ts.tv_sec = (time_t)(due / 1000000000ull);
+            ts.tv_nsec = (long)(due % 1000000000ull);
+            pthread_cond_timedwait(&timers->cond, &timers->mutex, &ts);
+            continue;
+        }
+
+        // 2. 取出一批到期的定时器，已取消的直接释放
+        int n = 0;
+        while (n < TIMER_BATCH && timers->heap_len > 0 && timers->heap[0].due_ns <= now) {
+            timer_entry_t* entry = timer_heap_pop_locked(timers);
+            if (entry->cancelled) {
+                timers->heap_cancelled--;
+                timer_free_locked(timers, entry);
+                continue;
+            }
+            entry->state = TIMER_QUEUED;
+            args[n++] = entry;
+        }
+        // 到期的条目离开堆后，剩下的可能大多已取消（例如大量被取消的远期定时器）
+        if (timers->heap_cancelled > TIMER_COMPACT_MIN && timers->heap_cancelled * 2 > timers->heap_len) {
+            timer_heap_compact_locked(timers);
+        }
+        if (n == 0) continue;
+
+        // 3. 解锁后批量提交（一次占用队列位置，一次唤醒）
+        pthread_mutex_unlock(&timers->mutex);
+        int accepted = thread_pool_add_tasks(pool, funcs, args, n);
+        if (accepted < 0) accepted = 0;
+        pthread_mutex_lock(&timers->mutex);
+
+        // 4. 未被接收的定时器稍后重试（期间被取消的直接释放）
+        for (int i = accepted; i < n; i++) {
+            timer_entry_t* entry = (timer_entry_t*)args[i];
+            if (entry->cancelled) {
+                timer_free_locked(timers, entry);
+                continue;
+            }
+            entry->state = TIMER_PENDING;
+            entry->due_ns = now + TIMER_RETRY_MS * 1000000ull;
+            timer_heap_push_locked(timers, entry);
+        }
+    }
+    pthread_mutex_unlock(&timers->mutex);
+    return NULL;
+}
+
+/**
+ * @brief 到期定时器的执行函数（作为普通任务在工作线程上执行）
+ * @param arg 定时器
+ * @note 周期任务在本次执行结束后才重新入堆，同一个定时器的执行不会重叠
+ */
+static void timer_run(void* arg) {
+    timer_entry_t* entry = (timer_entry_t*)arg;
+    thread_pool_timers_t* timers = &entry->pool->timers;
+
+    // 1. 排队期间被取消则不执行
+    pthread_mutex_lock(&timers->mutex);
+    if (entry->cancelled) {
+        timer_free_locked(timers, entry);
+        pthread_mutex_unlock(&timers->mutex);
+        return;
+    }
+    entry->state = TIMER_RUNNING;
+    void (*func)(void*) = entry->func;
+    void* func_arg = entry->arg;
+    pthread_mutex_unlock(&timers->mutex);
+
+    // 2. 执行任务（不持有锁，任务内可以调度或取消定时器）
+    func(func_arg);
+
+    // 3. 周期任务按固定频率计算下次到期时间，已落后则从现在起再等一个周期
+    pthread_mutex_lock(&timers->mutex);
+    if (entry->period_ns > 0 && !entry->cancelled && !timers->stop) {
+        uint64_t now = thread_pool_now_ns();
+        entry->due_ns += entry->period_ns;
+        if (entry->due_ns <= now) {
+            entry->due_ns = now + entry->period_ns;
+        }
+        entry->state = TIMER_PENDING;
+        timer_heap_push_locked(timers, entry);
+    } else {
+        timer_free_locked(timers, entry);
+    }
+    pthread_mutex_unlock(&timers->mutex);
+}
+
+/**
+ * @brief 延时执行任务（实现）
+ */
+thread_pool_timer_t thread_pool_schedule_after(thread_pool_t* pool, int delay_ms, void (*func)(void*), void* arg) {
+    if (delay_ms < 0) {
+        fprintf(stderr, "invalid delay %d ms\n", delay_ms);
+        return 0;
+    }
+    return thread_pool_schedule(pool, (uint64_t)delay_ms * 1000000ull, 0, func, arg);
+}
+
+/**
+ * @brief 周期执行任务（实现）
+ */
+thread_pool_timer_t thread_pool_schedule_every(thread_pool_t* pool, int period_ms, void (*func)(void*), void* arg) {
+    if (period_ms <= 0) {
+        fprintf(stderr, "invalid period %d ms\n", period_ms);
+        return 0;
+    }
+    uint64_t period_ns = (uint64_t)period_ms * 1000000ull;
+    return thread_pool_schedule(pool, period_ns, period_ns, func, arg);
+}
+
+/**
+ * @brief 取消定时任务（实现）
+ * @note 在堆中的定时器只做标记；已取消条目超过堆的一半时整理堆，避免大量取消的远期定时器长期占用内存
+ */
+int thread_pool_timer_cancel(thread_pool_t* pool, thread_pool_timer_t timer) {
+    if (!pool || timer == 0) return -1;
+    uint32_t index = (uint32_t)(timer & 0xffffffffull) - 1;
+    uint32_t gen = (uint32_t)(timer >> 32);
+    thread_pool_timers_t* timers = &pool->timers;
+    int ret = -1;
+
+    pthread_mutex_lock(&timers->mutex);
+    if (index < timers->table_len) {
+        timer_entry_t* entry = timers->table[index];
+        if (entry->gen == gen && entry->state != TIMER_FREE && !entry->cancelled &&
+            !(entry->state == TIMER_RUNNING && entry->period_ns == 0)) {
+            entry->cancelled = 1;
+            ret = entry->state == TIMER_RUNNING ? 1 : 0;
+            if (entry->state == TIMER_PENDING) {
+                timers->heap_cancelled++;
+                if (timers->heap_cancelled > TIMER_COMPACT_MIN && timers->heap_cancelled * 2 > timers->heap_len) {
+                    timer_heap_compact_locked(timers);
+                }
+            }
+        }
+    }
+    pthread_mutex_unlock(&timers->mutex);
+    return ret;
+}
+
+/**
+ * @brief 创建按NUMA节点划分的线程池组（实现）
+ */
+numa_thread_pool_t* numa_thread_pool_create(const thread_pool_config_t* cfg) {
+    cpu_topology_t topo;
+    if (cpu_topology_load(&topo) != 0) {
+        perror("cpu_topology_load failed");
+        return NULL;
+    }
+    numa_thread_pool_t* npool = (numa_thread_pool_t*)calloc(1, sizeof(numa_thread_pool_t));
+    if (!npool) {
+        cpu_topology_free(&topo);
+        return NULL;
+    }
+
+    thread_pool_config_t conf;
+    if (cfg) {
+        conf = *cfg;
+    } else {
+        thread_pool_config_init(&conf);
+    }
+    for (int i = 0; i < topo.num_nodes; i++) {
+        cpu_set_t set;
+        int node_cpus = cpu_topology_node_cpus(&topo, topo.nodes[i], &set);
+        thread_pool_config_t node_conf = conf;
+        node_conf.affinity = AFFINITY_NUMA_NODE;
+        node_conf.numa_node = topo.nodes[i];
+        node_conf.cpu_list = NULL;
+        node_conf.cpu_list_len = 0;
+        if (node_conf.min_threads <= 0) node_conf.min_threads = node_cpus;
+        if (node_conf.max_threads <= 0) node_conf.max_threads = node_conf.min_threads * 2;
+
+        thread_pool_t* pool = thread_pool_create_ex(&node_conf);
+        if (!pool) {
+            numa_thread_pool_destroy(npool, 1);
+            cpu_topology_free(&topo);
+            return NULL;
+        }
+        npool->nodes[npool->num_nodes] = topo.nodes[i];
+        npool->pools[npool->num_nodes] = pool;
+        npool->num_nodes++;
+    }
+    cpu_topology_free(&topo);
+    printf("numa thread pool created: %d nodes\n", npool->num_nodes);
+    return npool;
+}
+
+/**
+ * @brief 选择子线程池编号（实现）
+ */
+int numa_thread_pool_pick(numa_thread_pool_t* npool, int hint) {
+    if (hint >= 0) return hint % npool->num_nodes;
+    int node = cpu_current_node();
+    for (int i = 0; i < npool->num_nodes; i++) {
+        if (npool->nodes[i] == node) return i;
+    }
+    return (int)(__atomic_fetch_add(&npool->next, 1, __ATOMIC_RELAXED) % (unsigned)npool->num_nodes);
+}
+
+/**
+ * @brief 销毁线程池组（实现）
+ */
+void numa_thread_pool_destroy(numa_thread_pool_t* npool, int force) {
+    if (!npool) return;
+    for (int i = 0; i < npool->num_nodes; i++) {
+        thread_pool_destroy(npool->pools[i], force);
+    }
+    free(npool);
+}
+
+// ====================== 命名子线程池实现 ======================
+/**
+ * @brief 登记子线程池（名称查重、截断到 THREAD_POOL_NAME_LEN-1）
+ * @return 子线程池编号，失败返回-1
+ */
+static int thread_pool_group_register(thread_pool_group_t* group, const char* name, thread_pool_t* pool, int owned) {
+    if (group->count >= THREAD_POOL_GROUP_MAX) {
+        fprintf(stderr, "thread pool group full (max %d)\n", THREAD_POOL_GROUP_MAX);
+        return -1;
+    }
+    int index = group->count++;
+    snprintf(group->names[index], THREAD_POOL_NAME_LEN, "%s", name);
+    group->pools[index] = pool;
+    group->owned[index] = owned;
+    return index;
+}
+
+/**
+ * @brief 创建空的线程池组（实现）
+ */
+thread_pool_group_t* thread_pool_group_create(void) {
+    thread_pool_group_t* group = (thread_pool_group_t*)calloc(1, sizeof(thread_pool_group_t));
+    if (!group) {
+        perror("malloc thread_pool_group failed");
+    }
+    return group;
+}
+
+/**
+ * @brief 新建命名子线程池（实现）
+ */
+int thread_pool_group_add(thread_pool_group_t* group, const char* name, const thread_pool_config_t* cfg) {
+    if (!group || !name || thread_pool_group_find(group, name) >= 0 || group->count >= THREAD_POOL_GROUP_MAX) {
+        fprintf(stderr, "invalid sub-pool name or group full\n");
+        return -1;
+    }
+    thread_pool_t* pool = thread_pool_create_ex(cfg);
+    if (!pool) return -1;
+    printf("sub-pool \"%s\" created\n", name);
+    return thread_pool_group_register(group, name, pool, 1);
+}
+
+/**
+ * @brief 登记已有线程池（实现）
+ */
+int thread_pool_group_attach(thread_pool_group_t* group, const char* name, thread_pool_t* pool) {
+    if (!group || !name || !pool || thread_pool_group_find(group, name) >= 0) {
+        fprintf(stderr, "invalid param or duplicated sub-pool name\n");
+        return -1;
+    }
+    return thread_pool_group_register(group, name, pool, 0);
+}
+
+/**
+ * @brief 按名称查找子线程池（实现）
+ */
+int thread_pool_group_find(thread_pool_group_t* group, const char* name) {
+    if (!group || !name) return -1;
+    for (int i = 0; i < group->count; i++) {
+        if (strncmp(group->names[i], name, THREAD_POOL_NAME_LEN - 1) == 0) return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief 向子线程池提交任务（实现）
+ */
+int thread_pool_group_submit(thread_pool_group_t* group, int index, void (*func)(void*), void* arg) {
+    if (!group || index < 0 || index >= group->count) {
+        fprintf(stderr, "invalid sub-pool index %d\n", index);
+        return THREAD_POOL_ERROR;
+    }
+    return thread_pool_add_task(group->pools[index], func, arg);
+}
+
+/**
+ * @brief 获取子线程池统计（实现）
+ */
+int thread_pool_group_get_stats(thread_pool_group_t* group, int index, thread_pool_group_stats_t* stats) {
+    if (!group || !stats || index < 0 || index >= group->count) return -1;
+    thread_pool_t* pool = group->pools[index];
+    memset(stats, 0, sizeof(*stats));
+    stats->name = group->names[index];
+    stats->threads = __atomic_load_n(&pool->thread_num, __ATOMIC_RELAXED);
+    for (int lane = 0; lane < THREAD_POOL_LANES; lane++) {
+        thread_pool_lane_stats_t ls;
+        thread_pool_get_lane_stats(pool, lane, &ls);
+        stats->depth += ls.depth;
+        stats->submitted += ls.submitted;
+        stats->executed += ls.executed;
+        stats->rejected += ls.rejected;
+    }
+    thread_pool_telemetry_t tm;
+    if (thread_pool_get_telemetry(pool, &tm) == 0) {
+        stats->wait_p99_ns = thread_pool_hist_percentile(tm.wait_hist, 0.99);
+        stats->run_p99_ns = thread_pool_hist_percentile(tm.run_hist, 0.99);
+    }
+    return 0;
+}
+
+/**
+ * @brief 输出所有子线程池的统计（实现）
+ */
+void thread_pool_group_report(thread_pool_group_t* group, FILE* out) {
+    if (!group || !out) return;
+    for (int i = 0; i < group->count; i++) {
+        thread_pool_group_stats_t st;
+        thread_pool_group_get_stats(group, i, &st);
+        fprintf(out, "[pool %-12s] threads %d, depth %zu, submitted %llu, executed %llu, rejected %llu, "
+                     "wait p99 %.1f us, run p99 %.1f us\n",
+                st.name, st.threads, st.depth,
+                (unsigned long long)st.submitted, (unsigned long long)st.executed,
+                (unsigned long long)st.rejected,
+                st.wait_p99_ns / 1000.0, st.run_p99_ns / 1000.0);
+    }
+}
+
+/**
+ * @brief 销毁线程池组（实现）
+ * @note 逆序销毁：后登记的子线程池（通常是把结果投递回前面子线程池的阻塞型任务）先停止
+ */
+void thread_pool_group_destroy(thread_pool_group_t* group, int force) {
+    if (!group) return;
+    for (int i = group->count - 1; i >= 0; i--) {
+        if (group->owned[i]) {
+            thread_pool_destroy(group->pools[i], force);
+        }
+    }
+    free(group);
 }
 
-#endif // _THREAD_POOL_H_
\ No newline at end of file
+#endif // _THREAD_POOL_H_
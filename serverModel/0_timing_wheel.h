@@ -0,0 +1,219 @@
+#ifndef _TIMING_WHEEL_H_
+#define _TIMING_WHEEL_H_
+
+// 哈希时间轮（hashed timing wheel）：连接空闲 / 读 / 写超时
+// 定时器节点嵌入在使用者的结构体中（侵入式双向链表），添加 / 重置 / 取消都是O(1)且不分配内存；
+// 由事件循环驱动：epoll_wait 的超时取 timing_wheel_next_timeout()，返回后调用 timing_wheel_advance()
+// 单线程使用（每个Reactor一个时间轮），不加锁
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+// ====================== 配置参数 ======================
+#define WHEEL_DEFAULT_SLOTS 4096    // 默认槽数（2的幂）
+#define WHEEL_DEFAULT_TICK_MS 100   // 默认tick长度（超时精度，毫秒）
+
+// ====================== 结构体 ======================
+/**
+ * @brief 定时器节点（嵌入在连接等结构体中）
+ * @note expire 是真正的到期tick；slot_tick 是节点当前所在槽对应的tick。
+ *       推迟到期时间只更新 expire（惰性重置），节点留在原槽，时间轮转到该槽时再移到新槽
+ */
+typedef struct wheel_timer_s {
+    struct wheel_timer_s* prev;
+    struct wheel_timer_s* next;
+    uint64_t expire;            // 到期tick
+    uint64_t slot_tick;         // 所在槽对应的tick（不晚于expire）
+    void (*func)(void*);        // 到期回调（可以在回调中重新设置或销毁该定时器）
+    void* arg;
+} wheel_timer_t;
+
+/**
+ * @brief 时间轮
+ * @note 每个槽是一个带哨兵的循环双向链表；tick 以 start_ms 为零点
+ */
+typedef struct timing_wheel_s {
+    wheel_timer_t* slots;       // 槽哨兵数组
+    size_t mask;                // 槽数 - 1
+    uint64_t tick_ms;           // tick长度（毫秒）
+    uint64_t start_ms;          // 创建时刻（单调时钟，毫秒）
+    uint64_t current;           // 下一个要处理的tick
+    size_t count;               // 已设置的定时器数
+    uint64_t fired;             // 累计到期次数
+} timing_wheel_t;
+
+// ====================== 内部函数 ======================
+/**
+ * @brief 单调时钟（毫秒，粗粒度时钟，读取开销低）
+ */
+static inline uint64_t timing_wheel_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (uint64_t)ts.tv_sec * 1000ull + (uint64_t)ts.tv_nsec / 1000000ull;
+}
+
+static inline void wheel_list_init(wheel_timer_t* head) {
+    head->prev = head->next = head;
+}
+
+static inline void wheel_list_unlink(wheel_timer_t* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = node->next = NULL;
+}
+
+static inline void wheel_list_push(wheel_timer_t* head, wheel_timer_t* node) {
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+/**
+ * @brief 把节点挂到 tick 对应的槽
+ */
+static inline void timing_wheel_link(timing_wheel_t* wheel, wheel_timer_t* timer, uint64_t tick) {
+    timer->slot_tick = tick;
+    wheel_list_push(&wheel->slots[tick & wheel->mask], timer);
+}
+
+// ====================== 接口 ======================
+/**
+ * @brief 初始化时间轮
+ * @param slots 槽数（向上取整到2的幂，0表示默认）
+ * @param tick_ms tick长度（0表示默认）
+ * @return 成功返回0，失败返回-1
+ * @note 槽数 × tick 是一圈的时长，超时短于一圈时每个定时器在到期前只被访问一次
+ */
+static inline int timing_wheel_init(timing_wheel_t* wheel, size_t slots, uint64_t tick_ms) {
+    size_t n = 1;
+    if (slots == 0) slots = WHEEL_DEFAULT_SLOTS;
+    while (n < slots) n <<= 1;
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->slots = (wheel_timer_t*)malloc(sizeof(wheel_timer_t) * n);
+    if (!wheel->slots) return -1;
+    for (size_t i = 0; i < n; i++) wheel_list_init(&wheel->slots[i]);
+    wheel->mask = n - 1;
+    wheel->tick_ms = tick_ms ? tick_ms : WHEEL_DEFAULT_TICK_MS;
+    wheel->start_ms = timing_wheel_now_ms();
+    return 0;
+}
+
+/**
+ * @brief 释放槽数组（不会触发仍在时间轮中的定时器）
+ */
+static inline void timing_wheel_destroy(timing_wheel_t* wheel) {
+    free(wheel->slots);
+    wheel->slots = NULL;
+    wheel->count = 0;
+}
+
+/**
+ * @brief 初始化定时器节点（未设置状态）
+ */
+static inline void wheel_timer_init(wheel_timer_t* timer, void (*func)(void*), void* arg) {
+    memset(timer, 0, sizeof(*timer));
+    timer->func = func;
+    timer->arg = arg;
+}
+
+/**
+ * @brief 定时器是否已设置
+ */
+static inline int wheel_timer_pending(const wheel_timer_t* timer) {
+    return timer->next != NULL;
+}
+
+/**
+ * @brief 设置或重置定时器：timeout_ms 后到期
+ * @note 已设置且新的到期时间不早于所在槽时，只更新 expire，不做链表操作（连接每次活动都会重置，
+ *       这是最常见的路径）；否则从原槽摘下挂到新槽，都是O(1)
+ */
+static inline void timing_wheel_set(timing_wheel_t* wheel, wheel_timer_t* timer, uint64_t timeout_ms) {
+    uint64_t ticks = (timeout_ms + wheel->tick_ms - 1) / wheel->tick_ms;
+    uint64_t expire = wheel->current + (ticks ? ticks : 1);
+    if (wheel_timer_pending(timer)) {
+        if (expire >= timer->slot_tick) {
+            timer->expire = expire;
+            return;
+        }
+        wheel_list_unlink(timer);
+    } else {
+        wheel->count++;
+    }
+    timer->expire = expire;
+    timing_wheel_link(wheel, timer, expire);
+}
+
+/**
+ * @brief 取消定时器（未设置时无操作）
+ */
+static inline void timing_wheel_cancel(timing_wheel_t* wheel, wheel_timer_t* timer) {
+    if (!wheel_timer_pending(timer)) return;
+    wheel_list_unlink(timer);
+    wheel->count--;
+}
+
+/**
+ * @brief 推进时间轮到 now_ms，触发所有到期的定时器
+ * @return 本次触发的定时器数
+ * @note 落后超过一圈时只需扫描一圈：每个槽都会被访问，所有到期节点都会被触发
+ */
+static inline size_t timing_wheel_advance(timing_wheel_t* wheel, uint64_t now_ms) {
+    if (now_ms < wheel->start_ms) return 0;
+    uint64_t target = (now_ms - wheel->start_ms) / wheel->tick_ms;
+    if (target < wheel->current) return 0;
+    if (wheel->count == 0) {
+        wheel->current = target + 1;
+        return 0;
+    }
+    uint64_t last = target;
+    if (last - wheel->current > wheel->mask) last = wheel->current + wheel->mask;
+
+    size_t fired = 0;
+    wheel_timer_t pending;
+    for (uint64_t tick = wheel->current; tick <= last && wheel->count > 0; tick++) {
+        wheel_timer_t* slot = &wheel->slots[tick & wheel->mask];
+        if (slot->next == slot) continue;
+        // 整个槽先摘到临时链表上，回调中重新设置到同一槽的节点不会在本轮再次被处理
+        wheel_list_init(&pending);
+        pending.next = slot->next;
+        pending.prev = slot->prev;
+        pending.next->prev = &pending;
+        pending.prev->next = &pending;
+        wheel_list_init(slot);
+        // 先推进current，回调中设置的新定时器从下一个tick开始计时
+        wheel->current = tick + 1;
+        while (pending.next != &pending) {
+            wheel_timer_t* timer = pending.next;
+            wheel_list_unlink(timer);
+            if (timer->expire > target) {
+                // 惰性重置过的节点：移到真正到期的槽
+                timing_wheel_link(wheel, timer, timer->expire);
+                continue;
+            }
+            wheel->count--;
+            wheel->fired++;
+            fired++;
+            timer->func(timer->arg); // 可能在回调中释放timer所在的结构体
+        }
+    }
+    wheel->current = target + 1;
+    return fired;
+}
+
+/**
+ * @brief epoll_wait 可用的超时（毫秒）：到下一个tick的时间，没有定时器时返回 max_ms
+ * @param max_ms 上限（-1表示无定时器时无限等待）
+ */
+static inline int timing_wheel_next_timeout(const timing_wheel_t* wheel, uint64_t now_ms, int max_ms) {
+    if (wheel->count == 0) return max_ms;
+    uint64_t next_ms = wheel->start_ms + wheel->current * wheel->tick_ms;
+    int timeout = next_ms > now_ms ? (int)(next_ms - now_ms) : 0;
+    return (max_ms >= 0 && timeout > max_ms) ? max_ms : timeout;
+}
+
+#endif // _TIMING_WHEEL_H_
@@ -1,15 +1,10 @@
 #include <iostream>
-#include <mutex>
 #include <thread>
-#include <queue>
-#include <functional>
-#include <atomic>
-#include <condition_variable>
-#include <vector>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include "0_threadPool.hpp"
 
 const uint16_t Port = 13145;
 const uint16_t BufferSize = 1024;
@@ -19,72 +14,6 @@ struct ClientInfo {
     sockaddr_in clientAddr;
 };
 
-class ThreadPool {
-private:
-    std::mutex mutex;
-    std::atomic<bool> stopFlag;
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> taskQueue;
-    std::condition_variable notFull;
-    std::condition_variable notEmpty;
-    size_t threadsSize, maxQueueSize;
-public:
-    ThreadPool(size_t threadsSize, size_t maxQueueSize = 1024) 
-        : threadsSize(threadsSize), maxQueueSize(maxQueueSize),stopFlag(false) {
-        for (size_t i = 0; i < threadsSize; ++i) {
-            workers.emplace_back([this]{this->workLoop();});
-        }
-        printf("ThreadPool init completed.\n");
-    }
-    ~ThreadPool() {
-        shudown();
-    }
-
-    void submit(std::function<void()> task) {
-        std::unique_lock<std::mutex> lock(mutex);
-        notFull.wait(lock,[this]{return stopFlag || taskQueue.size() < maxQueueSize;});
-        if (stopFlag) return;
-        taskQueue.push(std::move(task));
-        notEmpty.notify_one();
-    }
-
-    void shudown() {
-        {
-            std::lock_guard<std::mutex> lock(mutex);
-            if (stopFlag) return;
-            stopFlag.store(true);
-        }
-        notFull.notify_all();
-        notEmpty.notify_all();
-        for (auto& t : workers) {
-            if(t.joinable()) {
-                t.join();
-            }
-        }
-    }
-
-private:
-    void workLoop() {
-        while(true) {
-            std::function<void()> task;
-            {
-                std::unique_lock<std::mutex> lock(mutex);
-                notEmpty.wait(lock, [this]{return stopFlag || !taskQueue.empty();});
-                if (stopFlag && taskQueue.empty()) break;
-                task = std::move(taskQueue.front());
-                taskQueue.pop();
-                notFull.notify_one();
-            }
-            try {
-                task();
-            }
-            catch(const std::exception& e) {
-                std::cerr << e.what() << '\n';
-            }
-        }
-    }
-};
-
 void handleClientComm(int clientFd, sockaddr_in clientAddr) {
     char ipStr[INET_ADDRSTRLEN];
     inet_ntop(AF_INET, &clientAddr.sin_addr, ipStr, INET_ADDRSTRLEN);
@@ -149,8 +78,9 @@ int main() {
      size_t numCores = std::thread::hardware_concurrency();
     if (numCores == 0) numCores = 4;
     size_t poolSize = numCores * 2;
-    //ThreadPool threadPool(poolSize, 512);
-    ThreadPool threadPool(2, 512);
+    // 弹性线程池：常驻2个线程，连接排队超过5ms时扩容，最多poolSize个；空闲30秒回收
+    ThreadPool threadPool(ElasticOptions{2, poolSize, std::chrono::seconds(30),
+                                         std::chrono::milliseconds(5)}, 512);
 
     while(true) {
         sockaddr_in clientAddr;
@@ -1,9 +1,38 @@
 // reactor_epoll_server.c
-// 单线程 Reactor 示例（基于 epoll），用 C 实现
-// 编译: gcc -std=c11 -O2 3_reactor_epoll_server.c -o server
-// 运行: ./server [port]
+// Reactor 示例（基于 epoll），用 C 实现：单 Reactor，或每线程一个 Reactor（one loop per thread）
+// 编译: gcc -std=c11 -O2 3_reactor_epoll_server.c -o server -pthread
+// 运行: ./server [port] [reactors] [log] [dispatch] [scan]
 // 说明: 简单 echo 服务，演示 Reactor 模式与 epoll 使用
-
+//  - reactors = 1（默认）：主线程运行唯一的 reactor_loop，与原来的单 Reactor 相同
+//  - reactors = N：启动 N 个 Reactor 线程，每个线程有自己的 epoll_fd、连接集合和设置了
+//    SO_REUSEPORT 的监听 socket，由内核按四元组哈希把新连接分散到各监听 socket 的 accept 队列；
+//    连接从 accept 到关闭只在一个线程内处理，线程之间没有共享的可变状态（不需要加锁）
+//  - dispatch = 1/2（主从 Reactor）：主线程的主 Reactor 只监听并 accept，新连接按轮询（1）或
+//    最少连接（2）交给 N 个子 Reactor 线程；每个子 Reactor 有一个 SPSC 无锁环形队列（主 Reactor 是
+//    唯一生产者）和一个 eventfd，主 Reactor 每批 accept 结束后对收到新连接的子 Reactor 各写一次
+//    eventfd 唤醒。负载均衡不依赖内核的四元组哈希，突发到达的连接也不会集中到一个核上
+//  - 多核时第 i 个 Reactor 按 AFFINITY_SCATTER 顺序绑核（先跨节点、再跨物理核，最后才用超线程）
+//  - log = 0 时关闭每次连接/请求的打印（压测时 stdout 的 FILE 锁会成为各线程共享的竞争点）
+//  - 超时：每个Reactor一个哈希时间轮（0_timing_wheel.h），由 epoll_wait 的超时驱动。每个连接一个嵌入的
+//    定时器，按连接状态切换期限：accept后等待第一个请求（读超时）、响应未写完（写超时）、
+//    响应写完等待下一个请求（空闲超时）。到期关闭连接，归还连接槽
+//  - 读写缓冲区是可增长的环形缓冲区（0_iobuf.h）：readv 读入（空闲段 + 栈上溢出缓冲区），writev 写出，
+//    部分写只移动读位置，不再memmove；每次读到EAGAIN为止的数据作为一个响应回显，不再按4KB截断
+//  - 连接结构体放在按fd索引的连接表中（0_conn_table.h，所有Reactor共享），启动时一次分配；
+//    连接关闭后缓冲区留在槽中给复用该fd的下一个连接，稳态下建立/关闭连接不调用malloc/free。
+//    epoll事件登记 代数<<32 | fd：连接在本轮事件处理前已关闭（超时、同批的其他事件）时，残留事件被识别并丢弃
+//  - 每个连接记录已注册的事件（interest），只有变化时才调用 epoll_ctl(MOD)；响应生成后先在读事件中直接写，
+//    只有写到EAGAIN才注册EPOLLOUT。一次请求/响应通常只需要 epoll_wait + read×2 + writev，不再有两次MOD
+//  - 请求由增量式HTTP/1.1解析器（0_http_parser.h）切分：被拆成多次读入的请求等到完整再回应，
+//    一次读入的多个流水线请求按顺序各回应一次（回显整个请求）；Connection: close / HTTP/1.0、非法请求、
+//    对端关闭写方向时，回应完已收到的请求后关闭连接
+//  - 写缓冲区是待发送队列（0_outq.h）：响应头写入内联缓冲区，主体作为单独的iovec一起writev。
+//    GET /cached 返回启动时生成的共享主体（所有连接、所有Reactor引用同一份内存，只增减引用计数）；
+//    回显不小于 ECHO_ADOPT_MIN 的请求时把读缓冲区整块转成共享主体，大请求体不再拷贝进写缓冲区
+//  - scan 选择解析器的扫描内核（0_http_scan.h，找请求边界和扫描方法名/头部名）：0 自动（CPU支持的最高一档，默认）、
+//    1 标量、2 SSE4.2、3 AVX2；超过CPU支持的档位时自动降级，启动时打印实际使用的一档
+
+#define _GNU_SOURCE // 绑核（CPU_SET等）需要，必须在所有系统头文件之前
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -15,60 +44,192 @@
 #include <pthread.h>
 #include <signal.h>
 #include <errno.h>
+#include <sys/eventfd.h>
+#include "0_cpu_topology.h"
+#include "0_timing_wheel.h"
+#include "0_iobuf.h"
+#include "0_conn_table.h"
+#include "0_http_parser.h"
+#include "0_outq.h"
 
 #define DEAFULT_PORT 13145
 #define MAX_EVENTS 1024
-#define BUFFER_SIZE 4096
+#define BUFFER_SIZE 4096 // 读写缓冲区的初始容量（按需增长）
+#define INPUT_MAX_SIZE IOBUF_DEFAULT_MAX // 读缓冲区上限，达到后先回写再继续读
+#define OUTPUT_HIGH_WATER INPUT_MAX_SIZE // 待发送数据达到此值时暂停处理请求，先回写
+#define OUTPUT_MAX_SIZE (OUTPUT_HIGH_WATER + INPUT_MAX_SIZE + BUFFER_SIZE) // 写缓冲区上限：高水位之后最多再放入一个
+                                                                      // 完整的请求（不超过读缓冲区）和响应头
+#define RETAIN_BUFFER_SIZE 65536 // 连接关闭后留在槽中复用的缓冲区容量上限，更大的释放
+#define ECHO_ADOPT_MIN RETAIN_BUFFER_SIZE // 回显的请求不小于此长度时把读缓冲区整块转成共享主体（不拷贝）
+#define CACHED_PATH "/cached" // GET 这个路径返回启动时生成的共享主体
+#define CACHED_BODY_SIZE (256 * 1024)
+#define MAX_REACTORS 256
+#define HANDOFF_QUEUE_SIZE 4096 // 每个子Reactor的连接移交队列容量（2的幂）
+#define CACHE_LINE_SIZE 64
+#define READ_TIMEOUT_MS 10000   // accept后收到第一个请求的期限
+#define WRITE_TIMEOUT_MS 10000  // 响应写完的期限（对端不读时）
+#define IDLE_TIMEOUT_MS 60000   // keep-alive连接两个请求之间的最长空闲
+#define WHEEL_TICK_MS 100       // 时间轮精度（4096槽 × 100ms，一圈约410秒，长于所有超时）
+
+/**
+ * @brief 连接分发方式
+ */
+typedef enum {
+    DISPATCH_REUSEPORT = 0,     // 每个Reactor各自监听（SO_REUSEPORT），由内核分发
+    DISPATCH_ROUND_ROBIN = 1,   // 主Reactor accept后轮询交给子Reactor
+    DISPATCH_LEAST_LOADED = 2,  // 主Reactor accept后交给当前连接数（含排队中）最少的子Reactor
+} dispatch_mode_t;
 
 volatile int global_running = 1;
+static int g_log = 1; // 启动后只读
+static conn_table_t g_conns; // 所有Reactor共享的连接表（每个槽只由持有该fd的Reactor访问）
+static shared_body_t* g_cached_body; // GET /cached 的响应主体（启动后只读，引用计数原子增减）
 
 void signal_handler(int sig) {
-    global_running = 0;
+    __atomic_store_n(&global_running, 0, __ATOMIC_RELAXED);
     printf("\nSignal %d received, shutting down...\n", sig);
 }
 struct connection_s;   // 前置声明
+struct reactor_s;
 typedef struct connection_s{
+    conn_slot_t slot; // 连接表槽头部（代数），必须是第一个成员
     int fd;
     struct sockaddr_in addr;
     void (*read_handler)(int, struct connection_s*); // 读事件处理函数指针
     void (*write_handler)(int, struct connection_s*); // 写事件处理函数指针
-    char* wbuffer; // 写缓冲区
-    size_t wbuffer_size; // 写缓冲区大小
-    size_t wbuffer_sent; // 已发送数据大小
-    char* read_buffer; // 读缓冲区
-    size_t read_buffer_size; // 读缓冲区大小
+    iobuf_t in; // 读缓冲区
+    outq_t out; // 待发送队列（内联的响应头 + 共享主体的引用）
+    struct reactor_s* reactor; // 所属Reactor（连接只在该Reactor线程内访问）
+    struct connection_s* prev; // Reactor连接集合（双向链表）
+    struct connection_s* next;
+    wheel_timer_t timer; // 读/写/空闲超时（嵌入，重置不分配内存）
+    uint32_t events; // 已注册到epoll的事件（只在变化时 epoll_ctl MOD）
+    http_parser_t parser; // 当前请求的解析状态（跨多次读入保留）
+    int closing; // 写缓冲区发完后关闭连接（不再处理新的请求）
 } connection_t;
 
+/**
+ * @brief 主Reactor移交给子Reactor的新连接
+ */
+typedef struct handoff_s {
+    int fd;
+    struct sockaddr_in addr;
+} handoff_t;
+
+/**
+ * @brief 单生产者单消费者环形队列（主Reactor入队，子Reactor出队）
+ * @note head/tail 单调递增，分别只由消费者/生产者写，放在不同缓存行上避免伪共享
+ */
+typedef struct handoff_queue_s {
+    _Alignas(CACHE_LINE_SIZE) size_t head;  // 消费者位置
+    _Alignas(CACHE_LINE_SIZE) size_t tail;  // 生产者位置
+    int wake_pending;                       // 本批accept中有新连接、尚未写eventfd（只由生产者访问）
+    _Alignas(CACHE_LINE_SIZE) handoff_t slots[HANDOFF_QUEUE_SIZE];
+} handoff_queue_t;
+
+/**
+ * @brief 单个Reactor：一个线程、一个epoll实例，以及它负责的全部连接
+ * @note SO_REUSEPORT模式下每个Reactor有自己的监听socket；主从模式下只有主Reactor监听，
+ *       子Reactor通过 handoff 队列 + wake_fd(eventfd) 接收新连接
+ */
+typedef struct reactor_s {
+    int id;
+    int cpu;                    // 绑定的CPU（-1表示不绑核）
+    int listen_fd;              // -1表示不监听（子Reactor）
+    int epoll_fd;
+    connection_t* listen_conn;
+    connection_t* conns;        // 本Reactor的客户端连接
+    unsigned long long accepted; // 统计只由本线程写，退出后由主线程读
+    unsigned long long requests;
+    unsigned long long timeouts;
+    unsigned long long stale;   // 丢弃的残留事件（连接已关闭或fd已被复用）
+    unsigned long long ctl_mods; // epoll_ctl(MOD) 次数
+    timing_wheel_t wheel;       // 本Reactor连接的超时
+    pthread_t thread;
+    // 主从模式
+    int wake_fd;                // 子Reactor：eventfd，-1表示未启用
+    connection_t* wake_conn;
+    handoff_queue_t* handoff;   // 子Reactor：新连接移交队列
+    int active;                 // 当前连接数（本线程写，主Reactor读，原子访问）
+    struct reactor_s* subs;     // 主Reactor：子Reactor数组（NULL表示自己处理accept到的连接）
+    int num_subs;
+    int dispatch;               // 主Reactor：dispatch_mode_t
+    int next_sub;               // 主Reactor：轮询位置
+    struct epoll_event events[MAX_EVENTS];
+} reactor_t;
+
 typedef enum {
     CONN_ACCEPTING,
     CONN_CLIENT,
-}connection_type_t; 
-
-connection_t* connection_create(int fd, struct sockaddr_in addr,void (*read_handler)(int, connection_t*), void (*write_handler)(int, connection_t*), connection_type_t type) {
-    connection_t* conn = (connection_t*)malloc(sizeof(connection_t));
-    memset(conn, 0, sizeof(connection_t));
+}connection_type_t;
+
+void connection_timeout(void* arg);
+
+/**
+ * @brief 从连接表取用fd对应的槽并初始化
+ * @return 连接；fd超出连接表范围返回NULL（调用方关闭fd）
+ * @note 槽中上一个连接留下的缓冲区直接复用（已清空），第一次使用该槽时才初始化（仍延迟到第一次读写时分配）
+ */
+connection_t* connection_create(reactor_t* reactor, int fd, struct sockaddr_in addr,void (*read_handler)(int, connection_t*), void (*write_handler)(int, connection_t*), connection_type_t type) {
+    connection_t* conn = (connection_t*)conn_table_acquire(&g_conns, fd);
+    if (!conn) return NULL;
     conn->fd = fd;
     conn->addr = addr;
     conn->read_handler = read_handler;
     conn->write_handler = write_handler;
+    conn->reactor = reactor;
+    conn->prev = conn->next = NULL;
+    if (conn->in.init_cap == 0) {
+        iobuf_init(&conn->in, BUFFER_SIZE, INPUT_MAX_SIZE);
+        outq_init(&conn->out, BUFFER_SIZE, OUTPUT_MAX_SIZE);
+    }
     if (type == CONN_CLIENT) {
-        conn->read_buffer = (char*)malloc(BUFFER_SIZE);
-        conn->read_buffer_size = BUFFER_SIZE;
-        conn->wbuffer = (char*)malloc(BUFFER_SIZE);
-        conn->wbuffer_size = BUFFER_SIZE;
+        // 整个请求必须能放进读缓冲区
+        http_parser_init(&conn->parser, INPUT_MAX_SIZE - HTTP_MAX_HEADER_SIZE);
+        conn->closing = 0;
+        // 挂到Reactor的连接集合上，退出时统一关闭
+        conn->next = reactor->conns;
+        if (reactor->conns) reactor->conns->prev = conn;
+        reactor->conns = conn;
+        __atomic_add_fetch(&reactor->active, 1, __ATOMIC_RELAXED);
+        // 在收到第一个请求之前适用读超时
+        wheel_timer_init(&conn->timer, connection_timeout, conn);
+        timing_wheel_set(&reactor->wheel, &conn->timer, READ_TIMEOUT_MS);
     }
     return conn;
 }
 
 int connection_destroy(connection_t* conn) {
     if (!conn) return -1;
-    close(conn->fd);
-    if (conn->read_buffer) free(conn->read_buffer);
-    if (conn->wbuffer) free(conn->wbuffer);
-    free(conn);
+    reactor_t* reactor = conn->reactor;
+    if (reactor && (conn->prev || reactor->conns == conn)) { // 只有客户端连接在集合中
+        if (conn->prev) conn->prev->next = conn->next;
+        else reactor->conns = conn->next;
+        if (conn->next) conn->next->prev = conn->prev;
+        __atomic_sub_fetch(&reactor->active, 1, __ATOMIC_RELAXED);
+        timing_wheel_cancel(&reactor->wheel, &conn->timer);
+    }
+    int fd = conn->fd;
+    iobuf_recycle(&conn->in, RETAIN_BUFFER_SIZE);
+    outq_recycle(&conn->out, RETAIN_BUFFER_SIZE); // 释放还没发完的主体引用
+    conn_table_release(&g_conns, conn); // 先归还再关闭：fd关闭后可能立刻被其他Reactor复用
+    close(fd);
     return 0;
 }
 
+/**
+ * @brief 连接超时回调（时间轮到期时在Reactor线程中调用）：关闭连接
+ */
+void connection_timeout(void* arg) {
+    connection_t* conn = (connection_t*)arg;
+    conn->reactor->timeouts++;
+    if (g_log) {
+        printf("[%s:%d] timed out, fd=%d\n", inet_ntoa(conn->addr.sin_addr), ntohs(conn->addr.sin_port), conn->fd);
+    }
+    epoll_ctl(conn->reactor->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+    connection_destroy(conn);
+}
+
 int set_nonblocking(int fd) {
     int flags = fcntl(fd, F_GETFL, 0);
     if (flags == -1) return -1;
@@ -77,7 +238,8 @@ int set_nonblocking(int fd) {
 int epoll_add_fd(int epoll_fd, int fd, connection_t* conn, uint32_t events) {
     struct epoll_event ev;
     ev.events = events;
-    ev.data.ptr = conn;
+    ev.data.u64 = conn_table_key(conn);
+    conn->events = events;
     return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
 }
 int epoll_del_fd(int epoll_fd, int fd) {
@@ -86,41 +248,232 @@ int epoll_del_fd(int epoll_fd, int fd) {
 int epoll_mod_fd(int epoll_fd, int fd, connection_t* conn, uint32_t events) {
     struct epoll_event ev;
     ev.events = events;
-    ev.data.ptr = conn;
+    ev.data.u64 = conn_table_key(conn);
+    conn->events = events;
+    conn->reactor->ctl_mods++;
     return epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev);
 }
 
+/**
+ * @brief 设置连接关注的事件：与已注册的相同时不调用epoll_ctl
+ * @return 成功（或无需修改）返回0，失败返回-1
+ */
+int connection_set_events(int epoll_fd, connection_t* conn, uint32_t events) {
+    if (conn->events == events) return 0;
+    return epoll_mod_fd(epoll_fd, conn->fd, conn, events);
+}
+
 // 前向声明
 void accept_handler(int epoll_fd, connection_t* accept_conn);
+void handoff_handler(int epoll_fd, connection_t* wake_conn);
 void read_handler(int epoll_fd, connection_t* conn);
 void write_handler(int epoll_fd, connection_t* conn);
 
-void build_http_response(connection_t* conn, const char* body)
+// ====================== 主从Reactor：连接移交 ======================
+/**
+ * @brief 入队（仅主Reactor调用）
+ * @return 成功返回0，队列满返回-1
+ */
+int handoff_push(handoff_queue_t* q, int fd, struct sockaddr_in addr) {
+    size_t tail = q->tail;
+    if (tail - __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) >= HANDOFF_QUEUE_SIZE) return -1;
+    q->slots[tail & (HANDOFF_QUEUE_SIZE - 1)].fd = fd;
+    q->slots[tail & (HANDOFF_QUEUE_SIZE - 1)].addr = addr;
+    __atomic_store_n(&q->tail, tail + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * @brief 出队（仅子Reactor调用）
+ * @return 成功返回0，队列空返回-1
+ */
+int handoff_pop(handoff_queue_t* q, handoff_t* out) {
+    size_t head = q->head;
+    if (head == __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE)) return -1;
+    *out = q->slots[head & (HANDOFF_QUEUE_SIZE - 1)];
+    __atomic_store_n(&q->head, head + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * @brief 子Reactor的负载：已建立的连接 + 还在移交队列中的连接
+ */
+size_t reactor_load(reactor_t* sub) {
+    handoff_queue_t* q = sub->handoff;
+    size_t queued = q->tail - __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+    return (size_t)__atomic_load_n(&sub->active, __ATOMIC_RELAXED) + queued;
+}
+
+/**
+ * @brief 主Reactor把新连接交给一个子Reactor（轮询或最少连接，队列满时换下一个）
+ * @return 成功返回0，所有子Reactor的队列都满返回-1（调用方关闭连接）
+ */
+int dispatch_connection(reactor_t* main_reactor, int fd, struct sockaddr_in addr) {
+    int n = main_reactor->num_subs;
+    int start = main_reactor->next_sub;
+    if (main_reactor->dispatch == DISPATCH_LEAST_LOADED) {
+        // 从轮询位置开始找，负载相同的子Reactor之间仍然轮转
+        size_t best_load = (size_t)-1;
+        for (int i = 0; i < n; i++) {
+            int idx = (main_reactor->next_sub + i) % n;
+            size_t load = reactor_load(&main_reactor->subs[idx]);
+            if (load < best_load) {
+                best_load = load;
+                start = idx;
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        reactor_t* sub = &main_reactor->subs[(start + i) % n];
+        if (handoff_push(sub->handoff, fd, addr) == 0) {
+            sub->handoff->wake_pending = 1;
+            main_reactor->next_sub = (start + i + 1) % n;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 唤醒本批收到新连接的子Reactor（每个子Reactor一次eventfd写）
+ */
+void dispatch_flush(reactor_t* main_reactor) {
+    uint64_t one = 1;
+    for (int i = 0; i < main_reactor->num_subs; i++) {
+        reactor_t* sub = &main_reactor->subs[i];
+        if (!sub->handoff->wake_pending) continue;
+        sub->handoff->wake_pending = 0;
+        if (write(sub->wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            perror("write eventfd");
+        }
+    }
+}
+
+/**
+ * @brief 子Reactor：eventfd可读时取出移交队列中的全部连接并注册到自己的epoll
+ * @note 先清eventfd计数再取队列：之后入队的连接一定伴随一次新的eventfd写，不会丢失唤醒
+ */
+void handoff_handler(int epoll_fd, connection_t* wake_conn) {
+    reactor_t* reactor = wake_conn->reactor;
+    uint64_t count;
+    if (read(reactor->wake_fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        perror("read eventfd");
+    }
+    handoff_t h;
+    while (handoff_pop(reactor->handoff, &h) == 0) {
+        connection_t* conn = connection_create(reactor, h.fd, h.addr, read_handler, write_handler, CONN_CLIENT);
+        if (!conn) {
+            fprintf(stderr, "fd %d exceeds connection table, dropping\n", h.fd);
+            close(h.fd);
+            continue;
+        }
+        if (epoll_add_fd(epoll_fd, h.fd, conn, EPOLLIN | EPOLLET) < 0) {
+            perror("epoll_add_fd");
+            connection_destroy(conn);
+            continue;
+        }
+        reactor->accepted++;
+        if (g_log) {
+            printf("[reactor %d] Handed connection from %s:%d, fd=%d\n",
+                   reactor->id, inet_ntoa(h.addr.sin_addr), ntohs(h.addr.sin_port), h.fd);
+        }
+    }
+}
+
+// ====================== 事件处理 ======================
+
+/**
+ * @brief 生成HTTP响应放入待发送队列：响应头写入内联缓冲区，主体作为单独的段（不和响应头拼接）
+ * @param status 状态行（如 "200 OK"）
+ * @param body 非NULL时发送这个共享主体（只增加引用，不拷贝）
+ * @param echo_len body 为NULL时回显读缓冲区的前 echo_len 字节（从读缓冲区移出；较大时整块转成共享主体）
+ * @param keep_alive 0 时回应 Connection: close
+ * @return 成功返回0，写缓冲区超过上限返回-1
+ */
+int build_http_response(connection_t* conn, const char* status, shared_body_t* body, size_t echo_len, int keep_alive)
 {
     static const char* header_fmt =
-        "HTTP/1.1 200 OK\r\n"
+        "HTTP/1.1 %s\r\n"
         "Content-Type: text/plain\r\n"
         "Content-Length: %zu\r\n"
-        "Connection: keep-alive\r\n"
+        "Connection: %s\r\n"
         "\r\n";
 
-    size_t body_len = strlen(body);
+    char header[160];
+    size_t body_len = body ? body->len : echo_len;
+    int header_len = snprintf(header, sizeof(header), header_fmt, status, body_len,
+                              keep_alive ? "keep-alive" : "close");
 
-    int header_len = snprintf(conn->wbuffer, conn->wbuffer_size,
-                              header_fmt, body_len);
+    if (outq_append(&conn->out, header, header_len) < 0) return -1;
+    if (body) return outq_append_body(&conn->out, body, 0, body->len);
+    return outq_move_iobuf(&conn->out, &conn->in, echo_len, ECHO_ADOPT_MIN);
+}
 
-    memcpy(conn->wbuffer + header_len, body, body_len);
+/**
+ * @brief 解析读缓冲区中的请求，每个完整的请求生成一个响应放入写缓冲区（流水线请求按顺序回应）
+ * @return 成功返回0（不完整的请求留在读缓冲区，解析状态保存在连接中）；待发送数据达到高水位、
+ *         剩余请求暂不处理返回1（写完后继续）；写缓冲区放不下返回-1
+ * @note 非法请求回应错误状态码；它和 Connection: close 的请求之后的数据都丢弃，写完后关闭连接
+ */
+int connection_process(connection_t* conn) {
+    while (iobuf_size(&conn->in) > 0) {
+        if (conn->closing) {
+            iobuf_clear(&conn->in);
+            break;
+        }
+        if (outq_size(&conn->out) >= OUTPUT_HIGH_WATER) return 1;
+        struct iovec iov[2];
+        if (conn->parser.state == HTTP_STATE_HEAD && iobuf_readable_iov(&conn->in, iov) == 2) {
+            iobuf_linearize(&conn->in); // 头部需要连续：只有残留半个请求又绕回时才整理
+        }
+        if (iobuf_readable_iov(&conn->in, iov) == 0) break;
+        const char* base = (const char*)iov[0].iov_base;
+        ssize_t n = http_parser_execute(&conn->parser, base, iobuf_size(&conn->in));
+        if (n == 0 && iobuf_size(&conn->in) >= conn->in.max_cap) {
+            conn->parser.error = 413; // 读缓冲区满了请求仍不完整
+            n = -1;
+        }
+        if (n == 0) break;
+        if (n < 0) {
+            if (g_log) printf("[%s:%d]: bad request (%d)\n", inet_ntoa(conn->addr.sin_addr),
+                              ntohs(conn->addr.sin_port), conn->parser.error);
+            conn->closing = 1;
+            iobuf_clear(&conn->in);
+            return build_http_response(conn, http_status_text(conn->parser.error), NULL, 0, 0);
+        }
 
-    conn->wbuffer_sent = header_len + body_len;
+        http_request_t* req = &conn->parser.req;
+        conn->reactor->requests++;
+        if (g_log) {
+            printf("[%s:%d]: %.*s %.*s\n", inet_ntoa(conn->addr.sin_addr), ntohs(conn->addr.sin_port),
+                   (int)req->method.len, HTTP_SPAN_PTR(base, req->method),
+                   (int)req->target.len, HTTP_SPAN_PTR(base, req->target));
+        }
+        int keep_alive = req->keep_alive;
+        int ret;
+        if (http_span_equals(base, req->method, "GET") && req->target.len >= strlen(CACHED_PATH) &&
+            memcmp(HTTP_SPAN_PTR(base, req->target), CACHED_PATH, strlen(CACHED_PATH)) == 0) {
+            iobuf_consume(&conn->in, (size_t)n);
+            ret = build_http_response(conn, "200 OK", g_cached_body, 0, keep_alive);
+        } else {
+            // 回显整个请求（请求行 + 头部 + 主体）
+            ret = build_http_response(conn, "200 OK", NULL, (size_t)n, keep_alive);
+        }
+        if (ret < 0) return -1;
+        http_parser_reset(&conn->parser);
+        if (!keep_alive) conn->closing = 1;
+    }
+    return 0;
 }
 void accept_handler(int epoll_fd, connection_t* accept_conn) {
+    reactor_t* reactor = accept_conn->reactor;
     struct sockaddr_in client_addr;
     socklen_t client_len = sizeof(client_addr);
     int conn_fd;
     // 接受所有到来的连接 ET 模式
     while (1) {
         client_len = sizeof(client_addr);
-        if (conn_fd = accept(accept_conn->fd, (struct sockaddr*)&client_addr, &client_len) == -1) {
+        if ((conn_fd = accept(accept_conn->fd, (struct sockaddr*)&client_addr, &client_len)) == -1) {
             break; // 没有更多连接
         }
         if (set_nonblocking(conn_fd) < 0) {
@@ -129,101 +482,159 @@ void accept_handler(int epoll_fd, connection_t* accept_conn) {
             continue;
         }
 
-        connection_t* conn = connection_create(conn_fd, client_addr, read_handler, write_handler, CONN_CLIENT);
+        if (reactor->subs) {
+            // 主Reactor：只负责accept，连接交给子Reactor
+            if (dispatch_connection(reactor, conn_fd, client_addr) < 0) {
+                fprintf(stderr, "all handoff queues full, dropping fd=%d\n", conn_fd);
+                close(conn_fd);
+            }
+            continue;
+        }
+
+        connection_t* conn = connection_create(reactor, conn_fd, client_addr, read_handler, write_handler, CONN_CLIENT);
+        if (!conn) {
+            fprintf(stderr, "fd %d exceeds connection table, dropping\n", conn_fd);
+            close(conn_fd);
+            continue;
+        }
 
         if (epoll_add_fd(epoll_fd, conn_fd, conn, EPOLLIN | EPOLLET) < 0) {
             perror("epoll_add_fd");
             connection_destroy(conn);
             continue;
         }
-
-        printf("Accepted connection from %s:%d, fd=%d\n",
-               inet_ntoa(client_addr.sin_addr),
-               ntohs(client_addr.sin_port),
-               conn_fd);
+        reactor->accepted++;
+
+        if (g_log) {
+            printf("[reactor %d] Accepted connection from %s:%d, fd=%d\n",
+                   reactor->id,
+                   inet_ntoa(client_addr.sin_addr),
+                   ntohs(client_addr.sin_port),
+                   conn_fd);
+        }
     }
     if (errno != EAGAIN && errno != EWOULDBLOCK) {
         perror("accept");
     }
+    if (reactor->subs) dispatch_flush(reactor);
 }
-void read_handler(int epoll_fd, connection_t* conn) {
+/**
+ * @brief 发送写缓冲区中的数据，并按结果设置关注的事件和超时
+ * @return 写完返回1，写到EAGAIN返回0（已注册EPOLLOUT），出错或写完后按要求关闭返回-1（连接已释放）
+ * @note 读事件中生成响应后直接调用：对端正常读取时一次writev就写完，不需要注册EPOLLOUT再等一轮epoll_wait
+ */
+int connection_flush(int epoll_fd, connection_t* conn) {
     ssize_t n;
-    while (1) {
-        // memset(conn->read_buffer, 0, conn->read_buffer_size);
-        n = read(conn->fd, conn->read_buffer, conn->read_buffer_size-1);
+    while (outq_size(&conn->out) > 0) {
+        n = outq_write_fd(&conn->out, conn->fd); // 响应头和主体一次writev；部分写只移动位置
         if (n > 0) {
-            conn->read_buffer[n] = '\0';
-            printf("[%s:%d]: %s\n", inet_ntoa(conn->addr.sin_addr), ntohs(conn->addr.sin_port), conn->read_buffer);
-            // 回显数据
-            #if 1
-                build_http_response(conn, conn->read_buffer);
-            #else
-                memcpy(conn->wbuffer, conn->read_buffer, n);
-                conn->wbuffer_sent = n;
-            #endif
-            
-            epoll_mod_fd(epoll_fd, conn->fd, conn, EPOLLOUT | EPOLLET);
-        } else if (n == 0) {
-            // 客户端关闭连接
-            printf("Client disconnected, fd=%d\n", conn->fd);
-            epoll_del_fd(epoll_fd, conn->fd);
-            connection_destroy(conn);
-            return;
+            continue;
         } else {
             if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // 读完所有数据
-                break;
+                // 内核发送缓冲区满：暂停读，等待写事件
+                connection_set_events(epoll_fd, conn, EPOLLOUT | EPOLLET);
+                timing_wheel_set(&conn->reactor->wheel, &conn->timer, WRITE_TIMEOUT_MS);
+                return 0;
             } else {
-                perror("read");
+                perror("write");
                 epoll_del_fd(epoll_fd, conn->fd);
                 connection_destroy(conn);
-                return;
+                return -1;
             }
         }
     }
+    if (conn->closing) {
+        epoll_del_fd(epoll_fd, conn->fd);
+        connection_destroy(conn);
+        return -1;
+    }
+    // 写完：关注读事件（从EPOLLOUT切回时，EPOLL_CTL_MOD会重新检查就绪状态，留在内核中的数据会再次触发读事件）
+    connection_set_events(epoll_fd, conn, EPOLLIN | EPOLLET);
+    timing_wheel_set(&conn->reactor->wheel, &conn->timer, IDLE_TIMEOUT_MS);
+    return 1;
 }
-void write_handler(int epoll_fd, connection_t* conn) {
+
+void read_handler(int epoll_fd, connection_t* conn) {
+    char extra[IOBUF_READ_EXTRA]; // 读缓冲区空闲段不够时的溢出部分，一次readv读入更多数据
     ssize_t n;
-    while (conn->wbuffer_sent > 0) {
-        n = write(conn->fd, conn->wbuffer, conn->wbuffer_sent);
+    while (1) {
+        n = iobuf_read_fd(&conn->in, conn->fd, extra, sizeof(extra));
         if (n > 0) {
-            conn->wbuffer_sent -= n;
-            if (conn->wbuffer_sent > 0) {
-                memmove(conn->wbuffer, conn->wbuffer + n, conn->wbuffer_sent);
-            }
-        } else {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // 写缓冲区满，等待下一次写事件
-                break;
-            } else {
-                perror("write");
+            continue;
+        } else if (n == 0) {
+            // 客户端关闭连接（或只关闭了写方向）：回应已收到的完整请求，写完后关闭
+            if (g_log) printf("Client disconnected, fd=%d\n", conn->fd);
+            int backlog = connection_process(conn);
+            if (backlog < 0) {
                 epoll_del_fd(epoll_fd, conn->fd);
                 connection_destroy(conn);
                 return;
             }
+            if (!backlog) conn->closing = 1; // 还有暂停处理的请求时，写完后再读一次会再次得到EOF
+            connection_flush(epoll_fd, conn);
+            return;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+            perror("read");
+            epoll_del_fd(epoll_fd, conn->fd);
+            connection_destroy(conn);
+            return;
         }
+        // 读完所有数据，或读缓冲区已达上限
+        int full = errno == ENOBUFS;
+        int backlog = connection_process(conn);
+        if (backlog < 0) {
+            fprintf(stderr, "output buffer overflow, fd=%d\n", conn->fd);
+            epoll_del_fd(epoll_fd, conn->fd);
+            connection_destroy(conn);
+            return;
+        }
+        if (outq_size(&conn->out) == 0) {
+            // 请求还不完整（或没有数据）：等待后续数据，期间适用读超时
+            if (iobuf_size(&conn->in) > 0) timing_wheel_set(&conn->reactor->wheel, &conn->timer, READ_TIMEOUT_MS);
+            if (!full) return;
+            continue;
+        }
+        if (connection_flush(epoll_fd, conn) <= 0) return; // 等待写事件，或连接已释放
+        // 已经写完：读缓冲区曾满时内核中还有数据，而关注的事件没有变化（ET不会再通知），继续读；
+        // 因高水位暂停处理的请求也在这里接着处理
+        if (!full && !backlog) return;
     }
-    if (conn->wbuffer_sent == 0) {
-        // 切换回读事件
-        epoll_mod_fd(epoll_fd, conn->fd, conn, EPOLLIN | EPOLLET);
+}
+void write_handler(int epoll_fd, connection_t* conn) {
+    // 写完后读缓冲区中可能还有因高水位暂停处理的请求，它们不会再触发读事件
+    if (connection_flush(epoll_fd, conn) == 1 && iobuf_size(&conn->in) > 0) {
+        read_handler(epoll_fd, conn);
     }
 }
 
 
-void reactor_loop(int epoll_fd, struct epoll_event* events, int max_events) {
-    while (global_running) {
-        int n = epoll_wait(epoll_fd, events, max_events, 1000); // 1 秒超时
+void reactor_loop(reactor_t* reactor) {
+    int epoll_fd = reactor->epoll_fd;
+    struct epoll_event* events = reactor->events;
+    while (__atomic_load_n(&global_running, __ATOMIC_RELAXED)) {
+        // 最多等到时间轮的下一个tick（没有连接时1秒，用于检查退出标志）
+        int timeout = timing_wheel_next_timeout(&reactor->wheel, timing_wheel_now_ms(), 1000);
+        int n = epoll_wait(epoll_fd, events, MAX_EVENTS, timeout);
         if (n < 0) {
             if (errno == EINTR) continue; // 被信号中断，继续等待
             perror("epoll_wait");
             break;
         }
+        // 先处理到期的连接，再处理就绪事件（事件中重置的期限从最新的tick开始计算）
+        timing_wheel_advance(&reactor->wheel, timing_wheel_now_ms());
 
         for (int i = 0; i < n; i++) {
-            connection_t* conn = (connection_t*)events[i].data.ptr;
+            connection_t* conn = (connection_t*)conn_table_lookup(&g_conns, events[i].data.u64);
+            if (!conn) {
+                // 连接已在本轮之前关闭（超时 / 同批的其他事件），fd可能已被新连接复用
+                reactor->stale++;
+                continue;
+            }
             if (events[i].events & EPOLLIN) {
                 if (conn->read_handler) {
                     conn->read_handler(epoll_fd, conn);
+                    // read_handler 可能已释放连接（对端关闭 / 出错），此时不能再访问 conn
+                    continue;
                 }
             }
             if (events[i].events & EPOLLOUT) {
@@ -235,23 +646,25 @@ void reactor_loop(int epoll_fd, struct epoll_event* events, int max_events) {
     }
 }
 
-
-int main(int argc, char* argv[]) {
-    int port = DEAFULT_PORT;
-    if (argc >= 2) {
-        port = atoi(argv[1]);
-    }
-
-    // 注册信号处理函数
-    signal(SIGINT, signal_handler);
-
+/**
+ * @brief 创建非阻塞监听socket
+ * @param port 端口
+ * @param reuseport 是否设置 SO_REUSEPORT（多个Reactor各自监听同一端口）
+ * @return 监听fd，失败返回-1
+ */
+int create_listen_socket(int port, int reuseport) {
     int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
     if (listen_fd < 0) {
         perror("socket");
-        exit(EXIT_FAILURE);
+        return -1;
     }
     int opt = 1;
     setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (reuseport && setsockopt(listen_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        perror("setsockopt SO_REUSEPORT");
+        close(listen_fd);
+        return -1;
+    }
 
     struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
@@ -262,53 +675,277 @@ int main(int argc, char* argv[]) {
     if(set_nonblocking(listen_fd) < 0) {
         perror("set_nonblocking");
         close(listen_fd);
-        exit(EXIT_FAILURE);
+        return -1;
     }
 
     if (bind(listen_fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
         perror("bind");
         close(listen_fd);
-        exit(EXIT_FAILURE);
+        return -1;
     }
 
     if (listen(listen_fd, SOMAXCONN) < 0) {
         perror("listen");
         close(listen_fd);
-        exit(EXIT_FAILURE);
+        return -1;
+    }
+    return listen_fd;
+}
+
+/**
+ * @brief 初始化Reactor：epoll实例，以及监听socket（port < 0 时不监听，用于子Reactor）
+ * @return 成功返回0，失败返回-1（已释放本Reactor创建的资源）
+ */
+int reactor_init(reactor_t* reactor, int id, int port, int reuseport) {
+    memset(reactor, 0, sizeof(*reactor));
+    reactor->id = id;
+    reactor->cpu = -1;
+    reactor->listen_fd = -1;
+    reactor->wake_fd = -1;
+
+    if (timing_wheel_init(&reactor->wheel, WHEEL_DEFAULT_SLOTS, WHEEL_TICK_MS) < 0) {
+        perror("timing_wheel_init");
+        reactor->epoll_fd = -1;
+        return -1;
     }
 
     // 创建 epoll 实例
-    int epoll_fd = epoll_create1(0);
-    if (epoll_fd < 0) {
+    reactor->epoll_fd = epoll_create1(0);
+    if (reactor->epoll_fd < 0) {
         perror("epoll_create1");
-        close(listen_fd);
-        exit(EXIT_FAILURE);
+        timing_wheel_destroy(&reactor->wheel);
+        return -1;
+    }
+    if (port < 0) return 0;
+
+    reactor->listen_fd = create_listen_socket(port, reuseport);
+    if (reactor->listen_fd < 0) {
+        close(reactor->epoll_fd);
+        timing_wheel_destroy(&reactor->wheel);
+        return -1;
     }
 
     // 将监听套接字添加到 epoll 实例
-    connection_t* listen_conn = (connection_t*)malloc(sizeof(connection_t));
-    memset(listen_conn, 0, sizeof(connection_t));
-    listen_conn->fd = listen_fd;
-    listen_conn->read_handler = accept_handler;
-    listen_conn->write_handler = NULL;
+    reactor->listen_conn = connection_create(reactor, reactor->listen_fd, (struct sockaddr_in){0},
+                                             accept_handler, NULL, CONN_ACCEPTING);
+    if (!reactor->listen_conn ||
+        epoll_add_fd(reactor->epoll_fd, reactor->listen_fd, reactor->listen_conn, EPOLLIN | EPOLLET) < 0) {
+        perror("epoll_add_fd");
+        if (reactor->listen_conn) connection_destroy(reactor->listen_conn); // 关闭listen_fd
+        else close(reactor->listen_fd);
+        reactor->listen_conn = NULL;
+        close(reactor->epoll_fd);
+        timing_wheel_destroy(&reactor->wheel);
+        return -1;
+    }
+    return 0;
+}
 
-    if (epoll_add_fd(epoll_fd, listen_fd, listen_conn, EPOLLIN | EPOLLET) < 0) {
+/**
+ * @brief 子Reactor：创建移交队列和eventfd，并把eventfd注册到自己的epoll（水平触发）
+ * @return 成功返回0，失败返回-1
+ */
+int reactor_enable_handoff(reactor_t* reactor) {
+    reactor->handoff = (handoff_queue_t*)aligned_alloc(CACHE_LINE_SIZE, sizeof(handoff_queue_t));
+    if (!reactor->handoff) {
+        perror("aligned_alloc");
+        return -1;
+    }
+    memset(reactor->handoff, 0, sizeof(handoff_queue_t));
+    reactor->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (reactor->wake_fd < 0) {
+        perror("eventfd");
+        return -1;
+    }
+    reactor->wake_conn = connection_create(reactor, reactor->wake_fd, (struct sockaddr_in){0},
+                                           handoff_handler, NULL, CONN_ACCEPTING);
+    if (!reactor->wake_conn || epoll_add_fd(reactor->epoll_fd, reactor->wake_fd, reactor->wake_conn, EPOLLIN) < 0) {
         perror("epoll_add_fd");
-        close(listen_fd);
-        close(epoll_fd);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 关闭Reactor：释放剩余连接（包括移交队列中尚未接手的）、监听socket、eventfd和epoll实例
+ */
+void reactor_close(reactor_t* reactor) {
+    while (reactor->conns) {
+        connection_destroy(reactor->conns);
+    }
+    if (reactor->handoff) {
+        handoff_t h;
+        while (handoff_pop(reactor->handoff, &h) == 0) close(h.fd);
+        free(reactor->handoff);
+    }
+    if (reactor->wake_conn) connection_destroy(reactor->wake_conn); // 关闭wake_fd
+    else if (reactor->wake_fd >= 0) close(reactor->wake_fd);
+    if (reactor->listen_conn) connection_destroy(reactor->listen_conn); // 关闭listen_fd
+    close(reactor->epoll_fd);
+    timing_wheel_destroy(&reactor->wheel);
+}
+
+/**
+ * @brief Reactor线程入口：绑核后运行自己的事件循环
+ */
+void* reactor_thread(void* arg) {
+    reactor_t* reactor = (reactor_t*)arg;
+    if (reactor->cpu >= 0 && cpu_bind_thread(pthread_self(), reactor->cpu) != 0) {
+        fprintf(stderr, "reactor %d: bind to cpu %d failed\n", reactor->id, reactor->cpu);
+    }
+    reactor_loop(reactor);
+    return NULL;
+}
+
+
+/**
+ * @brief 生成 GET /cached 的响应主体（代替从磁盘读入的静态文件）
+ */
+shared_body_t* create_cached_body(size_t len) {
+    static const char line[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ-_\n";
+    char* data = (char*)malloc(len);
+    if (!data) return NULL;
+    for (size_t i = 0; i < len; i++) data[i] = line[i % (sizeof(line) - 1)];
+    shared_body_t* body = shared_body_adopt(data, data, len);
+    if (!body) free(data);
+    return body;
+}
+
+int main(int argc, char* argv[]) {
+    int port = DEAFULT_PORT;
+    int num_reactors = 1;
+    int dispatch = DISPATCH_REUSEPORT;
+    if (argc >= 2) {
+        port = atoi(argv[1]);
+    }
+    if (argc >= 3) {
+        num_reactors = atoi(argv[2]);
+    }
+    if (argc >= 4) {
+        g_log = atoi(argv[3]) != 0;
+    }
+    if (argc >= 5) {
+        dispatch = atoi(argv[4]);
+    }
+    if (argc >= 6) {
+        http_scan_select(atoi(argv[5]));
+    }
+    if (num_reactors < 1) num_reactors = 1;
+    if (num_reactors > MAX_REACTORS) num_reactors = MAX_REACTORS;
+    if (dispatch < DISPATCH_REUSEPORT || dispatch > DISPATCH_LEAST_LOADED) dispatch = DISPATCH_REUSEPORT;
+    int main_sub = dispatch != DISPATCH_REUSEPORT;
+
+    printf("HTTP scan kernels: %s\n", http_scan_level_name(g_http_scan.level));
+
+    // 注册信号处理函数
+    signal(SIGINT, signal_handler);
+
+    // 连接表：槽数取fd上限，之后建立连接不再分配内存
+    if (conn_table_init(&g_conns, sizeof(connection_t), 0) < 0) {
+        perror("conn_table_init");
+        exit(EXIT_FAILURE);
+    }
+    g_cached_body = create_cached_body(CACHED_BODY_SIZE);
+    if (!g_cached_body) {
+        perror("malloc");
         exit(EXIT_FAILURE);
     }
 
-    struct epoll_event events[MAX_EVENTS];
-    memset(events, 0, sizeof(events));
-    printf("Server listening on port %d\n", port);
+    reactor_t* reactors = (reactor_t*)calloc(num_reactors, sizeof(reactor_t));
+    reactor_t* main_reactor = main_sub ? (reactor_t*)calloc(1, sizeof(reactor_t)) : NULL;
+    if (!reactors || (main_sub && !main_reactor)) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    // SO_REUSEPORT：每个Reactor各自监听；主从：子Reactor不监听，改为接收移交的连接
+    int reuseport = num_reactors > 1;
+    for (int i = 0; i < num_reactors; i++) {
+        int ok = main_sub ? reactor_init(&reactors[i], i, -1, 0) == 0 && reactor_enable_handoff(&reactors[i]) == 0
+                          : reactor_init(&reactors[i], i, port, reuseport) == 0;
+        if (!ok) {
+            if (main_sub) reactor_close(&reactors[i]);
+            while (--i >= 0) reactor_close(&reactors[i]);
+            free(reactors);
+            free(main_reactor);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (main_sub) {
+        if (reactor_init(main_reactor, -1, port, 0) < 0) {
+            for (int i = 0; i < num_reactors; i++) reactor_close(&reactors[i]);
+            free(reactors);
+            free(main_reactor);
+            exit(EXIT_FAILURE);
+        }
+        main_reactor->subs = reactors;
+        main_reactor->num_subs = num_reactors;
+        main_reactor->dispatch = dispatch;
+    }
 
-    reactor_loop(epoll_fd, events, MAX_EVENTS);
+    if (num_reactors == 1 && !main_sub) {
+        // 单 Reactor：主线程直接运行事件循环
+        printf("Server listening on port %d\n", port);
+        reactor_loop(&reactors[0]);
+    } else {
+        // 多 Reactor：多核时按分散顺序绑核，CPU不够时轮转使用
+        cpu_topology_t topo;
+        if (sysconf(_SC_NPROCESSORS_ONLN) > 1 && cpu_topology_load(&topo) == 0) {
+            int* order = (int*)malloc(sizeof(int) * (topo.num_cpus > 0 ? topo.num_cpus : 1));
+            int n = order ? cpu_topology_order(&topo, AFFINITY_SCATTER, order) : -1;
+            for (int i = 0; n > 0 && i < num_reactors; i++) {
+                reactors[i].cpu = order[i % n];
+            }
+            free(order);
+            cpu_topology_free(&topo);
+        }
 
-    close(listen_fd);
-    close(epoll_fd);
-    free(listen_conn);
+        int started = 0;
+        for (; started < num_reactors; started++) {
+            if (pthread_create(&reactors[started].thread, NULL, reactor_thread, &reactors[started]) != 0) {
+                perror("pthread_create");
+                __atomic_store_n(&global_running, 0, __ATOMIC_RELAXED);
+                break;
+            }
+        }
+        if (started == num_reactors) {
+            if (main_sub) {
+                printf("Server listening on port %d (main reactor + %d sub reactors, %s)\n", port, num_reactors,
+                       dispatch == DISPATCH_ROUND_ROBIN ? "round-robin" : "least-loaded");
+                // 主Reactor在主线程中运行，只处理accept
+                reactor_loop(main_reactor);
+            } else {
+                printf("Server listening on port %d (%d reactors, SO_REUSEPORT)\n", port, num_reactors);
+            }
+        }
+        for (int i = 0; i < started; i++) {
+            pthread_join(reactors[i].thread, NULL);
+        }
+    }
+
+    if (main_sub) {
+        reactor_close(main_reactor); // 先停止accept，子Reactor的移交队列由各自的reactor_close清空
+        free(main_reactor);
+    }
+    for (int i = 0; i < num_reactors; i++) {
+        if (num_reactors > 1 || main_sub) {
+            printf("reactor %d (cpu %d): %llu connections, %llu requests, %llu timeouts, %llu stale events, "
+                   "%llu epoll_ctl mods\n",
+                   i, reactors[i].cpu, reactors[i].accepted, reactors[i].requests, reactors[i].timeouts,
+                   reactors[i].stale, reactors[i].ctl_mods);
+        }
+        reactor_close(&reactors[i]);
+    }
+    free(reactors);
+
+    // 释放连接表中留给复用的缓冲区
+    for (int fd = 0; fd <= g_conns.max_fd; fd++) {
+        connection_t* conn = (connection_t*)conn_table_slot(&g_conns, fd);
+        iobuf_free(&conn->in);
+        outq_free(&conn->out);
+    }
+    conn_table_destroy(&g_conns);
+    shared_body_unref(g_cached_body);
 
     printf("End.\n");
     return 0;
-}
\ No newline at end of file
+}
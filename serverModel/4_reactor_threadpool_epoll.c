@@ -6,8 +6,27 @@
 //  - epoll 使用 ET（边沿触发）+ ONESHOT（每次通知后需手动 re-arm）
 //  - 主线程负责 accept + epoll_wait（事件分发）
 //  - worker 线程负责真正的 I/O 读写（read until EAGAIN / write until EAGAIN）并在完成后重新 arm
-//  - 连接通过 connection_t 结构体管理，使用互斥保护缓冲区 / 状态，避免竞态
-
+//  - 连接通过 connection_t 结构体管理，同一连接的读写任务投递到该连接的strand上串行执行，
+//    缓冲区 / 状态不需要加锁；连接关闭后由Reactor主线程在strand空闲时释放
+//  - 每个NUMA节点一个子线程池，连接在accept时固定分配到一个节点，缓冲区由该节点的worker首次写入
+//  - 线程池队列满时暂停该连接（strand的任务留在strand中，ONESHOT已摘除、不再re-arm），
+//    数据留在内核缓冲区由TCP流控反压客户端，之后每轮事件循环优先重新调度被暂停的连接
+//  - 隔舱：阻塞型请求（GET /slow...，模拟磁盘/fsync/DNS等慢依赖）转到独立的 "io-blocking" 子线程池，
+//    完成后把响应投递回连接的strand；慢依赖只会占满自己的子线程池（满时直接返回503），
+//    "cpu" 子线程池的排队时间不受影响。Reactor每 STATS_INTERVAL_MS 输出一次各子线程池的统计
+//  - 读写缓冲区是可增长的环形缓冲区（0_iobuf.h）：readv/writev，部分写之后不再memmove，
+//    每次读到EAGAIN为止的数据作为一个响应回显，不再按4KB截断
+//  - 连接结构体放在按fd索引的连接表中（0_conn_table.h），启动时一次分配，只由Reactor主线程取用/归还；
+//    缓冲区留在槽中给复用该fd的下一个连接（节点不同时才重新分配），稳态下建立/关闭连接不调用malloc/free。
+//    epoll事件登记 代数<<32 | fd，已关闭连接的残留事件被识别并丢弃
+//  - 请求由增量式HTTP/1.1解析器（0_http_parser.h）切分，解析状态保存在连接中：拆成多次读入的请求等到完整再处理，
+//    流水线请求按顺序各回应一次；阻塞型请求进行期间后面的请求留在读缓冲区，完成后再继续处理，响应顺序不变。
+//    Connection: close / HTTP/1.0、非法请求、对端关闭写方向时，回应完已收到的请求后关闭连接
+//  - 写缓冲区是待发送队列（0_outq.h）：响应头写入内联缓冲区，主体作为单独的iovec一起writev；
+//    回显不小于 ECHO_ADOPT_MIN 的请求时把读缓冲区整块转成共享主体（由worker在本节点重新分配读缓冲区），
+//    大请求体不再拷贝进写缓冲区
+
+#define _GNU_SOURCE // 线程池绑核（CPU_SET等）需要，必须在所有系统头文件之前
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,16 +38,41 @@
 #include <pthread.h>
 #include <signal.h>
 #include <errno.h>
+#include <stddef.h>
 // 引入线程池头文件
 #include "0_threadpool.h"
+#include "0_iobuf.h"
+#include "0_conn_table.h"
+#include "0_http_parser.h"
+#include "0_outq.h"
 
 #define DEAFULT_PORT 13145
 #define MAX_EVENTS 1024
-#define BUFFER_SIZE 4096
+#define BUFFER_SIZE 4096 // 读写缓冲区的初始容量（按需增长）
+#define INPUT_MAX_SIZE IOBUF_DEFAULT_MAX // 读缓冲区上限，达到后先回写再继续读
+#define OUTPUT_MAX_SIZE (2 * INPUT_MAX_SIZE + BUFFER_SIZE) // 写缓冲区上限：待发送数据不少于INPUT_MAX_SIZE时暂停读和
+                                                           // 处理请求，之后最多再放入一个完整的请求和响应头
+#define RETAIN_BUFFER_SIZE 65536 // 连接关闭后留在槽中复用的缓冲区容量上限，更大的释放
+#define ECHO_ADOPT_MIN RETAIN_BUFFER_SIZE // 回显的请求不小于此长度时把读缓冲区整块转成共享主体（不拷贝）
+#define PAUSE_RETRY_MS 10 // 有被暂停或待释放的连接时epoll_wait的超时（毫秒），到时重试
+#define IO_BLOCKING_THREADS 4 // "io-blocking" 子线程池的线程数
+#define IO_BLOCKING_QUEUE 256 // "io-blocking" 子线程池的队列长度（满时拒绝，返回503）
+#define SLOW_REQUEST_PATH "/slow" // 走阻塞路径的请求（GET，路径以此开头）
+#define SLOW_REQUEST_MS 200 // 模拟的慢依赖耗时（毫秒）
+#define STATS_INTERVAL_MS 10000 // 子线程池统计的输出间隔（毫秒，按秒取整）
 
 volatile int global_running = 1;
-// 全局线程池指针（Reactor主线程创建，所有事件共享）
-thread_pool_t* g_thread_pool = NULL;
+// 全局线程池组指针（Reactor主线程创建，每个NUMA节点一个子线程池）
+numa_thread_pool_t* g_numa_pool = NULL;
+unsigned g_conn_seq = 0; // 已接受的连接数（仅Reactor主线程访问，用于轮转分配节点）
+// 命名子线程池组："cpu"（即上面各节点的子线程池，只登记不拥有）+ "io-blocking"
+thread_pool_group_t* g_pools = NULL;
+int g_blocking_pool = -1; // "io-blocking" 子线程池编号
+conn_table_t g_conns; // 连接表（仅Reactor主线程取用/归还槽）
+unsigned long long g_stale_events = 0; // 丢弃的残留事件（仅Reactor主线程访问）
+// 固定文本的响应主体
+shared_body_t g_slow_done_body = SHARED_BODY_STATIC("slow dependency done\n");
+shared_body_t g_saturated_body = SHARED_BODY_STATIC("io-blocking pool saturated\n");
 
 /**
  * @brief 信号处理函数：触发优雅退出，销毁线程池
@@ -36,26 +80,36 @@ thread_pool_t* g_thread_pool = NULL;
 void signal_handler(int sig) {
     global_running = 0;
     printf("\nSignal %d received, shutting down...\n", sig);
-    // 销毁线程池（等待所有任务完成）
-    if (g_thread_pool) {
-        thread_pool_destroy(g_thread_pool, 0);
+    // 销毁线程池（等待所有任务完成）：先停 "io-blocking"，它的任务会把响应投递回各节点的子线程池
+    if (g_pools) {
+        thread_pool_group_destroy(g_pools, 0);
+    }
+    if (g_numa_pool) {
+        numa_thread_pool_destroy(g_numa_pool, 0);
     }
 }
 
 // 前置声明
 struct connection_s;
 typedef struct connection_s{
+    conn_slot_t slot; // 连接表槽头部（代数），必须是第一个成员
     int fd;
     struct sockaddr_in addr;
     int epoll_fd; // 新增：关联的epoll_fd，用于任务中重新注册事件
     void (*read_handler)(int, struct connection_s*); // 读事件处理函数指针
     void (*write_handler)(int, struct connection_s*); // 写事件处理函数指针
-    pthread_mutex_t lock; // 连接锁，保护缓冲区和状态
-    char* wbuffer; // 写缓冲区
-    size_t wbuffer_size; // 写缓冲区大小
-    size_t wbuffer_sent; // 已发送数据大小
-    char* read_buffer; // 读缓冲区
-    size_t read_buffer_size; // 读缓冲区大小
+    thread_pool_strand_t strand; // 串行执行该连接的读写任务（替代连接锁）
+    int closed; // 已关闭（只在strand的任务中读写）
+    iobuf_t in; // 读缓冲区
+    outq_t out; // 待发送队列（内联的响应头 + 共享主体的引用）
+    int node; // 处理该连接的子线程池编号（accept时确定，之后不变）
+    int buf_node; // 缓冲区由哪个节点的worker分配（槽复用时节点相同才沿用）
+    int paused; // 因线程池饱和而暂停：持有strand调度令牌、等待重新提交（仅Reactor主线程访问）
+    int blocking; // 有进行中的阻塞型请求（原子访问）：期间不re-arm事件，释放连接要等它结束
+    struct connection_s* paused_next; // 暂停链表
+    struct connection_s* dead_next; // 待释放链表
+    http_parser_t parser; // 当前请求的解析状态（只在strand的任务中读写）
+    int closing; // 写缓冲区发完后关闭连接（只在strand的任务中读写）
 } connection_t;
 
 typedef enum {
@@ -64,45 +118,107 @@ typedef enum {
 }connection_type_t; 
 
 /**
- * @brief 创建连接结构体
+ * @brief 一轮epoll_wait产生的待提交任务
+ * @note 只由Reactor主线程访问；每个事件最多产生读、写两个任务
+ */
+typedef struct dispatch_batch_s {
+    void (*funcs[MAX_EVENTS * 2])(void*);
+    void* args[MAX_EVENTS * 2];
+    int count;
+} dispatch_batch_t;
+
+dispatch_batch_t* g_dispatch_batches; // 每个子线程池一个
+
+/**
+ * @brief 因线程池饱和而暂停的连接（FIFO，仅Reactor主线程访问）
+ * @note 暂停期间连接的任务留在strand中（Reactor持有调度令牌），连接也没有注册epoll事件
+ */
+typedef struct paused_list_s {
+    connection_t* head;
+    connection_t* tail;
+    int count;
+} paused_list_t;
+
+paused_list_t* g_paused_lists; // 每个子线程池一个
+connection_t* g_dead_conns = NULL; // 已关闭、等待释放的连接（worker压入，Reactor主线程整体取走，原子访问）
+connection_t* g_dying_conns = NULL; // 已取走但strand尚未空闲的连接（仅Reactor主线程访问）
+
+/**
+ * @brief 创建连接结构体（从连接表取用fd对应的槽）
  * @param fd 套接字FD
  * @param addr 客户端地址
  * @param read_handler 读处理函数
  * @param write_handler 写处理函数
  * @param type 连接类型（监听/客户端）
- * @return 连接结构体指针
+ * @return 连接结构体指针；fd超出连接表范围返回NULL（调用方关闭fd）
+ * @note 仅在Reactor主线程调用；槽中上一个连接留下的缓冲区保留（已清空），其余字段重新初始化
  */
 connection_t* connection_create(int fd, struct sockaddr_in addr,
                                 void (*read_handler)(int, connection_t*), 
                                 void (*write_handler)(int, connection_t*), 
                                 connection_type_t type) {
-    connection_t* conn = (connection_t*)malloc(sizeof(connection_t));
-    memset(conn, 0, sizeof(connection_t));
+    connection_t* conn = (connection_t*)conn_table_acquire(&g_conns, fd);
+    if (!conn) return NULL;
     conn->fd = fd;
     conn->addr = addr;
+    conn->epoll_fd = -1;
     conn->read_handler = read_handler;
     conn->write_handler = write_handler;
-    if (type == CONN_CLIENT) {
-        conn->read_buffer = (char*)malloc(BUFFER_SIZE);
-        conn->read_buffer_size = BUFFER_SIZE;
-        conn->wbuffer = (char*)malloc(BUFFER_SIZE);
-        conn->wbuffer_size = BUFFER_SIZE;
-        pthread_mutex_init(&conn->lock, NULL); // 初始化连接锁
+    conn->closed = 0;
+    conn->node = 0;
+    conn->paused = 0;
+    conn->blocking = 0;
+    conn->paused_next = NULL;
+    conn->dead_next = NULL;
+    conn->closing = 0;
+    http_parser_init(&conn->parser, INPUT_MAX_SIZE - HTTP_MAX_HEADER_SIZE); // 整个请求必须能放进读缓冲区
+    // 客户端连接的缓冲区延迟到worker第一次处理时分配（connection_alloc_buffers），使物理页落在worker所在节点；
+    // strand在确定子线程池后初始化
+    (void)type;
+    if (conn->in.init_cap == 0) {
+        iobuf_init(&conn->in, BUFFER_SIZE, INPUT_MAX_SIZE);
+        outq_init(&conn->out, BUFFER_SIZE, OUTPUT_MAX_SIZE);
     }
     return conn;
 }
 
 /**
- * @brief 销毁连接结构体，释放资源
+ * @brief 分配连接的读写缓冲区（在处理该连接的worker线程中调用）
+ * @param conn 连接结构体指针
+ * @return 成功0，失败-1
+ * @note 由worker分配并首次写入：内核按首次触碰分配物理页，缓冲区位于worker所在的NUMA节点
+ */
+int connection_alloc_buffers(connection_t* conn) {
+    if (conn->buf_node != conn->node) {
+        // 槽中保留的是其他节点分配的缓冲区
+        iobuf_free(&conn->in);
+        iobuf_free(&conn->out.bytes);
+        conn->buf_node = conn->node;
+    }
+    if (!conn->in.data) {
+        if (iobuf_reserve(&conn->in, BUFFER_SIZE) < 0) return -1;
+        memset(conn->in.data, 0, conn->in.cap);
+    }
+    if (!conn->out.bytes.data) {
+        if (iobuf_reserve(&conn->out.bytes, BUFFER_SIZE) < 0) return -1;
+        memset(conn->out.bytes.data, 0, conn->out.bytes.cap);
+    }
+    return 0;
+}
+
+/**
+ * @brief 销毁连接结构体：关闭fd，归还连接表槽（不大的缓冲区留给下一个连接）
  * @param conn 连接结构体指针
  * @return 成功0，失败-1
  */
 int connection_destroy(connection_t* conn) {
     if (!conn) return -1;
-    close(conn->fd);
-    if (conn->read_buffer) free(conn->read_buffer);
-    if (conn->wbuffer) free(conn->wbuffer);
-    free(conn);
+    thread_pool_strand_destroy(&conn->strand);
+    int fd = conn->fd;
+    iobuf_recycle(&conn->in, RETAIN_BUFFER_SIZE);
+    outq_recycle(&conn->out, RETAIN_BUFFER_SIZE); // 释放还没发完的主体引用
+    conn_table_release(&g_conns, conn); // 先归还再关闭：fd关闭后就可能被accept复用
+    close(fd);
     return 0;
 }
 
@@ -131,7 +247,7 @@ int epoll_add_fd(int epoll_fd, int fd, connection_t* conn, uint32_t events) {
     struct epoll_event ev;
     // 核心修改1：添加ET+ONESHOT
     ev.events = events | EPOLLET | EPOLLONESHOT; 
-    ev.data.ptr = conn;
+    ev.data.u64 = conn_table_key(conn);
     // 关联epoll_fd到连接结构体，供后续重新注册事件使用
     conn->epoll_fd = epoll_fd;
     return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
@@ -158,16 +274,62 @@ int epoll_del_fd(int epoll_fd, int fd) {
 int epoll_mod_fd(int epoll_fd, int fd, connection_t* conn, uint32_t events) {
     struct epoll_event ev;
     ev.events = events | EPOLLET | EPOLLONESHOT; // 保持ET+ONESHOT
-    ev.data.ptr = conn;
+    ev.data.u64 = conn_table_key(conn);
     return epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev);
 }
 
+/**
+ * @brief 关闭连接（在连接的strand中调用）
+ * @param conn 连接结构体指针
+ * @note 不能直接释放：strand中可能还有排在后面的任务，Reactor也可能已经取到该连接的事件、稍后还会投递任务。
+ *       这里只从epoll摘除、关闭收发并放入待释放链表，由Reactor主线程在strand空闲后释放（connection_reap）
+ */
+void connection_close(connection_t* conn) {
+    if (conn->closed) return;
+    conn->closed = 1;
+    epoll_del_fd(conn->epoll_fd, conn->fd);
+    shutdown(conn->fd, SHUT_RDWR);
+    connection_t* head = __atomic_load_n(&g_dead_conns, __ATOMIC_RELAXED);
+    do {
+        conn->dead_next = head;
+    } while (!__atomic_compare_exchange_n(&g_dead_conns, &head, conn, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/**
+ * @brief 释放已关闭且strand空闲的连接（Reactor主线程，每轮任务提交之后调用）
+ * @note 连接先从epoll摘除再进入待释放链表，之后的epoll_wait不会再返回它；
+ *       本轮及之前取到的事件已经投递到strand，strand空闲即说明这些任务都已执行完
+ */
+void connection_reap(void) {
+    connection_t* conn = __atomic_exchange_n(&g_dead_conns, NULL, __ATOMIC_ACQUIRE);
+    while (conn) {
+        connection_t* next = conn->dead_next;
+        conn->dead_next = g_dying_conns;
+        g_dying_conns = conn;
+        conn = next;
+    }
+    connection_t** link = &g_dying_conns;
+    while (*link) {
+        conn = *link;
+        // 阻塞型请求结束时还会向strand投递一次任务，先确认它已结束再看strand是否空闲
+        if (!__atomic_load_n(&conn->blocking, __ATOMIC_ACQUIRE) && thread_pool_strand_idle(&conn->strand)) {
+            *link = conn->dead_next;
+            connection_destroy(conn);
+        } else {
+            link = &conn->dead_next;
+        }
+    }
+}
+
 // 前向声明
 void accept_handler(int epoll_fd, connection_t* accept_conn);
 void read_worker_task(void* arg);    // 读任务（线程池执行）
 void write_worker_task(void* arg);   // 写任务（线程池执行）
 void read_handler(int epoll_fd, connection_t* conn);
 void write_handler(int epoll_fd, connection_t* conn);
+void blocking_request_task(void* arg); // 阻塞型请求（"io-blocking" 子线程池执行）
+void blocking_done_task(void* arg);    // 阻塞型请求完成后回写响应（连接的strand中执行）
+void dispatch_batch_flush(dispatch_batch_t* batch, thread_pool_t* pool, paused_list_t* paused);
 
 /**
  * @brief 监听FD的读事件处理（接受新连接）
@@ -192,9 +354,16 @@ void accept_handler(int epoll_fd, connection_t* accept_conn) {
             continue;
         }
 
-        // 创建客户端连接结构体
+        // 创建客户端连接结构体，轮转分配到各节点的子线程池
         connection_t* conn = connection_create(conn_fd, client_addr, 
                                                read_handler, write_handler, CONN_CLIENT);
+        if (!conn) {
+            fprintf(stderr, "fd %d exceeds connection table, dropping\n", conn_fd);
+            close(conn_fd);
+            continue;
+        }
+        conn->node = (int)(g_conn_seq++ % (unsigned)g_numa_pool->num_nodes);
+        thread_pool_strand_init(&conn->strand, g_numa_pool->pools[conn->node]);
 
         // 注册客户端FD到epoll：EPOLLIN + ET + ONESHOT
         if (epoll_add_fd(epoll_fd, conn_fd, conn, EPOLLIN) < 0) {
@@ -215,94 +384,174 @@ void accept_handler(int epoll_fd, connection_t* accept_conn) {
 }
 
 /**
- * @brief 读任务（线程池执行）：实际处理客户端读数据
- * @param arg 连接结构体指针
- * @note 耗时操作移到线程池，Reactor主线程仅负责事件分发
+ * @brief 生成HTTP响应放入待发送队列：响应头写入内联缓冲区，主体作为单独的段（不和响应头拼接）
+ * @param conn 连接结构体指针
+ * @param status 状态行（如 "200 OK"）
+ * @param body 非NULL时发送这个共享主体（只增加引用，不拷贝）
+ * @param echo_len body 为NULL时回显读缓冲区的前 echo_len 字节（从读缓冲区移出；较大时整块转成共享主体）
+ * @param keep_alive 0 时回应 Connection: close
+ * @return 成功0，写缓冲区超过上限-1
  */
-void build_http_response(connection_t* conn, const char* body)
+int build_http_response(connection_t* conn, const char* status, shared_body_t* body, size_t echo_len, int keep_alive)
 {
     static const char* header_fmt =
-        "HTTP/1.1 200 OK\r\n"
+        "HTTP/1.1 %s\r\n"
         "Content-Type: text/plain\r\n"
         "Content-Length: %zu\r\n"
-        "Connection: keep-alive\r\n"
+        "Connection: %s\r\n"
         "\r\n";
 
-    size_t body_len = strlen(body);
+    char header[160];
+    size_t body_len = body ? body->len : echo_len;
+    int header_len = snprintf(header, sizeof(header), header_fmt, status, body_len,
+                              keep_alive ? "keep-alive" : "close");
 
-    int header_len = snprintf(conn->wbuffer, conn->wbuffer_size,
-                              header_fmt, body_len);
+    if (outq_append(&conn->out, header, header_len) < 0) return -1;
+    if (body) return outq_append_body(&conn->out, body, 0, body->len);
+    return outq_move_iobuf(&conn->out, &conn->in, echo_len, ECHO_ADOPT_MIN);
+}
 
-    memcpy(conn->wbuffer + header_len, body, body_len);
+/**
+ * @brief 解析读缓冲区中的请求并生成响应（连接的strand中执行）
+ * @param conn 连接结构体指针
+ * @return 0 已处理完所有完整的请求；1 有阻塞型请求在 "io-blocking" 中（之后的请求留在读缓冲区，
+ *         完成后由 blocking_done_task 继续）；-1 写缓冲区溢出
+ * @note 非法请求回应错误状态码；它和 Connection: close 的请求之后的数据都丢弃，写完后关闭连接。
+ *       待发送数据达到 INPUT_MAX_SIZE 时停止处理（返回0），剩余的请求留在读缓冲区
+ */
+int connection_process(connection_t* conn) {
+    if (__atomic_load_n(&conn->blocking, __ATOMIC_ACQUIRE)) return 1; // 保持响应顺序
+    while (iobuf_size(&conn->in) > 0) {
+        if (conn->closing) {
+            iobuf_clear(&conn->in);
+            break;
+        }
+        if (outq_size(&conn->out) >= INPUT_MAX_SIZE) break; // 待发送数据过多：剩余请求等写完后由 write_worker_task 处理
+        struct iovec iov[2];
+        if (conn->parser.state == HTTP_STATE_HEAD && iobuf_readable_iov(&conn->in, iov) == 2) {
+            iobuf_linearize(&conn->in); // 头部需要连续：只有残留半个请求又绕回时才整理
+        }
+        if (iobuf_readable_iov(&conn->in, iov) == 0) break;
+        const char* base = (const char*)iov[0].iov_base;
+        ssize_t n = http_parser_execute(&conn->parser, base, iobuf_size(&conn->in));
+        if (n == 0 && iobuf_size(&conn->in) >= conn->in.max_cap) {
+            conn->parser.error = 413; // 读缓冲区满了请求仍不完整
+            n = -1;
+        }
+        if (n == 0) break;
+        if (n < 0) {
+            conn->closing = 1;
+            iobuf_clear(&conn->in);
+            return build_http_response(conn, http_status_text(conn->parser.error), NULL, 0, 0);
+        }
 
-    conn->wbuffer_sent = header_len + body_len;
+        http_request_t* req = &conn->parser.req;
+        printf("[%s:%d][Thread %lu]: %.*s %.*s\n",
+               inet_ntoa(conn->addr.sin_addr),
+               ntohs(conn->addr.sin_port),
+               (unsigned long)pthread_self(), // 打印处理任务的线程ID
+               (int)req->method.len, HTTP_SPAN_PTR(base, req->method),
+               (int)req->target.len, HTTP_SPAN_PTR(base, req->target));
+        int keep_alive = req->keep_alive;
+        int ret;
+        if (http_span_equals(base, req->method, "GET") && req->target.len >= strlen(SLOW_REQUEST_PATH) &&
+            memcmp(HTTP_SPAN_PTR(base, req->target), SLOW_REQUEST_PATH, strlen(SLOW_REQUEST_PATH)) == 0) {
+            // 阻塞型请求转到 "io-blocking" 子线程池，本连接暂不re-arm，完成后由 blocking_done_task 回写并re-arm
+            iobuf_consume(&conn->in, (size_t)n);
+            http_parser_reset(&conn->parser);
+            if (!keep_alive) conn->closing = 1;
+            __atomic_store_n(&conn->blocking, 1, __ATOMIC_RELEASE);
+            if (thread_pool_group_submit(g_pools, g_blocking_pool, blocking_request_task, conn) >= 0) {
+                return 1;
+            }
+            // 子线程池已满：立即拒绝，不让慢依赖拖住本连接
+            __atomic_store_n(&conn->blocking, 0, __ATOMIC_RELEASE);
+            ret = build_http_response(conn, "503 Service Unavailable", &g_saturated_body, 0, keep_alive);
+        } else {
+            // 回显整个请求（请求行 + 头部 + 主体）
+            ret = build_http_response(conn, "200 OK", NULL, (size_t)n, keep_alive);
+            http_parser_reset(&conn->parser);
+            if (!keep_alive) conn->closing = 1;
+        }
+        if (ret < 0) return -1;
+    }
+    return 0;
 }
 
+/**
+ * @brief 重新注册事件（ONESHOT必需，连接的strand中执行）
+ * @param conn 连接结构体指针
+ * @note 有未发完的数据时关注写事件，待发送数据过多时暂停读（反压）；需要关闭且数据已发完时关闭连接。
+ *       阻塞型请求进行期间不注册，由 blocking_done_task 完成后注册
+ */
+void connection_rearm(connection_t* conn) {
+    if (__atomic_load_n(&conn->blocking, __ATOMIC_ACQUIRE)) return;
+    if (conn->closing && outq_size(&conn->out) == 0) {
+        connection_close(conn);
+        return;
+    }
+    uint32_t newev = 0;
+    if (!conn->closing && outq_size(&conn->out) < INPUT_MAX_SIZE) newev |= EPOLLIN;
+    if (outq_size(&conn->out) > 0) newev |= EPOLLOUT;
+    epoll_mod_fd(conn->epoll_fd, conn->fd, conn, newev);
+}
 
+/**
+ * @brief 读任务（线程池执行）：实际处理客户端读数据
+ * @param arg 连接结构体指针
+ * @note 耗时操作移到线程池，Reactor主线程仅负责事件分发
+ */
 void read_worker_task(void* arg) {
     connection_t* conn = (connection_t*)arg;
-    if (!conn || conn->fd < 0) return;
+    if (!conn || conn->fd < 0 || conn->closed) return;
+    if (connection_alloc_buffers(conn) < 0) {
+        perror("malloc connection buffers");
+        connection_close(conn);
+        return;
+    }
 
+    char extra[IOBUF_READ_EXTRA]; // 读缓冲区空闲段不够时的溢出部分，一次readv读入更多数据
     ssize_t n;
-    int have_pending_write = 0;
-    // ET模式：循环读直到无数据
+    int eof = 0;
+    // ET模式：循环读直到无数据（或读缓冲区达到上限，剩余数据留在内核中，re-arm后再读）
     while (1) {
-        n = read(conn->fd, conn->read_buffer, conn->read_buffer_size-1);
+        n = iobuf_read_fd(&conn->in, conn->fd, extra, sizeof(extra));
         if (n > 0) {
-            conn->read_buffer[n] = '\0';
-            printf("[%s:%d][Thread %lu]: %s\n", 
-                   inet_ntoa(conn->addr.sin_addr), 
-                   ntohs(conn->addr.sin_port),
-                   (unsigned long)pthread_self(), // 打印处理任务的线程ID
-                   conn->read_buffer);
-            // 回显数据：拷贝到写缓冲区
-            #if 0
-            pthread_mutex_lock(&conn->lock);
-            memcpy(conn->wbuffer, conn->read_buffer, n);
-            conn->wbuffer_sent = n;
-            pthread_mutex_unlock(&conn->lock);
-            #else
-            pthread_mutex_lock(&conn->lock);
-            build_http_response(conn, conn->read_buffer);
-            pthread_mutex_unlock(&conn->lock);
-            #endif
-            have_pending_write = 1;
+            continue;
         } else if (n == 0) {
-            // 客户端关闭连接
+            // 客户端关闭连接（或只关闭了写方向）：回应已收到的完整请求，写完后关闭
             printf("Client disconnected, fd=%d\n", conn->fd);
-            epoll_del_fd(conn->epoll_fd, conn->fd);
-            connection_destroy(conn);
-            return;
+            eof = 1;
+            break;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+            break;
         } else {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // 读完所有数据，重新注册读事件（ONESHOT必需）
-                uint32_t newev = EPOLLIN;
-                if (have_pending_write) newev |= EPOLLOUT;
-                epoll_mod_fd(conn->epoll_fd, conn->fd, conn, newev);
-                break;
-            } else {
-                perror("read");
-                epoll_del_fd(conn->epoll_fd, conn->fd);
-                connection_destroy(conn);
-                return;
-            }
+            perror("read");
+            connection_close(conn);
+            return;
         }
     }
+
+    if (connection_process(conn) < 0) {
+        fprintf(stderr, "output buffer overflow, fd=%d\n", conn->fd);
+        connection_close(conn);
+        return;
+    }
+    if (eof) conn->closing = 1;
+    connection_rearm(conn);
 }
 
 /**
- * @brief 客户端读事件处理（Reactor主线程触发，提交到线程池）
+ * @brief 客户端读事件处理（Reactor主线程触发，加入本轮批量提交）
  * @param epoll_fd epoll实例FD
  * @param conn 客户端连接结构体
- * @note 仅做任务提交，不处理实际逻辑，保证Reactor主线程轻量
+ * @note 仅做任务收集，本轮事件遍历完后由 dispatch_batch_flush 一次性提交到线程池
  */
 void read_handler(int epoll_fd, connection_t* conn) {
-    // 将读任务提交到线程池
-    if (thread_pool_add_task(g_thread_pool, read_worker_task, conn) != 0) {
-        fprintf(stderr, "add read task failed, fd=%d\n", conn->fd);
-        epoll_del_fd(epoll_fd, conn->fd);
-        connection_destroy(conn);
-    }
+    dispatch_batch_t* batch = &g_dispatch_batches[conn->node];
+    batch->funcs[batch->count] = read_worker_task;
+    batch->args[batch->count] = conn;
+    batch->count++;
 }
 
 /**
@@ -311,51 +560,183 @@ void read_handler(int epoll_fd, connection_t* conn) {
  */
 void write_worker_task(void* arg) {
     connection_t* conn = (connection_t*)arg;
-    if (!conn || conn->fd < 0) return;
+    if (!conn || conn->fd < 0 || conn->closed) return;
 
     ssize_t n;
-    // ET模式：循环写直到数据发送完毕
-    while (conn->wbuffer_sent > 0) {
-        pthread_mutex_lock(&conn->lock);
-        n = write(conn->fd, conn->wbuffer, conn->wbuffer_sent);
-        if (n > 0) {
-            conn->wbuffer_sent -= n;
-            if (conn->wbuffer_sent > 0) {
-                memmove(conn->wbuffer, conn->wbuffer + n, conn->wbuffer_sent);
-            }
-        } else {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // 写缓冲区满，重新注册写事件（ONESHOT必需）
-                epoll_mod_fd(conn->epoll_fd, conn->fd, conn, EPOLLOUT);
+    while (1) {
+        // ET模式：循环写直到数据发送完毕或内核发送缓冲区满（响应头和主体一次writev，部分写只移动位置）
+        while (outq_size(&conn->out) > 0) {
+            n = outq_write_fd(&conn->out, conn->fd);
+            if (n > 0) {
+                continue;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 break;
             } else {
                 perror("write");
-                epoll_del_fd(conn->epoll_fd, conn->fd);
-                connection_destroy(conn);
-                pthread_mutex_unlock(&conn->lock);
+                connection_close(conn);
                 return;
             }
         }
+        if (outq_size(&conn->out) > 0 || iobuf_size(&conn->in) == 0) break;
+        // 写完了，读缓冲区中还有因待发送数据过多而暂停处理的请求（不会再触发读事件）
+        if (connection_process(conn) < 0) {
+            fprintf(stderr, "output buffer overflow, fd=%d\n", conn->fd);
+            connection_close(conn);
+            return;
+        }
+        if (outq_size(&conn->out) == 0) break; // 只剩不完整的请求，或已转交阻塞型请求
     }
-    pthread_mutex_unlock(&conn->lock);
-    // 数据发送完毕，切换回读事件
-    if (conn->wbuffer_sent == 0) {
-        epoll_mod_fd(conn->epoll_fd, conn->fd, conn, EPOLLIN);
+    // 重新注册事件：没写完时关注写事件，写完切换回读事件
+    connection_rearm(conn);
+}
+
+/**
+ * @brief 阻塞型请求（"io-blocking" 子线程池执行）：模拟慢依赖，完成后把回写任务投递回连接的strand
+ * @param arg 连接结构体指针
+ * @note 连接在 blocking 清零前不会被释放；strand的调度被拒绝时本线程持有令牌，稍后重试
+ *       （阻塞在这里只占用 "io-blocking" 的线程）
+ */
+void blocking_request_task(void* arg) {
+    connection_t* conn = (connection_t*)arg;
+    usleep(SLOW_REQUEST_MS * 1000); // 慢依赖的替身（磁盘/fsync/DNS）
+
+    int ret = thread_pool_strand_post(&conn->strand, blocking_done_task, conn);
+    while (ret == THREAD_POOL_REJECTED) {
+        usleep(PAUSE_RETRY_MS * 1000);
+        ret = thread_pool_add_task(conn->strand.pool, thread_pool_strand_run, &conn->strand) >= 0 ?
+              THREAD_POOL_OK : THREAD_POOL_REJECTED;
+    }
+    if (ret < 0) {
+        // 线程池已停止，回写任务不会执行
+        __atomic_store_n(&conn->blocking, 0, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * @brief 阻塞型请求完成（连接的strand中执行）：回写响应，继续处理阻塞期间留在读缓冲区中的请求
+ * @param arg 连接结构体指针
+ * @note 先清除 blocking：strand正在执行本任务，连接不会被释放；继续处理时可能又转交一个新的阻塞型请求
+ */
+void blocking_done_task(void* arg) {
+    connection_t* conn = (connection_t*)arg;
+    __atomic_store_n(&conn->blocking, 0, __ATOMIC_RELEASE);
+    if (conn->closed) return;
+    if (build_http_response(conn, "200 OK", &g_slow_done_body, 0, !conn->closing) < 0 ||
+        connection_process(conn) < 0) {
+        fprintf(stderr, "output buffer overflow, fd=%d\n", conn->fd);
+        connection_close(conn);
+        return;
     }
+    write_worker_task(conn);
 }
 
 /**
- * @brief 客户端写事件处理（Reactor主线程触发，提交到线程池）
+ * @brief 客户端写事件处理（Reactor主线程触发，加入本轮批量提交）
  * @param epoll_fd epoll实例FD
  * @param conn 客户端连接结构体
  */
 void write_handler(int epoll_fd, connection_t* conn) {
-    // 将写任务提交到线程池
-    if (thread_pool_add_task(g_thread_pool, write_worker_task, conn) != 0) {
-        fprintf(stderr, "add write task failed, fd=%d\n", conn->fd);
-        epoll_del_fd(epoll_fd, conn->fd);
-        connection_destroy(conn);
+    dispatch_batch_t* batch = &g_dispatch_batches[conn->node];
+    batch->funcs[batch->count] = write_worker_task;
+    batch->args[batch->count] = conn;
+    batch->count++;
+}
+
+/**
+ * @brief 由strand找到所属连接
+ */
+connection_t* connection_of_strand(thread_pool_strand_t* strand) {
+    return (connection_t*)((char*)strand - offsetof(connection_t, strand));
+}
+
+/**
+ * @brief 暂停连接：strand的调度被线程池拒绝，Reactor持有调度令牌，稍后重新提交
+ * @param paused 所属子线程池的暂停链表
+ * @param conn 连接结构体指针
+ */
+void connection_pause(paused_list_t* paused, connection_t* conn) {
+    if (conn->paused) return;
+    conn->paused = 1;
+    conn->paused_next = NULL;
+    if (paused->tail) {
+        paused->tail->paused_next = conn;
+    } else {
+        paused->head = conn;
     }
+    paused->tail = conn;
+    paused->count++;
+    fprintf(stderr, "thread pool saturated, pause fd=%d\n", conn->fd);
+}
+
+/**
+ * @brief 按暂停顺序重新提交被暂停连接的strand
+ * @param paused 暂停链表
+ * @param pool 目标子线程池
+ * @note 一次批量提交；只有前面一部分被接收时，剩余连接保持暂停
+ */
+void connection_resume(paused_list_t* paused, thread_pool_t* pool) {
+    void (*funcs[64])(void*);
+    void* args[64];
+    while (paused->head) {
+        int n = 0;
+        for (connection_t* conn = paused->head; conn && n < 64; conn = conn->paused_next) {
+            funcs[n] = thread_pool_strand_run;
+            args[n] = &conn->strand;
+            n++;
+        }
+        int submitted = thread_pool_add_tasks(pool, funcs, args, n);
+        for (int i = 0; i < submitted; i++) {
+            // 连接只会在Reactor主线程中释放，提交后仍可访问
+            connection_t* conn = paused->head;
+            paused->head = conn->paused_next;
+            paused->count--;
+            conn->paused = 0;
+            conn->paused_next = NULL;
+            fprintf(stderr, "resume fd=%d\n", conn->fd);
+        }
+        if (!paused->head) paused->tail = NULL;
+        if (submitted < n) return;
+    }
+}
+
+/**
+ * @brief 批量提交本轮收集的读写任务（一次入队、一次唤醒）
+ * @param batch 待提交任务
+ * @param pool 目标子线程池
+ * @param paused 该子线程池的暂停链表
+ * @note 任务先进入各连接的strand，取得调度令牌的strand汇总后一次提交（同一连接的读、写任务只调度一次）。
+ *       先重新提交之前被暂停的连接；仍有连接处于暂停状态时，本轮需要调度的strand直接排到暂停链表后面，
+ *       保证先暂停的连接先恢复。队列空间不足时，未被接收的strand对应的连接被暂停（不关闭）
+ */
+void dispatch_batch_flush(dispatch_batch_t* batch, thread_pool_t* pool, paused_list_t* paused) {
+    connection_resume(paused, pool);
+    if (batch->count == 0) return;
+
+    // 1. 投递到strand；取得令牌的strand原地压缩到batch前部（runnable ≤ i，不会覆盖未处理的元素）
+    int runnable = 0;
+    for (int i = 0; i < batch->count; i++) {
+        connection_t* conn = (connection_t*)batch->args[i];
+        int ret = thread_pool_strand_enqueue(&conn->strand, batch->funcs[i], conn);
+        if (ret == 1) {
+            batch->funcs[runnable] = thread_pool_strand_run;
+            batch->args[runnable] = &conn->strand;
+            runnable++;
+        } else if (ret < 0) {
+            fprintf(stderr, "add %s task failed, fd=%d\n",
+                    batch->funcs[i] == read_worker_task ? "read" : "write", conn->fd);
+        }
+    }
+
+    // 2. 批量调度
+    int submitted = 0;
+    if (!paused->head && runnable > 0) {
+        submitted = thread_pool_add_tasks(pool, batch->funcs, batch->args, runnable);
+        if (submitted < 0) submitted = 0;
+    }
+    for (int i = submitted; i < runnable; i++) {
+        connection_pause(paused, connection_of_strand((thread_pool_strand_t*)batch->args[i]));
+    }
+    batch->count = 0;
 }
 
 /**
@@ -363,11 +744,20 @@ void write_handler(int epoll_fd, connection_t* conn) {
  * @param epoll_fd epoll实例FD
  * @param events epoll事件数组
  * @param max_events 最大事件数
- * @note 仅负责事件监听和分发，耗时逻辑由线程池处理
+ * @note 仅负责事件监听和分发，耗时逻辑由线程池处理；一轮事件产生的任务批量提交
  */
 void reactor_loop(int epoll_fd, struct epoll_event* events, int max_events) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    time_t next_report = ts.tv_sec + STATS_INTERVAL_MS / 1000;
     while (global_running) {
-        int n = epoll_wait(epoll_fd, events, max_events, 1000); // 1秒超时
+        // 有被暂停或待释放的连接时缩短超时，没有新事件也能按时重试
+        int timeout = 1000; // 1秒超时
+        if (g_dying_conns || __atomic_load_n(&g_dead_conns, __ATOMIC_RELAXED)) timeout = PAUSE_RETRY_MS;
+        for (int node = 0; node < g_numa_pool->num_nodes; node++) {
+            if (g_paused_lists[node].count > 0) timeout = PAUSE_RETRY_MS;
+        }
+        int n = epoll_wait(epoll_fd, events, max_events, timeout);
         if (n < 0) {
             if (errno == EINTR) continue; // 信号中断，继续循环
             perror("epoll_wait");
@@ -376,7 +766,11 @@ void reactor_loop(int epoll_fd, struct epoll_event* events, int max_events) {
 
         // 遍历触发的事件，分发到对应处理函数
         for (int i = 0; i < n; i++) {
-            connection_t* conn = (connection_t*)events[i].data.ptr;
+            connection_t* conn = (connection_t*)conn_table_lookup(&g_conns, events[i].data.u64);
+            if (!conn) {
+                g_stale_events++; // 连接已释放（fd可能已被新连接复用）
+                continue;
+            }
             if (events[i].events & EPOLLIN) {
                 if (conn->read_handler) {
                     conn->read_handler(epoll_fd, conn);
@@ -388,6 +782,17 @@ void reactor_loop(int epoll_fd, struct epoll_event* events, int max_events) {
                 }
             }
         }
+        for (int node = 0; node < g_numa_pool->num_nodes; node++) {
+            dispatch_batch_flush(&g_dispatch_batches[node], g_numa_pool->pools[node], &g_paused_lists[node]);
+        }
+        connection_reap();
+
+        // 定期输出各子线程池的统计（epoll_wait最长1秒超时，间隔误差不超过1秒）
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        if (ts.tv_sec >= next_report) {
+            thread_pool_group_report(g_pools, stderr);
+            next_report = ts.tv_sec + STATS_INTERVAL_MS / 1000;
+        }
     }
 }
 
@@ -443,42 +848,93 @@ int main(int argc, char* argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    // 5. 创建监听连接结构体
-    connection_t* listen_conn = (connection_t*)malloc(sizeof(connection_t));
-    memset(listen_conn, 0, sizeof(connection_t));
-    listen_conn->fd = listen_fd;
-    listen_conn->read_handler = accept_handler;
-    listen_conn->write_handler = NULL;
+    // 5. 创建连接表（槽数取fd上限），监听连接也放在表中
+    if (conn_table_init(&g_conns, sizeof(connection_t), 0) < 0) {
+        perror("conn_table_init");
+        close(listen_fd);
+        close(epoll_fd);
+        exit(EXIT_FAILURE);
+    }
+    connection_t* listen_conn = connection_create(listen_fd, (struct sockaddr_in){0},
+                                                  accept_handler, NULL, CONN_ACCEPTING);
 
     // 6. 注册监听FD到epoll：EPOLLIN + ET + ONESHOT
-    if (epoll_add_fd(epoll_fd, listen_fd, listen_conn, EPOLLIN) < 0) {
+    if (!listen_conn || epoll_add_fd(epoll_fd, listen_fd, listen_conn, EPOLLIN) < 0) {
         perror("epoll_add_fd");
         close(listen_fd);
         close(epoll_fd);
         exit(EXIT_FAILURE);
     }
 
-    // 7. 创建线程池 根据cpu核心数
-    int threadNum = 8;
-    g_thread_pool = thread_pool_create(threadNum);
-    if (!g_thread_pool) {
+    // 7. 创建线程池：每个NUMA节点一个子线程池，线程绑定在节点内
+    //    （弹性模式：常驻节点CPU数个线程，排队过久时最多扩容到2倍）
+    thread_pool_config_t pool_cfg;
+    thread_pool_config_init(&pool_cfg);
+    //    队列满时直接拒绝（Reactor主线程不能阻塞，也不能自己做I/O），由Reactor暂停对应连接
+    pool_cfg.min_threads = 0;
+    pool_cfg.max_threads = 0;
+    pool_cfg.overflow_policy = OVERFLOW_REJECT;
+    g_numa_pool = numa_thread_pool_create(&pool_cfg);
+    if (g_numa_pool) {
+        g_dispatch_batches = (dispatch_batch_t*)calloc(g_numa_pool->num_nodes, sizeof(dispatch_batch_t));
+        g_paused_lists = (paused_list_t*)calloc(g_numa_pool->num_nodes, sizeof(paused_list_t));
+    }
+    if (!g_numa_pool || !g_dispatch_batches || !g_paused_lists) {
         fprintf(stderr, "create thread pool failed\n");
         close(listen_fd);
         close(epoll_fd);
         exit(EXIT_FAILURE);
     }
 
+    // 8. 命名子线程池：各节点的子线程池登记为 "cpu"（多节点时为 "cpu.N"），
+    //    另建固定线程数的 "io-blocking" 给阻塞型请求（不自旋：任务本身就在睡眠）
+    g_pools = thread_pool_group_create();
+    if (g_pools) {
+        for (int node = 0; node < g_numa_pool->num_nodes; node++) {
+            char name[THREAD_POOL_NAME_LEN];
+            if (g_numa_pool->num_nodes == 1) {
+                snprintf(name, sizeof(name), "cpu");
+            } else {
+                snprintf(name, sizeof(name), "cpu.%d", g_numa_pool->nodes[node]);
+            }
+            thread_pool_group_attach(g_pools, name, g_numa_pool->pools[node]);
+        }
+        thread_pool_config_t blocking_cfg;
+        thread_pool_config_init(&blocking_cfg);
+        blocking_cfg.min_threads = IO_BLOCKING_THREADS;
+        blocking_cfg.max_threads = IO_BLOCKING_THREADS;
+        blocking_cfg.max_task = IO_BLOCKING_QUEUE;
+        blocking_cfg.overflow_policy = OVERFLOW_REJECT;
+        blocking_cfg.idle_spin_us = 0;
+        g_blocking_pool = thread_pool_group_add(g_pools, "io-blocking", &blocking_cfg);
+    }
+    if (!g_pools || g_blocking_pool < 0) {
+        fprintf(stderr, "create io-blocking pool failed\n");
+        close(listen_fd);
+        close(epoll_fd);
+        exit(EXIT_FAILURE);
+    }
+
     struct epoll_event events[MAX_EVENTS];
     memset(events, 0, sizeof(events));
     printf("Server listening on port %d (Reactor+ThreadPool, ET+ONESHOT)\n", port);
 
-    // 7. 启动Reactor事件循环
+    // 9. 启动Reactor事件循环
     reactor_loop(epoll_fd, events, MAX_EVENTS);
 
-    // 8. 资源清理
+    // 10. 资源清理
     close(listen_fd);
     close(epoll_fd);
-    free(listen_conn);
+    free(g_dispatch_batches);
+    free(g_paused_lists);
+    // 释放连接表中的缓冲区（线程池已在信号处理中停止）
+    for (int fd = 0; fd <= g_conns.max_fd; fd++) {
+        connection_t* conn = (connection_t*)conn_table_slot(&g_conns, fd);
+        iobuf_free(&conn->in);
+        outq_free(&conn->out);
+    }
+    conn_table_destroy(&g_conns);
+    if (g_stale_events > 0) printf("stale events dropped: %llu\n", g_stale_events);
 
     printf("End.\n");
     return 0;
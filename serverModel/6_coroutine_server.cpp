@@ -0,0 +1,122 @@
+// 6_coroutine_server.cpp
+// C++20协程 + epoll就绪通知 + 线程池 的 echo server
+// 编译: g++ -std=c++20 -O2 6_coroutine_server.cpp -o server -pthread
+// 运行: ./server [port]
+// 说明:
+//  - 每个连接一个协程，按顺序写 读 -> 打印 -> 回写，不需要拆成回调/状态机
+//  - socket为非阻塞：操作先直接尝试，返回EAGAIN时协程挂起，IoContext的epoll线程在就绪后
+//    把协程交给线程池恢复，worker线程不会阻塞在I/O上
+//  - 协程帧由FramePool分配（线程本地空闲链表），连接的建立/关闭不经过malloc
+//  - Ctrl+C：停止IoContext（挂起的协程以ECANCELED恢复并结束），再关闭线程池
+
+#include <cstdio>
+#include <csignal>
+#include <cstdlib>
+#include <arpa/inet.h>
+#include "0_coroutine.hpp"
+
+const uint16_t Port = 13145;
+const size_t BufferSize = 1024;
+
+/**
+ * @brief 处理一个连接：读到什么回写什么，直到对端关闭或出错
+ */
+CoTask<void> handleClient(IoContext& io, int clientFd, sockaddr_in clientAddr) {
+    AsyncSocket sock(io, clientFd);
+    char ipStr[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &clientAddr.sin_addr, ipStr, INET_ADDRSTRLEN);
+    uint16_t port = ntohs(clientAddr.sin_port);
+    printf("[%s:%d] has been connected.\n", ipStr, port);
+
+    char buffer[BufferSize];
+    while (true) {
+        ssize_t n = co_await sock.async_read(buffer, BufferSize - 1);
+        if (n == 0) {
+            printf("[%s:%d] has been disconnected.\n", ipStr, port);
+            break;
+        }
+        if (n < 0) {
+            if (n != -ECANCELED) fprintf(stderr, "[%s:%d] recv: %s\n", ipStr, port, strerror(static_cast<int>(-n)));
+            break;
+        }
+        buffer[n] = '\0';
+        printf("[%s:%d][Thread %zu]: %s\n", ipStr, port,
+               std::hash<std::thread::id>()(std::this_thread::get_id()), buffer);
+        ssize_t sent = co_await sock.async_write(buffer, static_cast<size_t>(n));
+        if (sent < 0) {
+            if (sent != -ECANCELED) fprintf(stderr, "[%s:%d] send: %s\n", ipStr, port, strerror(static_cast<int>(-sent)));
+            break;
+        }
+    }
+}
+
+/**
+ * @brief 接受连接，每个连接启动一个分离的处理协程
+ */
+CoTask<void> acceptLoop(IoContext& io, AsyncSocket& listener) {
+    while (true) {
+        sockaddr_in clientAddr{};
+        int clientFd = co_await listener.async_accept(&clientAddr);
+        if (clientFd == -ECANCELED) break;
+        if (clientFd < 0) {
+            fprintf(stderr, "accept: %s\n", strerror(-clientFd));
+            continue;
+        }
+        co_spawn(io.pool(), handleClient(io, clientFd, clientAddr));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint16_t port = argc >= 2 ? static_cast<uint16_t>(atoi(argv[1])) : Port;
+
+    int serverFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (serverFd < 0) {
+        perror("Server socket.");
+        exit(1);
+    }
+
+    int opt = 1;
+    setsockopt(serverFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    sockaddr_in serverAddr{};
+    serverAddr.sin_addr.s_addr = INADDR_ANY;
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(port);
+
+    if (bind(serverFd, (sockaddr*)&serverAddr, sizeof(serverAddr)) == -1) {
+        perror("bind.");
+        close(serverFd);
+        exit(1);
+    }
+
+    if (listen(serverFd, SOMAXCONN) == -1) {
+        perror("listen.");
+        close(serverFd);
+        exit(1);
+    }
+    printf("Server is listening on port %d (coroutines).\n", port);
+
+    // 先屏蔽SIGINT/SIGTERM再创建线程（线程继承信号掩码），由主线程sigwait等待退出信号
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    size_t numCores = std::thread::hardware_concurrency();
+    if (numCores == 0) numCores = 4;
+    ThreadPool threadPool(numCores, 1024);
+    IoContext io(threadPool);
+    AsyncSocket listener(io, serverFd);
+    co_spawn(threadPool, acceptLoop(io, listener));
+
+    int sig = 0;
+    sigwait(&signals, &sig);
+    printf("\nSignal %d received, shutting down...\n", sig);
+
+    io.stop();              // 挂起的协程以ECANCELED恢复
+    threadPool.shudown();   // 等待它们结束
+    listener.close();
+    std::cout << "End.\n";
+    return 0;
+}